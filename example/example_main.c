@@ -21,6 +21,8 @@ void test ( void )
     
     LOGGER_FATAL("This is a fatal");
     
+    LOGGER_FIELDS(LOGGER_LEVEL_INFO, "This has fields", LOGGER_KV_INT("answer", 42), LOGGER_KV_STR("path", "/tmp"));
+    
     LOGGER_EXIT;
     
     /* destroy _loggerHandle */
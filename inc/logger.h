@@ -57,12 +57,401 @@ typedef enum _LOGGER_LEVEL
 } LOGGER_LEVEL;
 
 
+/**
+ @def LOGGER_LEVEL_ALL
+ @brief every #LOGGER_LEVEL or'ed together
+ */
+#define LOGGER_LEVEL_ALL ( LOGGER_LEVEL_ENTRY | LOGGER_LEVEL_EXIT | LOGGER_LEVEL_TRACE | LOGGER_LEVEL_INFO | LOGGER_LEVEL_WARN | \
+                           LOGGER_LEVEL_ERROR | LOGGER_LEVEL_FATAL | LOGGER_LEVEL_ASSERT | LOGGER_LEVEL_EVENT )
+
+
+/**
+ @def LOGGER_COMPILE_LEVEL_MASK
+ @brief levels compiled into the binary. Define before including this header (or on the compiler command line) to
+ remove callsites entirely e.g. -DLOGGER_COMPILE_LEVEL_MASK="(LOGGER_LEVEL_ALL & ~(LOGGER_LEVEL_ENTRY|LOGGER_LEVEL_EXIT))" \n
+ Excluded #LOGGER_PRINT_ENTRY etc expand to a constant-false branch: the arguments are still type-checked but never
+ evaluated & the compiler drops the call. Levels left in can still be switched off at runtime
+ */
+#ifndef LOGGER_COMPILE_LEVEL_MASK
+#define LOGGER_COMPILE_LEVEL_MASK LOGGER_LEVEL_ALL
+#endif
+
+
+/**
+ @def LOGGER_LEVEL_IS_COMPILED
+ @brief compile time constant, non-zero if level is part of #LOGGER_COMPILE_LEVEL_MASK
+ */
+#define LOGGER_LEVEL_IS_COMPILED(level) ( ( (LOGGER_COMPILE_LEVEL_MASK) & (level) ) != 0 )
+
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LOGGER_PRINTF_CHECK(fmtIndex, argIndex) __attribute__((format(printf, fmtIndex, argIndex)))
+#else
+#define LOGGER_PRINTF_CHECK(fmtIndex, argIndex)
+#endif
+
+
+/**
+ @def LOGGER_PRINT_IS_ENABLED
+ @brief guard used by the print macros. Compiled-out levels fold to false, otherwise the handle's level words are
+ tested inline so prints neither output nor recorded never evaluate their arguments. hdl is evaluated twice
+ */
+#define LOGGER_PRINT_IS_ENABLED(hdl, level) \
+    ( LOGGER_LEVEL_IS_COMPILED(level) && loggerIsDebugLevelWanted_inline((hdl), (level)) )
+
+
 #define LOGGER_OUTPUT_HANDLE void*
 
 
 #define LOGGER_OUTPUT_HANDLE_INVALID (NULL)
 
 
+/**
+ @def LOGGER_LEVELS_CAPTURE_SHIFT
+ @brief bit position of the capture mask within #LOGGER_HANDLE_PUBLIC loggerLevels
+ */
+#define LOGGER_LEVELS_CAPTURE_SHIFT (16U)
+
+
+/**
+ @brief leading members of every #LOGGER_OUTPUT_HANDLE
+ @details exposed only so the print macros can test levels without a function call. Treat as read-only,
+ use #loggerAppendDebugLevel / #loggerRemoveDebugLevel to change levels & #loggerSetCaptureLevel to change
+ what the flight recorder keeps. \n
+ Both masks share one word so the level test is a single relaxed atomic load. Print macros with a static callsite
+ first load the callsite's control word, see #loggerIsCallsiteWanted_inline, so take two. A change is made with one
+ atomic read-modify-write: concurrent changes never lose each other's bits & a print sees the word either before
+ or after a change, never part of one. A print ordered after the changing call (by a mutex, thread join or
+ other synchronisation) sees the change, any other print sees it as soon as the store reaches its core - on
+ cache-coherent hardware that is the next load after the store drains, well under a microsecond
+ */
+typedef struct _LOGGER_HANDLE_PUBLIC
+{
+    uint32_t loggerLevels;  /* emit mask, levels sent to the output, in the low half. Capture mask, levels kept
+                               by the flight recorder, from #LOGGER_LEVELS_CAPTURE_SHIFT. Accessed atomically */
+} LOGGER_HANDLE_PUBLIC;
+
+
+/**
+ @enum _LOGGER_KV_TYPE
+ @brief type of a structured field value, see #LOGGER_KV
+ */
+typedef enum _LOGGER_KV_TYPE
+{
+    LOGGER_KV_TYPE_INT = 1,
+    LOGGER_KV_TYPE_UINT,
+    LOGGER_KV_TYPE_DOUBLE,
+    LOGGER_KV_TYPE_BOOL,
+    LOGGER_KV_TYPE_STR,
+} LOGGER_KV_TYPE;
+
+
+/**
+ @brief one structured field of a #logPrintKV record
+ @details build with #LOGGER_KV_INT, #LOGGER_KV_UINT, #LOGGER_KV_DOUBLE, #LOGGER_KV_BOOL or #LOGGER_KV_STR. Values are
+ stored raw with the record & only turned into text by the output. Keys longer than 255 chars are cut short
+ */
+typedef struct _LOGGER_KV
+{
+    const char * key;
+    LOGGER_KV_TYPE type;
+    union
+    {
+        int64_t i;
+        uint64_t u;
+        double d;
+        bool b;
+        const char * s;     /* NULL is output as an empty string */
+    } value;
+} LOGGER_KV;
+
+
+static inline LOGGER_KV loggerKvInt ( const char * key, int64_t value )
+{
+    LOGGER_KV kv;
+    kv.key = key;
+    kv.type = LOGGER_KV_TYPE_INT;
+    kv.value.i = value;
+    return kv;
+}
+
+static inline LOGGER_KV loggerKvUint ( const char * key, uint64_t value )
+{
+    LOGGER_KV kv;
+    kv.key = key;
+    kv.type = LOGGER_KV_TYPE_UINT;
+    kv.value.u = value;
+    return kv;
+}
+
+static inline LOGGER_KV loggerKvDouble ( const char * key, double value )
+{
+    LOGGER_KV kv;
+    kv.key = key;
+    kv.type = LOGGER_KV_TYPE_DOUBLE;
+    kv.value.d = value;
+    return kv;
+}
+
+static inline LOGGER_KV loggerKvBool ( const char * key, bool value )
+{
+    LOGGER_KV kv;
+    kv.key = key;
+    kv.type = LOGGER_KV_TYPE_BOOL;
+    kv.value.b = value;
+    return kv;
+}
+
+static inline LOGGER_KV loggerKvStr ( const char * key, const char * value )
+{
+    LOGGER_KV kv;
+    kv.key = key;
+    kv.type = LOGGER_KV_TYPE_STR;
+    kv.value.s = value;
+    return kv;
+}
+
+
+/**
+ @def LOGGER_KV_INT
+ @brief signed integer field
+ */
+#define LOGGER_KV_INT(key, value) loggerKvInt((key), (int64_t)(value))
+
+/**
+ @def LOGGER_KV_UINT
+ @brief unsigned integer field
+ */
+#define LOGGER_KV_UINT(key, value) loggerKvUint((key), (uint64_t)(value))
+
+/**
+ @def LOGGER_KV_DOUBLE
+ @brief floating point field
+ */
+#define LOGGER_KV_DOUBLE(key, value) loggerKvDouble((key), (double)(value))
+
+/**
+ @def LOGGER_KV_BOOL
+ @brief true/false field
+ */
+#define LOGGER_KV_BOOL(key, value) loggerKvBool((key), ( (value) ? true : false ))
+
+/**
+ @def LOGGER_KV_STR
+ @brief string field, copied into the record
+ */
+#define LOGGER_KV_STR(key, value) loggerKvStr((key), (value))
+
+
+/**
+ @brief bytes currently held by the logger, see #loggerGetMemoryUsage
+ */
+typedef struct _LOGGER_MEMORY_USAGE
+{
+    size_t heapBytes;       /* handles, queues & per-thread capture buffers */
+    size_t configBytes;     /* settings parsed from the ini file */
+    size_t scratchBytes;    /* per-thread arenas for records & other transient buffers, all threads */
+    size_t peakBytes;       /* highest total of the above since startup */
+} LOGGER_MEMORY_USAGE;
+
+
+/**
+ @def LOGGER_STATS_LEVELS
+ @brief number of per level counters in #LOGGER_STATS, one per level bit: records[0] is #LOGGER_LEVEL_ENTRY,
+ records[8] is #LOGGER_LEVEL_EVENT
+ */
+#define LOGGER_STATS_LEVELS (9U)
+
+/**
+ @def LOGGER_STATS_LATENCY_BUCKETS
+ @brief number of log2 buckets in the #LOGGER_STATS latency histogram
+ */
+#define LOGGER_STATS_LATENCY_BUCKETS (32U)
+
+/**
+ @def LOGGER_STATS_OUTPUTS_MAX
+ @brief most outputs #LOGGER_STATS reports on
+ */
+#define LOGGER_STATS_OUTPUTS_MAX (8U)
+
+
+/**
+ @brief what one output has been handed, see #LOGGER_STATS
+ */
+typedef struct _LOGGER_STATS_OUTPUT
+{
+    const char * name;      /* plugin name, NULL for an output never started */
+    uint64_t records;       /* records sent */
+    uint64_t bytes;         /* bytes handed to the plugin */
+    uint64_t failures;      /* sends the plugin reported as failed */
+} LOGGER_STATS_OUTPUT;
+
+
+/**
+ @brief counters of everything the logger has done since startup, see #loggerGetStats
+ @details each thread counts into its own block & the blocks are summed when read, so a snapshot taken while other
+ threads print may be a few records behind. Calls removed by a level test inlined at the callsite never reach the
+ logger & are not counted
+ */
+typedef struct _LOGGER_STATS
+{
+    uint64_t records[LOGGER_STATS_LEVELS];  /* records accepted for output, by level bit */
+    uint64_t filtered;                      /* print calls whose level was disabled */
+    uint64_t rateLimited;                   /* records suppressed by a callsite rate limit */
+    uint64_t deduplicated;                  /* repeats held back by dedup= */
+    uint64_t truncated;                     /* records cut short */
+    uint64_t dropped;                       /* records dropped by backpressure= while a queue was full */
+    uint64_t sendFailures;                  /* failed sends, all outputs */
+    uint64_t latency[LOGGER_STATS_LATENCY_BUCKETS]; /* print call wall time with latency=true, else all 0:
+                                                       bucket i counts calls of [2^i, 2^(i+1)) ns, the last bucket
+                                                       everything longer */
+    uint32_t outputCount;                   /* entries of outputs filled */
+    LOGGER_STATS_OUTPUT outputs[LOGGER_STATS_OUTPUTS_MAX];
+    LOGGER_MEMORY_USAGE memory;             /* as #loggerGetMemoryUsage */
+} LOGGER_STATS;
+
+
+/**
+ @brief Check whether a logger level is enabled, inlined into the caller
+ @details same result as #loggerIsDebugLevelEnabled but costs a load, test & branch instead of a call
+ @param[in] handle Debug handle (may be #LOGGER_OUTPUT_HANDLE_INVALID)
+ @param[in] isLevel logger level(s) to be checked
+ @return returns #true if any logger level in isLevel is currently enabled
+ */
+static inline bool loggerIsDebugLevelEnabled_inline ( LOGGER_OUTPUT_HANDLE handle, LOGGER_LEVEL isLevel )
+{
+    return ( handle != LOGGER_OUTPUT_HANDLE_INVALID ) &&
+           ( ( __atomic_load_n(&((const LOGGER_HANDLE_PUBLIC *)handle)->loggerLevels, __ATOMIC_RELAXED) &
+               (uint32_t)isLevel ) != 0U );
+}
+
+
+/**
+ @brief Check whether a print at a logger level has anything to do, inlined into the caller
+ @details #true if the level is output or kept by the flight recorder
+ @param[in] handle Debug handle (may be #LOGGER_OUTPUT_HANDLE_INVALID)
+ @param[in] isLevel logger level(s) to be checked
+ @return returns #true if any logger level in isLevel is currently enabled or captured
+ */
+static inline bool loggerIsDebugLevelWanted_inline ( LOGGER_OUTPUT_HANDLE handle, LOGGER_LEVEL isLevel )
+{
+    return ( handle != LOGGER_OUTPUT_HANDLE_INVALID ) &&
+           ( ( __atomic_load_n(&((const LOGGER_HANDLE_PUBLIC *)handle)->loggerLevels, __ATOMIC_RELAXED) &
+               ( (uint32_t)isLevel | ( (uint32_t)isLevel << LOGGER_LEVELS_CAPTURE_SHIFT ) ) ) != 0U );
+}
+
+
+/**
+ @enum _LOGGER_CALLSITE_CONTROL
+ @brief runtime switch of a single print statement, see #loggerControlCallsites \n
+ #LOGGER_CALLSITE_DEFAULT printed when its level is enabled on the handle \n
+ #LOGGER_CALLSITE_ENABLED always printed, whatever the handle's levels \n
+ #LOGGER_CALLSITE_DISABLED never printed nor captured
+ */
+typedef enum _LOGGER_CALLSITE_CONTROL
+{
+    LOGGER_CALLSITE_DEFAULT = 0,
+    LOGGER_CALLSITE_ENABLED,
+    LOGGER_CALLSITE_DISABLED,
+} LOGGER_CALLSITE_CONTROL;
+
+
+/**
+ @brief static description of one print statement
+ @details declared by the print macros, one per callsite, so the file, line & function are only turned into text
+ once. The address identifies the callsite for the life of the process
+ */
+typedef struct _LOGGER_CALLSITE
+{
+    const char * fileName;
+    const char * functionName;
+    int lineNumber;
+    LOGGER_LEVEL level;
+    const char * format;        /* the format when a string literal, NULL otherwise. See #LOGGER_FORMAT_LITERAL */
+    uint32_t rateCount;         /* records allowed per rateIntervalMs, 0 to use the ini [ratelimit] setting */
+    uint32_t rateIntervalMs;
+    void * resolved;    /* library private, NULL until the first print */
+    uint32_t control;   /* #LOGGER_CALLSITE_CONTROL, read atomically */
+} LOGGER_CALLSITE;
+
+
+/**
+ @def LOGGER_FORMAT_LITERAL
+ @brief format when it is a string literal, NULL otherwise. Usable in a static initializer
+ @details only a literal outlives the print call, so only a callsite with one may have its formatting deferred.
+ NULL on compilers without __builtin_constant_p, every record is then formatted inline
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define LOGGER_FORMAT_LITERAL(format) ( __builtin_constant_p(format) ? (format) : (const char *)NULL )
+#else
+#define LOGGER_FORMAT_LITERAL(format) ( (const char *)NULL )
+#endif
+
+
+/**
+ @def LOGGER_CALLSITE_INIT
+ @brief static initializer for a #LOGGER_CALLSITE at the current source location
+ @param[in] level one #LOGGER_LEVEL
+ @param[in] format format of the print statement, kept when it is a string literal
+ */
+#define LOGGER_CALLSITE_INIT(level, format) { __FILE__, __FUNCTION__, __LINE__, (level), LOGGER_FORMAT_LITERAL(format), 0U, 0U, NULL, LOGGER_CALLSITE_DEFAULT }
+
+
+/**
+ @def LOGGER_CALLSITE_INIT_LIMITED
+ @brief as #LOGGER_CALLSITE_INIT, printing at most count records per intervalMs. Both must be constants
+ */
+#define LOGGER_CALLSITE_INIT_LIMITED(level, format, count, intervalMs) { __FILE__, __FUNCTION__, __LINE__, (level), LOGGER_FORMAT_LITERAL(format), (count), (intervalMs), NULL, LOGGER_CALLSITE_DEFAULT }
+
+
+/**
+ @def LOGGER_CALLSITE_REGISTER
+ @brief list a static callsite so #loggerControlCallsites finds it before it has printed
+ @details GCC & clang ELF builds keep a pointer to each callsite in the logger_callsites section, NULL when the
+ level is compiled out. Elsewhere, inside C++ templates (GCC drops the section there) & for callsites in other
+ shared objects, a callsite is listed once it prints
+ */
+#if defined(__ELF__) && ( defined(__GNUC__) || defined(__clang__) )
+#define LOGGER_CALLSITE_REGISTER(callsite, level) \
+    static LOGGER_CALLSITE * loggerCallsiteEntry __attribute__((section("logger_callsites"), used)) = \
+        ( LOGGER_LEVEL_IS_COMPILED(level) ? &(callsite) : NULL )
+#else
+#define LOGGER_CALLSITE_REGISTER(callsite, level) do { } while (0)
+#endif
+
+
+/**
+ @brief Check whether a print statement is wanted, inlined into the caller
+ @details two relaxed loads: the callsite's control word, then, only when it is #LOGGER_CALLSITE_DEFAULT, the
+ handle's level word. The words are independent, a print racing both #loggerControlCallsites & a level change may
+ see either change without the other. Each change on its own is seen whole, as described for #LOGGER_HANDLE_PUBLIC
+ @param[in] handle Debug handle
+ @param[in] callsite static callsite
+ @param[in] level level of the callsite, a constant so the test folds
+ @return returns #true if the callsite should be printed or captured
+ */
+static inline bool loggerIsCallsiteWanted_inline ( LOGGER_OUTPUT_HANDLE handle, const LOGGER_CALLSITE * callsite, LOGGER_LEVEL level )
+{
+    uint32_t control = __atomic_load_n(&callsite->control, __ATOMIC_RELAXED);
+    
+    if ( control == (uint32_t)LOGGER_CALLSITE_DEFAULT )
+    {
+        return loggerIsDebugLevelWanted_inline(handle, level);
+    }
+    
+    return ( control == (uint32_t)LOGGER_CALLSITE_ENABLED ) && ( handle != LOGGER_OUTPUT_HANDLE_INVALID );
+}
+
+
+/**
+ @def LOGGER_CALLSITE_IS_ENABLED
+ @brief guard used by the print macros, as #LOGGER_PRINT_IS_ENABLED with the callsite's own switch
+ @details one more load than #LOGGER_PRINT_IS_ENABLED, the callsite's control word is read before the handle's
+ */
+#define LOGGER_CALLSITE_IS_ENABLED(hdl, callsite, level) \
+    ( LOGGER_LEVEL_IS_COMPILED(level) && loggerIsCallsiteWanted_inline((hdl), &(callsite), (level)) )
+
+
 #ifdef LOGGER_ENABLE_TRACE
 /**
  @brief Initialize a logger handle with a string of chars. (Use the trace version to track logger handles created that aren't released)
@@ -135,8 +524,21 @@ void loggerSetSeverityEnablements_Default ( LOGGER_LEVEL loggerLevel );
 bool loggerLoadIniFile ( char * filePath, size_t filePathLen );
 
 
+/**
+ @brief Read the ini file given to #loggerLoadIniFile again & apply it to every handle from #loggerInitFromFileName
+ @details the file is parsed on the calling thread & swapped in whole, printing threads never wait for it. Each
+ handle's levels are set again from [overrides], its captured levels from [capture] & its output from
+ [bindings], replacing any changed at runtime. Output & [ratelimit] settings are only read when an output or handle is created. Handles from
+ #loggerInit keep their levels. Called by the watcher thread when the output section has ini_watch=true
+ @retval #true success
+ @retval #false the file could not be read, the current settings are kept
+ */
+bool loggerReloadIniFile ( void );
+
+
 /**
  @brief Enable logger level
+ @details safe while other threads print with handle, see #LOGGER_HANDLE_PUBLIC for when they see the change
  @param[in] handle Debug handle
  @param[in] addLevel logger level(s) to be enabled
  @return returns #true on success
@@ -146,6 +548,7 @@ bool loggerAppendDebugLevel ( LOGGER_OUTPUT_HANDLE handle, LOGGER_LEVEL addLevel
 
 /**
  @brief Disable logger level
+ @details safe while other threads print with handle, see #LOGGER_HANDLE_PUBLIC for when they see the change
  @param[in] handle Debug handle
  @param[in] rmLevel logger level(s) to be disabled
  @return returns #true on print success
@@ -162,8 +565,43 @@ bool loggerRemoveDebugLevel ( LOGGER_OUTPUT_HANDLE handle, LOGGER_LEVEL rmLevel
 bool loggerIsDebugLevelEnabled ( LOGGER_OUTPUT_HANDLE handle, LOGGER_LEVEL isLevel );
 
 
+/**
+ @brief Set the logger levels the flight recorder keeps for a handle
+ @details the capture mask is separate from the enabled levels, a captured level that is not enabled costs a
+ binary copy of the arguments & is only formatted if dumped. Has no effect while the flight recorder is off,
+ see the recorder= ini key. Handles start capturing #LOGGER_LEVEL_ALL, or the levels given for their file in
+ the ini [capture] section
+ @param[in] handle Debug handle
+ @param[in] captureLevel logger level(s) to be captured, replaces the previous set
+ @return returns #true on success
+ */
+bool loggerSetCaptureLevel ( LOGGER_OUTPUT_HANDLE handle, LOGGER_LEVEL captureLevel );
+
+
+/**
+ @brief Send a handle's records only to the output whose ini section has name=outputName
+ @details e.g. audit records to their own file. An output with a name= is sent records of the handles bound to
+ it & no others, the outputs without one take the records of every unbound handle. Handles from
+ #loggerInitFromFileName are bound by the ini [bindings] section, basename=outputname
+ @param[in] handle Debug handle
+ @param[in] outputName name= of a started output, NULL to unbind
+ @return returns #true on success, #false when no output has that name & the binding is left unchanged
+ */
+bool loggerBindOutput ( LOGGER_OUTPUT_HANDLE handle, const char * outputName );
+
+
+/**
+ @brief Output what the flight recorder holds
+ @details every thread's records since the last dump are sent oldest first, between two notes giving their
+ count. Called automatically after a #LOGGER_LEVEL_FATAL or #LOGGER_LEVEL_ASSERT print
+ @return returns the number of records dumped
+ */
+uint32_t loggerDumpFlightRecorder ( void );
+
+
 /**
  @brief Print a message
+ @details not kept by the flight recorder, which needs a static callsite
  @param[in] handle Debug handle
  @param[in] loggerLevel Debug level of which to print at. Only one value from #LOGGER_LEVEL must be present
  @param[in] fileName name of file of which logger print occured
@@ -179,7 +617,76 @@ bool logPrint ( LOGGER_OUTPUT_HANDLE handle,
                  const int lineNumber,
                  const char * functionName,
                  const char * fmt, 
-                 ... );
+                 ... ) LOGGER_PRINTF_CHECK(6, 7);
+
+
+/**
+ @brief Print a message from a static callsite
+ @details used by the print macros. The callsite's fields are rendered on first use & reused by every later print.
+ With binary=true the format is read after the call returns, so formatting is only deferred when fmt is the
+ callsite's own literal format. Any other fmt, e.g. one built in a buffer, is formatted before the call returns
+ @param[in] handle Debug handle
+ @param[in] callsite static descriptor of the print statement, see #LOGGER_CALLSITE_INIT. Must outlive the logger
+ @param[in] fmt message format, need not outlive the call
+ @param[in] ... vargs
+ @return returns #true on print success
+ */
+bool logPrintCallsite ( LOGGER_OUTPUT_HANDLE handle,
+                        LOGGER_CALLSITE * callsite,
+                        const char * fmt,
+                        ... ) LOGGER_PRINTF_CHECK(3, 4);
+
+
+/**
+ @brief Print a message with structured fields from a static callsite
+ @details used by #LOGGER_PRINT_FIELDS. Field values are copied into the record in binary form & rendered by the
+ output as text, JSON or binary, see the fields= ini key
+ @param[in] handle Debug handle
+ @param[in] callsite static descriptor of the print statement, see #LOGGER_CALLSITE_INIT. Must outlive the logger
+ @param[in] message fixed message text, not a format
+ @param[in] fields fieldCount fields
+ @param[in] fieldCount number of fields
+ @return returns #true on print success
+ */
+bool logPrintKV ( LOGGER_OUTPUT_HANDLE handle,
+                  LOGGER_CALLSITE * callsite,
+                  const char * message,
+                  const LOGGER_KV * fields,
+                  uint32_t fieldCount );
+
+
+/**
+ @brief Switch matching print statements on or off at runtime
+ @details match is a space separated list of terms, a callsite must match all of them. An empty match selects
+ every callsite \n
+ file=glob[:line[-line]] source file, the glob is tried on the path as compiled & on its base name \n
+ func=glob function name \n
+ format=glob format string, or message of #LOGGER_PRINT_FIELDS. Only a string literal is known, see
+ #LOGGER_FORMAT_LITERAL \n
+ level=levels any of the levels, as in the ini e.g. level=tv \n
+ e.g. "file=net*.c:120-140 level=t" or "func=parse_* format=*retry*". Takes effect on the next print from any
+ thread. Callsites are found as described at #LOGGER_CALLSITE_REGISTER
+ @param[in] match terms selecting callsites
+ @param[in] control new setting of every callsite matched
+ @return number of callsites changed, 0 as well when match cannot be parsed
+ */
+uint32_t loggerControlCallsites ( const char * match, LOGGER_CALLSITE_CONTROL control );
+
+
+/**
+ @brief Read how much memory the logger holds
+ @param[out] usage filled with the current counters
+ */
+void loggerGetMemoryUsage ( LOGGER_MEMORY_USAGE * usage );
+
+
+/**
+ @brief Take a snapshot of the logger's counters
+ @details safe to call from any thread at any time, nothing a printing thread waits on is locked
+ @param[out] stats filled with the totals so far
+ @return returns #true on success
+ */
+bool loggerGetStats ( LOGGER_STATS * stats );
 
 
 /**
@@ -199,7 +706,12 @@ uint32_t loggerVersion (void );
 #define LOGGER_PRINT_ENTRY(hdl, format, ... ) \
 do \
 { \
-    logPrint (hdl, LOGGER_LEVEL_ENTRY, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__ ); \
+    static LOGGER_CALLSITE loggerCallsite = LOGGER_CALLSITE_INIT(LOGGER_LEVEL_ENTRY, format); \
+    LOGGER_CALLSITE_REGISTER(loggerCallsite, LOGGER_LEVEL_ENTRY); \
+    if ( LOGGER_CALLSITE_IS_ENABLED(hdl, loggerCallsite, LOGGER_LEVEL_ENTRY) ) \
+    { \
+        logPrintCallsite (hdl, &loggerCallsite, format, ##__VA_ARGS__ ); \
+    } \
 } while (0)
 
 
@@ -213,7 +725,12 @@ do \
 #define LOGGER_PRINT_EXIT(hdl, format, ... ) \
 do \
 { \
-    logPrint (hdl, LOGGER_LEVEL_EXIT, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__ ); \
+    static LOGGER_CALLSITE loggerCallsite = LOGGER_CALLSITE_INIT(LOGGER_LEVEL_EXIT, format); \
+    LOGGER_CALLSITE_REGISTER(loggerCallsite, LOGGER_LEVEL_EXIT); \
+    if ( LOGGER_CALLSITE_IS_ENABLED(hdl, loggerCallsite, LOGGER_LEVEL_EXIT) ) \
+    { \
+        logPrintCallsite (hdl, &loggerCallsite, format, ##__VA_ARGS__ ); \
+    } \
 } while (0)
 
 
@@ -227,7 +744,12 @@ do \
 #define LOGGER_PRINT_INFO(hdl, format, ... ) \
 do \
 { \
-    logPrint (hdl, LOGGER_LEVEL_INFO, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__ ); \
+    static LOGGER_CALLSITE loggerCallsite = LOGGER_CALLSITE_INIT(LOGGER_LEVEL_INFO, format); \
+    LOGGER_CALLSITE_REGISTER(loggerCallsite, LOGGER_LEVEL_INFO); \
+    if ( LOGGER_CALLSITE_IS_ENABLED(hdl, loggerCallsite, LOGGER_LEVEL_INFO) ) \
+    { \
+        logPrintCallsite (hdl, &loggerCallsite, format, ##__VA_ARGS__ ); \
+    } \
 } while (0)
 
 
@@ -241,7 +763,12 @@ do \
 #define LOGGER_PRINT_WARN(hdl, format, ... ) \
 do \
 { \
-    logPrint (hdl, LOGGER_LEVEL_WARN, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__ ); \
+    static LOGGER_CALLSITE loggerCallsite = LOGGER_CALLSITE_INIT(LOGGER_LEVEL_WARN, format); \
+    LOGGER_CALLSITE_REGISTER(loggerCallsite, LOGGER_LEVEL_WARN); \
+    if ( LOGGER_CALLSITE_IS_ENABLED(hdl, loggerCallsite, LOGGER_LEVEL_WARN) ) \
+    { \
+        logPrintCallsite (hdl, &loggerCallsite, format, ##__VA_ARGS__ ); \
+    } \
 } while (0)
 
 
@@ -255,7 +782,12 @@ do \
 #define LOGGER_PRINT_ERROR(hdl, format, ... ) \
 do \
 { \
-    logPrint (hdl, LOGGER_LEVEL_ERROR, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__ ); \
+    static LOGGER_CALLSITE loggerCallsite = LOGGER_CALLSITE_INIT(LOGGER_LEVEL_ERROR, format); \
+    LOGGER_CALLSITE_REGISTER(loggerCallsite, LOGGER_LEVEL_ERROR); \
+    if ( LOGGER_CALLSITE_IS_ENABLED(hdl, loggerCallsite, LOGGER_LEVEL_ERROR) ) \
+    { \
+        logPrintCallsite (hdl, &loggerCallsite, format, ##__VA_ARGS__ ); \
+    } \
 } while (0)
 
 
@@ -269,7 +801,12 @@ do \
 #define LOGGER_PRINT_FATAL(hdl, format, ... ) \
 do \
 { \
-    logPrint (hdl, LOGGER_LEVEL_FATAL, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__ ); \
+    static LOGGER_CALLSITE loggerCallsite = LOGGER_CALLSITE_INIT(LOGGER_LEVEL_FATAL, format); \
+    LOGGER_CALLSITE_REGISTER(loggerCallsite, LOGGER_LEVEL_FATAL); \
+    if ( LOGGER_CALLSITE_IS_ENABLED(hdl, loggerCallsite, LOGGER_LEVEL_FATAL) ) \
+    { \
+        logPrintCallsite (hdl, &loggerCallsite, format, ##__VA_ARGS__ ); \
+    } \
 } while (0)
 
 
@@ -283,7 +820,12 @@ do \
 #define LOGGER_PRINT_ASSERT(hdl, format, ... ) \
 do \
 { \
-    logPrint (hdl, LOGGER_LEVEL_ASSERT, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__ ); \
+    static LOGGER_CALLSITE loggerCallsite = LOGGER_CALLSITE_INIT(LOGGER_LEVEL_ASSERT, format); \
+    LOGGER_CALLSITE_REGISTER(loggerCallsite, LOGGER_LEVEL_ASSERT); \
+    if ( LOGGER_CALLSITE_IS_ENABLED(hdl, loggerCallsite, LOGGER_LEVEL_ASSERT) ) \
+    { \
+        logPrintCallsite (hdl, &loggerCallsite, format, ##__VA_ARGS__ ); \
+    } \
 } while (0)
 
 
@@ -297,7 +839,58 @@ do \
 #define LOGGER_PRINT_EVENT(hdl, format, ... ) \
 do \
 { \
-    logPrint (hdl, LOGGER_LEVEL_EVENT, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__ ); \
+    static LOGGER_CALLSITE loggerCallsite = LOGGER_CALLSITE_INIT(LOGGER_LEVEL_EVENT, format); \
+    LOGGER_CALLSITE_REGISTER(loggerCallsite, LOGGER_LEVEL_EVENT); \
+    if ( LOGGER_CALLSITE_IS_ENABLED(hdl, loggerCallsite, LOGGER_LEVEL_EVENT) ) \
+    { \
+        logPrintCallsite (hdl, &loggerCallsite, format, ##__VA_ARGS__ ); \
+    } \
+} while (0)
+
+
+/**
+ @def LOGGER_PRINT_LIMITED
+ @brief print at most count messages per intervalMs from this callsite
+ @details uses a token bucket so bursts of up to count pass straight through. Once the bucket refills the next
+ record is preceded by a "suppressed N messages" record
+ @param[in] hdl handle
+ @param[in] level one #LOGGER_LEVEL, must be a constant
+ @param[in] count records allowed per interval, must be a constant
+ @param[in] intervalMs interval in milliseconds, must be a constant
+ @param[in] format message format
+ @param[in] vargs variable arguments
+ */
+#define LOGGER_PRINT_LIMITED(hdl, level, count, intervalMs, format, ... ) \
+do \
+{ \
+    static LOGGER_CALLSITE loggerCallsite = LOGGER_CALLSITE_INIT_LIMITED(level, format, count, intervalMs); \
+    LOGGER_CALLSITE_REGISTER(loggerCallsite, level); \
+    if ( LOGGER_CALLSITE_IS_ENABLED(hdl, loggerCallsite, level) ) \
+    { \
+        logPrintCallsite (hdl, &loggerCallsite, format, ##__VA_ARGS__ ); \
+    } \
+} while (0)
+
+
+/**
+ @def LOGGER_PRINT_FIELDS
+ @brief print a message with structured fields e.g.
+ LOGGER_PRINT_FIELDS(hdl, LOGGER_LEVEL_INFO, "login", LOGGER_KV_INT("user", id), LOGGER_KV_STR("path", p))
+ @param[in] hdl handle
+ @param[in] level one #LOGGER_LEVEL, must be a constant
+ @param[in] message fixed message text
+ @param[in] vargs one or more LOGGER_KV_* fields
+ */
+#define LOGGER_PRINT_FIELDS(hdl, level, message, ... ) \
+do \
+{ \
+    static LOGGER_CALLSITE loggerCallsite = LOGGER_CALLSITE_INIT(level, message); \
+    LOGGER_CALLSITE_REGISTER(loggerCallsite, level); \
+    if ( LOGGER_CALLSITE_IS_ENABLED(hdl, loggerCallsite, level) ) \
+    { \
+        const LOGGER_KV loggerFields[] = { __VA_ARGS__ }; \
+        logPrintKV (hdl, &loggerCallsite, message, loggerFields, (uint32_t)( sizeof(loggerFields) / sizeof(loggerFields[0]) ) ); \
+    } \
 } while (0)
 
 
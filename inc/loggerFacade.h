@@ -18,7 +18,7 @@ extern "C" {
 #endif
 
 
-/** comment line to disable logging */
+/** comment line to disable logging. To drop only some levels see #LOGGER_COMPILE_LEVEL_MASK */
 #define LOGGER_ENABLED
     
 
@@ -43,6 +43,8 @@ extern "C" {
 #define LOGGER_FATAL(format, ... ) LOGGER_PRINT_FATAL(_loggerHandle, format, ##__VA_ARGS__ )
 #define LOGGER_ASSERT(format, ... ) LOGGER_PRINT_ASSERT(_loggerHandle, format, ##__VA_ARGS__ )
 #define LOGGER_EVENT(format, ... ) LOGGER_PRINT_EVENT(_loggerHandle, format, ##__VA_ARGS__ )
+#define LOGGER_LIMITED(level, count, intervalMs, format, ... ) LOGGER_PRINT_LIMITED(_loggerHandle, level, count, intervalMs, format, ##__VA_ARGS__ )
+#define LOGGER_FIELDS(level, message, ... ) LOGGER_PRINT_FIELDS(_loggerHandle, level, message, __VA_ARGS__ )
 
 
 
@@ -313,6 +315,8 @@ do { \
 #define LOGGER_FATAL(format, ... )  {}
 #define LOGGER_ASSERT(format, ... )  {}
 #define LOGGER_EVENT(format, ... )  {}
+#define LOGGER_LIMITED(level, count, intervalMs, format, ... )  {}
+#define LOGGER_FIELDS(level, message, ... )  {}
 
 
 /* ASSERTIONS */
@@ -16,79 +16,421 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <pthread.h>
+#include <time.h>
 
 #include "logger.h"
 #include "logger_common.h"
 #include "logger_messageAssemble.h"
+#include "logger_clock.h"
 #include "logger_initTerm.h"
 #include "logger_levelManagement.h"
 #include "logger_stringUtil.h"
 #include "logger_ini.h"
+#include "logger_binary.h"
+#include "logger_callsite.h"
+#include "logger_dedup.h"
+#include "logger_memory.h"
+#include "logger_fields.h"
+#include "logger_metrics.h"
+#include "logger_registry.h"
 
 
 static LOGGER_LEVEL f_defaultLevel = LOGGER_LEVEL_WARN | LOGGER_LEVEL_ERROR | LOGGER_LEVEL_FATAL | LOGGER_LEVEL_EVENT;
 
+/* levels whose print is followed by a flight recorder dump */
+#define LOGGER_RECORDER_TRIGGER ( LOGGER_LEVEL_FATAL | LOGGER_LEVEL_ASSERT )
 
-static int logger_printLog ( char * msg, int msgSize, char * fileName, int lineNumber, char * functionName, LOGGER_LEVEL severity );
 
+static const LOGGER_CALLSITE_PRV * logger_recordHeader ( LOGGER_RECORD_BUILDER * builder, LOGGER_RECORD * record, const LOGGER_CALLSITE * callsite );
 
-static int logger_printLog ( char * msg, int msgSize, char * fileName, int lineNumber, char * functionName, LOGGER_LEVEL severity )
+static int logger_printLog ( const char * fmt, va_list args, const LOGGER_CALLSITE * callsite, uint32_t outputs );
+
+static int logger_printFields ( const LOGGER_CALLSITE * callsite, uint32_t outputs, const char * message, const LOGGER_KV * fields, uint32_t fieldCount );
+
+static LOGGER_STATUS logger_sendInOrder ( const LOGGER_CALLSITE * callsite, const LOGGER_RECORD * record );
+
+static bool logger_admitCallsite ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_CALLSITE * callsite );
+
+static bool logger_isCallsiteEnabled ( LOGGER_HANDLE_PRV * handlePrv, const LOGGER_CALLSITE * callsite );
+
+static int logger_printSummary ( const LOGGER_CALLSITE * callsite, uint32_t outputs, const char * fmt, ... ) LOGGER_PRINTF_CHECK(3, 4);
+
+static void logger_rateLimitFromIni ( LOGGER_HANDLE_PRV * handlePrv, char * baseName, size_t baseNameLen );
+
+static void logger_captureFromIni ( LOGGER_HANDLE_PRV * handlePrv, char * baseName, size_t baseNameLen );
+
+static void logger_bindingFromIni ( LOGGER_HANDLE_PRV * handlePrv );
+
+static void logger_levelsFromIni ( LOGGER_HANDLE_PRV * handlePrv );
+
+static void logger_reconfigureHandles ( void );
+
+static void logger_recorderTrigger ( LOGGER_LEVEL level );
+
+static void logger_recordCallsite ( const LOGGER_CALLSITE * callsite, uint32_t outputs, const char * fmt, va_list args );
+
+static void logger_recordText ( const LOGGER_CALLSITE * callsite, uint32_t outputs, const char * fmt, ... ) LOGGER_PRINTF_CHECK(3, 4);
+
+
+/* returns the resolved callsite, NULL when the header had to be written into the builder */
+static const LOGGER_CALLSITE_PRV * logger_recordHeader ( LOGGER_RECORD_BUILDER * builder, LOGGER_RECORD * record, const LOGGER_CALLSITE * callsite )
+{
+    const LOGGER_CALLSITE_PRV * resolved = logger_callsite_get( callsite );
+    
+    record->level = callsite->level;
+    
+    if ( resolved != NULL )
+    {
+        /* output straight from the callsite, never copied */
+        record->header = resolved->header;
+        record->headerLen = resolved->headerLen;
+    }
+    else
+    {
+        record->header = NULL;
+        record->headerLen = 0U;
+        logger_record_appendHeader( builder, callsite->fileName, callsite->lineNumber, callsite->functionName, callsite->level );
+    }
+    
+    return resolved;
+}
+
+static int logger_printLog ( const char * fmt, va_list args, const LOGGER_CALLSITE * callsite, uint32_t outputs )
+{
+    char completeMessage[LOGGER_RECORD_INLINE_SIZE];
+    LOGGER_RECORD_BUILDER builder;
+    LOGGER_RECORD record;
+    
+    /* only the raw clock is read here, the timestamp text is rendered at output */
+    record.ticks = logger_clock_now();
+    
+    /* each field is written once, in order, straight into the output buffer. Long messages continue in the
+       thread's scratch arena rather than being cut short */
+    logger_record_beginSpill( &builder, completeMessage, sizeof(completeMessage) );
+    
+    const LOGGER_CALLSITE_PRV * resolved = logger_recordHeader( &builder, &record, callsite );
+    
+    logger_record_appendFormatV( &builder, LOGGER_MESSAGE_MAX_SIZE, fmt, args );
+    
+    record.messageLen = logger_record_end( &builder );
+    record.message = builder.buffer;
+    record.fields = NULL;
+    record.fieldsLen = 0U;
+    record.outputs = outputs;
+    
+    if ( builder.truncated )
+    {
+        logger_metrics_truncated();
+    }
+    
+    int status = LOGGER_STATUS_OK;
+    bool held = false;
+    
+    /* only static callsites have an identity to compare against */
+    if ( ( resolved != NULL ) && logger_dedup_isEnabled() )
+    {
+        LOGGER_DEDUP_TABLE * table = logger_dedup_threadTable();
+        
+        held = ( table != NULL ) && ( logger_dedup_filter(table, callsite, &record) == false );
+    }
+    
+    if ( held == false )
+    {
+        status = logger_sendInOrder(callsite, &record);
+        
+        LOGPRINT_ASSERT(status==LOGGER_STATUS_OK);
+    }
+    else
+    {
+        logger_metrics_deduplicated();
+    }
+    
+    logger_record_release( &builder );
+    
+    return status;
+}
+
+/* the fields are copied in binary form, the output renders them */
+static int logger_printFields ( const LOGGER_CALLSITE * callsite, uint32_t outputs, const char * message, const LOGGER_KV * fields, uint32_t fieldCount )
+{
+    char completeMessage[LOGGER_RECORD_INLINE_SIZE];
+    LOGGER_RECORD_BUILDER builder;
+    LOGGER_RECORD record;
+    
+    record.ticks = logger_clock_now();
+    
+    logger_record_beginSpill( &builder, completeMessage, sizeof(completeMessage) );
+    
+    (void)logger_recordHeader( &builder, &record, callsite );
+    
+    logger_record_appendString( &builder, message, LOGGER_MESSAGE_MAX_SIZE );
+    
+    size_t messageLen = builder.length;
+    
+    /* encoded straight after the message, no number is turned into text on this thread */
+    logger_fields_encode( &builder, fields, fieldCount );
+    
+    size_t recordLen = logger_record_end( &builder );
+    
+    record.message = builder.buffer;
+    record.messageLen = messageLen;
+    record.fields = (const uint8_t *)&builder.buffer[messageLen];
+    record.fieldsLen = recordLen - messageLen;
+    record.outputs = outputs;
+    
+    if ( builder.truncated )
+    {
+        logger_metrics_truncated();
+    }
+    
+    /* not deduplicated, repeats are only compared on the message */
+    int status = logger_sendInOrder(callsite, &record);
+    
+    LOGPRINT_ASSERT(status==LOGGER_STATUS_OK);
+    
+    logger_record_release( &builder );
+    
+    return status;
+}
+
+/* a record formatted here while binary capture is on goes behind the thread's captured ones, the writer would
+   otherwise send it ahead of them */
+static LOGGER_STATUS logger_sendInOrder ( const LOGGER_CALLSITE * callsite, const LOGGER_RECORD * record )
+{
+    if ( logger_binary_isEnabled() && logger_binary_captureRecord(callsite, record) )
+    {
+        return LOGGER_STATUS_OK;
+    }
+    
+    return logger_sendRecord(record);
+}
+
+/* false when the callsite is over its rate. A pending count of suppressed records is printed first */
+static bool logger_admitCallsite ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_CALLSITE * callsite )
+{
+    /* renders file, line & function the first time this callsite prints */
+    LOGGER_CALLSITE_PRV * resolved = logger_callsite_resolve(callsite, handlePrv->rateCount, handlePrv->rateIntervalMs);
+    uint32_t suppressed = 0U;
+    
+    if ( ( resolved != NULL ) && ( logger_callsite_admit(resolved, &suppressed) == false ) )
+    {
+        /* over the callsite's rate, counted & reported with the next admitted record */
+        logger_metrics_rateLimited();
+        return false;
+    }
+    
+    if ( suppressed != 0U )
+    {
+        (void)logger_printSummary(callsite, __atomic_load_n(&handlePrv->outputs, __ATOMIC_RELAXED), "suppressed %u messages", suppressed);
+    }
+    
+    return true;
+}
+
+/* the callsite's own switch, then the handle's levels */
+static bool logger_isCallsiteEnabled ( LOGGER_HANDLE_PRV * handlePrv, const LOGGER_CALLSITE * callsite )
 {
-    /* plus two for the ' ' in snprintf below */
-    size_t strSize = LOGGER_MAX_LOGGER_CHARS;
-    char completeMessage[LOGGER_MAX_LOGGER_CHARS];
+    uint32_t control = __atomic_load_n(&callsite->control, __ATOMIC_RELAXED);
+    
+    if ( control == (uint32_t)LOGGER_CALLSITE_DEFAULT )
+    {
+        return logger_level_isEnabled(handlePrv, callsite->level);
+    }
+    
+    return ( control == (uint32_t)LOGGER_CALLSITE_ENABLED );
+}
+
+/* a record the library adds on behalf of a callsite, fmt must be a literal */
+static int logger_printSummary ( const LOGGER_CALLSITE * callsite, uint32_t outputs, const char * fmt, ... )
+{
+    int status = LOGGER_STATUS_OK;
+    bool captured = false;
+    va_list args;
+    va_start(args, fmt);
+    
+    if ( logger_binary_isEnabled() )
+    {
+        va_list argsCopy;
+        va_copy(argsCopy, args);
+        
+        /* keep it in order with the callsite's captured records */
+        captured = logger_binary_capture(callsite, outputs, fmt, argsCopy);
+        
+        va_end(argsCopy);
+    }
     
-    for ( size_t i=0U; i<LOGGER_MAX_LOGGER_CHARS; i++ )
+    if ( captured == false )
     {
-        completeMessage[i] = '\0';
+        status = logger_printLog(fmt, args, callsite, outputs);
     }
     
-    char strTimeStamp     [LOGGER_TIMESTAMP_SIZE];
-    char strFileName      [LOGGER_FILENAME_SIZE];
-    char strLineNumber    [LOGGER_LINENUMBER_SIZE];
-    char strFunctionName  [LOGGER_FUNCTIONNAME_SIZE];
-    char strSeverity      [LOGGER_SEVERITY_SIZE];
+    va_end(args);
     
-    char *strFileNamePtr = (char*)&strFileName;
+    return status;
+}
+
+/* [ratelimit] basename=count/milliseconds */
+static void logger_rateLimitFromIni ( LOGGER_HANDLE_PRV * handlePrv, char * baseName, size_t baseNameLen )
+{
+    LOGGER_INI_SECTIONHANDLE inihandle = NULL;
+    char *rateString = NULL;
+    size_t rateStringLen = 0U;
     
-    loggerGetTimeString( (char*)&strTimeStamp,    LOGGER_TIMESTAMP_SIZE );
-    logger_string_fileNameFromPath( &strFileNamePtr, NULL, fileName, (uint32_t)strlen(fileName));
-    snprintf( (char*)&strLineNumber,      LOGGER_LINENUMBER_SIZE,     "%d",lineNumber);
-    snprintf( (char*)&strFunctionName,    LOGGER_FUNCTIONNAME_SIZE,   "%s",functionName);
-    loggerLevelStringFromLevel ( severity, (char*)&strSeverity, LOGGER_SEVERITY_SIZE );
+    logger_ini_sectionHandleByName(&inihandle, "ratelimit", strlen("ratelimit"));
     
-    logger_assemble_string(completeMessage,LOGGER_MAX_LOGGER_CHARS,(char*)strTimeStamp,(char*)strFileName,(char*)strLineNumber,(char*)strFunctionName,(char*)strSeverity,msg);
+    if ( inihandle != NULL )
+    {
+        logger_ini_sectionRetrieveValueFromKey(inihandle, baseName, baseNameLen, &rateString, &rateStringLen);
+    }
     
-    /* remove any pre-terminated null chars */
-    for ( uint32_t i=0U; i<LOGGER_MAX_LOGGER_CHARS-1; i++ )
+    if ( rateString != NULL )
     {
-        if ( completeMessage[i] == '\0' )
+        char *end = NULL;
+        unsigned long count = strtoul(rateString, &end, 10);
+        unsigned long intervalMs = 0UL;
+        
+        if ( ( end != NULL ) && ( (size_t)(end - rateString) < rateStringLen ) && ( *end == '/' ) )
+        {
+            intervalMs = strtoul(end+1, NULL, 10);
+        }
+        
+        if ( ( count == 0UL ) || ( intervalMs == 0UL ) )
+        {
+            LOGPRINT_LOG_W("Ignoring ratelimit for %s, expected count/milliseconds",baseName);
+        }
+        else
         {
-            completeMessage[i] = (char)' ';
+            handlePrv->rateCount = (uint32_t)count;
+            handlePrv->rateIntervalMs = (uint32_t)intervalMs;
         }
     }
+}
+
+/* [capture] basename=levels, every level when missing. Only read while the flight recorder is on */
+static void logger_captureFromIni ( LOGGER_HANDLE_PRV * handlePrv, char * baseName, size_t baseNameLen )
+{
+    LOGGER_INI_SECTIONHANDLE inihandle = NULL;
+    char *captureString = NULL;
+    size_t captureStringLen = 0U;
+    LOGGER_LEVEL captured = LOGGER_LEVEL_ALL;
     
-    /* now work backwards and insert the NULL termination correctly */
-    for ( size_t i=LOGGER_MAX_LOGGER_CHARS-2; i>0U; i-- )
+    if ( logger_binary_isRecording() == false )
     {
-        char c = completeMessage[i];
+        return;
+    }
+    
+    logger_ini_sectionHandleByName(&inihandle, "capture", strlen("capture"));
+    
+    if ( inihandle != NULL )
+    {
+        logger_ini_sectionRetrieveValueFromKey(inihandle, baseName, baseNameLen, &captureString, &captureStringLen);
+    }
+    
+    if ( captureString != NULL )
+    {
+        captured = loggerFlags_level_stringToFlags(captureString, captureStringLen);
+    }
+    
+    logger_level_setCaptured(handlePrv, captured);
+}
+
+/* [bindings] basename=outputname, unbound when missing */
+static void logger_bindingFromIni ( LOGGER_HANDLE_PRV * handlePrv )
+{
+    LOGGER_INI_SECTIONHANDLE inihandle = NULL;
+    char *outputName = NULL;
+    size_t outputNameLen = 0U;
+    uint32_t outputs = 0U;
+    
+    logger_ini_sectionHandleByName(&inihandle, "bindings", strlen("bindings"));
+    
+    if ( inihandle != NULL )
+    {
+        logger_ini_sectionRetrieveValueFromKey(inihandle, handlePrv->baseName, handlePrv->baseNameLen, &outputName, &outputNameLen);
+    }
+    
+    if ( outputName != NULL )
+    {
+        outputs = logger_output_find(outputName, outputNameLen);
         
-        if ( c != ' ' )
+        if ( outputs == 0U )
         {
-            strSize = i+1U;
-            break;
+            LOGPRINT_LOG_W("Ignoring binding for %s, no output named %.*s",handlePrv->baseName,(int)outputNameLen,outputName);
         }
     }
+    
+    __atomic_store_n(&handlePrv->outputs, outputs, __ATOMIC_RELAXED);
+}
 
-    completeMessage[strSize] = '\0';
+/* [overrides] basename=levels, the default levels when missing. Registry locked & ini held */
+static void logger_levelsFromIni ( LOGGER_HANDLE_PRV * handlePrv )
+{
+    LOGGER_INI_SECTIONHANDLE inihandle = NULL;
+    char *overrideString = NULL;
+    size_t overrideStringLen = 0U;
+    LOGGER_LEVEL level = f_defaultLevel;
     
-    LOGGER_TEMPLATE_SEND handler = logger_getPrintHandler();
+    logger_ini_sectionHandleByName(&inihandle, "overrides", strlen("overrides"));
     
-    int status = (*handler)((char*)completeMessage,strSize);
+    if ( inihandle != NULL )
+    {
+        logger_ini_sectionRetrieveValueFromKey(inihandle, handlePrv->baseName, handlePrv->baseNameLen, &overrideString, &overrideStringLen);
+    }
     
-    LOGPRINT_ASSERT(status==LOGGER_STATUS_OK);
+    if ( overrideString != NULL )
+    {
+        level = loggerFlags_level_stringToFlags(overrideString,overrideStringLen);
+    }
     
-    return status;
+    logger_level_set(handlePrv, level);
+    logger_captureFromIni(handlePrv, handlePrv->baseName, handlePrv->baseNameLen);
+    logger_bindingFromIni(handlePrv);
+}
+
+/* levels set at runtime are replaced by the ini's, other settings only apply to handles created from now on */
+static void logger_reconfigureHandles ( void )
+{
+    logger_ini_readBegin();
+    
+    logger_registry_configureAll(logger_levelsFromIni);
+    
+    logger_ini_readEnd();
+}
+
+static void logger_recorderTrigger ( LOGGER_LEVEL level )
+{
+    if ( ( ( level & LOGGER_RECORDER_TRIGGER ) != 0U ) && logger_binary_isRecording() )
+    {
+        (void)logger_binary_dumpRecorder(logger_sendRecord);
+    }
+}
+
+/* the recorder keeps the format pointer until a dump. Only a literal is still there, any other format is
+   formatted now & its text kept */
+static void logger_recordCallsite ( const LOGGER_CALLSITE * callsite, uint32_t outputs, const char * fmt, va_list args )
+{
+    if ( fmt == callsite->format )
+    {
+        logger_binary_record(callsite, outputs, fmt, args);
+    }
+    else
+    {
+        char text[LOGGER_MESSAGE_SIZE];
+        
+        (void)vsnprintf(text, sizeof(text), ( fmt != NULL ) ? fmt : "", args);
+        
+        logger_recordText(callsite, outputs, "%s", text);
+    }
+}
+
+static void logger_recordText ( const LOGGER_CALLSITE * callsite, uint32_t outputs, const char * fmt, ... )
+{
+    va_list args;
+    va_start(args, fmt);
+    
+    logger_binary_record(callsite, outputs, fmt, args);
+    
+    va_end(args);
 }
 
 #ifdef LOGGER_ENABLE_TRACE
@@ -112,7 +454,7 @@ bool loggerInit ( LOGGER_OUTPUT_HANDLE * handle , LOGGER_LEVEL loggerLevel )
     else
     {
         /* add new logger registration info */
-        LOGGER_HANDLE_PRV * handlePrv = logger_memAlloc ( sizeof( LOGGER_HANDLE_PRV ) );
+        LOGGER_HANDLE_PRV * handlePrv = logger_mem_alloc ( sizeof( LOGGER_HANDLE_PRV ) );
         
         if ( handlePrv == NULL )
         {
@@ -120,7 +462,14 @@ bool loggerInit ( LOGGER_OUTPUT_HANDLE * handle , LOGGER_LEVEL loggerLevel )
         }
         else
         {
-            handlePrv->loggerLevelsEnabled = loggerLevel;
+            /* nothing captured yet, the handle is not seen by other threads until returned */
+            handlePrv->shared.loggerLevels = (uint32_t)loggerLevel & (uint32_t)LOGGER_LEVEL_ALL;
+            handlePrv->rateCount = 0U;
+            handlePrv->rateIntervalMs = 0U;
+            handlePrv->outputs = 0U;
+            handlePrv->baseName = NULL;
+            handlePrv->baseNameLen = 0U;
+            handlePrv->registryNext = NULL;
             
             *handle = (void*)handlePrv;
 
@@ -128,6 +477,12 @@ bool loggerInit ( LOGGER_OUTPUT_HANDLE * handle , LOGGER_LEVEL loggerLevel )
 
             if ( initSuccess )
             {
+                /* the first init reads recorder= */
+                if ( logger_binary_isRecording() )
+                {
+                    logger_level_setCaptured(handlePrv, LOGGER_LEVEL_ALL);
+                }
+                
 #ifdef LOGGER_ENABLE_TRACE
                 LOGPRINT_LOG_I("Init: %s:%d",fileName,lineNumber);
 #endif
@@ -135,7 +490,7 @@ bool loggerInit ( LOGGER_OUTPUT_HANDLE * handle , LOGGER_LEVEL loggerLevel )
             else
             {
                 *handle = LOGGER_OUTPUT_HANDLE_INVALID;
-                logger_memFree(handlePrv);
+                logger_mem_free(handlePrv);
             }
         }
     }
@@ -159,10 +514,17 @@ bool loggerTerm  ( LOGGER_OUTPUT_HANDLE handle )
     {
         LOGGER_HANDLE_PRV * handlePrv = (LOGGER_HANDLE_PRV *)handle;
         
+        /* out of reach of a reload before it is freed */
+        if ( handlePrv->baseName != NULL )
+        {
+            logger_registry_remove(handlePrv);
+            logger_mem_free(handlePrv->baseName);
+        }
+        
         termSuccess = logger_term();
         
         /* release logger resources for this handle */
-        logger_memFree ( handlePrv );
+        logger_mem_free ( handlePrv );
     }
     
     return termSuccess;
@@ -173,43 +535,45 @@ bool loggerInitFromFileName ( LOGGER_OUTPUT_HANDLE * handle, const char * fileNa
 {
     bool status = false;
 
-    /* get the basename */
-    char *baseName = malloc( sizeof(char) * fileNameLen );
+    /* get the basename, only needed while the handle is set up */
+    LOGGER_MEM_MARK mark = logger_mem_scratchMark();
+    char *baseName = logger_mem_scratchAlloc( sizeof(char) * (fileNameLen+1U) );
     size_t baseNameLen = 0U;
     
     logger_string_fileNameFromPath ( &baseName, &baseNameLen, fileName, fileNameLen );
 
     if ( logger_ini_isFileOpen() && ( baseName != NULL ) )
     {
-        LOGGER_INI_SECTIONHANDLE inihandle = NULL;
-        
-        logger_ini_sectionHandleByName(&inihandle, "overrides", strlen("overrides"));
+        /* created at the default levels, the real ones are set before the handle is returned */
+        status = loggerInit(handle, f_defaultLevel);
         
-        if ( inihandle != NULL )
+        if ( status )
         {
-            /* find basename in overrides. If not found use default levels */
-            char *overrideString = NULL;
-            size_t overrideStringLen = 0U;
+            LOGGER_HANDLE_PRV * handlePrv = (LOGGER_HANDLE_PRV*)*handle;
+            
+            /* kept so a reload can look the handle's levels up again */
+            handlePrv->baseName = logger_mem_alloc( sizeof(char) * (baseNameLen+1U) );
+            
+            logger_ini_readBegin();
             
-            logger_ini_sectionRetrieveValueFromKey(inihandle, baseName, baseNameLen, &overrideString, &overrideStringLen);
+            logger_rateLimitFromIni(handlePrv, baseName, baseNameLen);
             
-            if ( overrideString != NULL )
+            if ( handlePrv->baseName != NULL )
             {
-                LOGGER_LEVEL level = loggerFlags_level_stringToFlags(overrideString,overrideStringLen);
-                status = loggerInit(handle, level);
+                memcpy(handlePrv->baseName, baseName, baseNameLen);
+                handlePrv->baseName[baseNameLen] = '\0';
+                handlePrv->baseNameLen = baseNameLen;
+                
+                /* configured under the registry lock, a reload running now cannot leave it with stale levels */
+                logger_registry_add(handlePrv, logger_levelsFromIni);
             }
             else
             {
-                status = loggerInit(handle, f_defaultLevel);
+                LOGPRINT_LOG_E("Malloc failure !!!");
             }
+            
+            logger_ini_readEnd();
         }
-        else
-        {
-            /* no ini section overrides */
-            status = loggerInit(handle, f_defaultLevel);
-        }
-
-        logger_memFree(baseName);
     }
     else
     {
@@ -217,6 +581,8 @@ bool loggerInitFromFileName ( LOGGER_OUTPUT_HANDLE * handle, const char * fileNa
         status = loggerInit(handle, f_defaultLevel);
     }
 
+    logger_mem_scratchRelease(mark);
+
     return status;
 }
 
@@ -227,7 +593,30 @@ void loggerSetSeverityEnablements_Default ( LOGGER_LEVEL loggerLevel )
 
 bool loggerLoadIniFile ( char * filePath, size_t filePathLen )
 {
-    return logger_ini_initFromFile(filePath, filePathLen);
+    bool didLoad = logger_ini_initFromFile(filePath, filePathLen);
+    
+    if ( didLoad )
+    {
+        logger_reconfigureHandles();
+    }
+    
+    return didLoad;
+}
+
+bool loggerReloadIniFile ( void )
+{
+    bool didLoad = logger_ini_reload();
+    
+    if ( didLoad )
+    {
+        logger_reconfigureHandles();
+    }
+    else
+    {
+        LOGPRINT_LOG_E("Failed to reload ini file, keeping the current settings");
+    }
+    
+    return didLoad;
 }
 
 bool loggerAppendDebugLevel ( LOGGER_OUTPUT_HANDLE handle, LOGGER_LEVEL addLevel )
@@ -270,6 +659,45 @@ bool loggerRemoveDebugLevel ( LOGGER_OUTPUT_HANDLE handle, LOGGER_LEVEL rmLevel
     return success;
 }
 
+bool loggerSetCaptureLevel ( LOGGER_OUTPUT_HANDLE handle, LOGGER_LEVEL captureLevel )
+{
+    if ( handle == NULL )
+    {
+        LOGPRINT_LOG_E("NULL handle called to %s (hdl=%p)",__FUNCTION__,handle);
+        return false;
+    }
+    
+    logger_level_setCaptured((LOGGER_HANDLE_PRV*)handle, captureLevel);
+    
+    return true;
+}
+
+bool loggerBindOutput ( LOGGER_OUTPUT_HANDLE handle, const char * outputName )
+{
+    if ( handle == NULL )
+    {
+        LOGPRINT_LOG_E("NULL handle called to %s",__FUNCTION__);
+        return false;
+    }
+    
+    uint32_t outputs = ( outputName != NULL ) ? logger_output_find(outputName, strlen(outputName)) : 0U;
+    
+    if ( ( outputName != NULL ) && ( outputs == 0U ) )
+    {
+        LOGPRINT_LOG_E("No output named %s called to %s",outputName,__FUNCTION__);
+        return false;
+    }
+    
+    __atomic_store_n(&((LOGGER_HANDLE_PRV*)handle)->outputs, outputs, __ATOMIC_RELAXED);
+    
+    return true;
+}
+
+uint32_t loggerDumpFlightRecorder ( void )
+{
+    return logger_binary_dumpRecorder(logger_sendRecord);
+}
+
 bool loggerIsDebugLevelEnabled ( LOGGER_OUTPUT_HANDLE handle, LOGGER_LEVEL isLevel )
 {
     bool isEnabled = false;
@@ -310,41 +738,193 @@ bool logPrint ( LOGGER_OUTPUT_HANDLE handle,
     
     if ( logger_level_isEnabled(handlePrv, loggerLevel ) )
     {
-        int logSize = LOGGER_MESSAGE_SIZE;
-        char * logDebug[logSize];
+        uint64_t start = logger_metrics_latencyStart();
         
-        if ( fmt == NULL )
+        /* no static descriptor to cache against, fields are rendered each time */
+        LOGGER_CALLSITE callsite = { fileName, functionName, lineNumber, loggerLevel, NULL, 0U, 0U, NULL, LOGGER_CALLSITE_DEFAULT };
+        
+        logger_metrics_record(loggerLevel);
+        
+        va_list arg;
+        va_start(arg, fmt);
+        
+        /* this is where the message is printed */
+        if ( logger_printLog(fmt, arg, &callsite, __atomic_load_n(&handlePrv->outputs, __ATOMIC_RELAXED)) == LOGGER_STATUS_OK )
         {
-            logDebug[0] = '\0';
-            logSize = 0;
+            wasDebugOutput = true;
         }
-        else
+        
+        va_end(arg);
+        
+        logger_metrics_latency(start);
+    }
+    else
+    {
+        /* Lie - User does not want this printed. So return success */
+        /*LOGPRINT_LOG_I("(%s:%d) does not want message printed for level:%d", fileName, lineNumber, loggerLevel);*/
+        logger_metrics_filtered();
+        wasDebugOutput = true;
+    }
+    
+    return wasDebugOutput;
+}
+
+bool logPrintCallsite ( LOGGER_OUTPUT_HANDLE handle,
+                        LOGGER_CALLSITE * callsite,
+                        const char * fmt,
+                        ... )
+{
+    if ( ( handle == NULL ) || ( callsite == NULL ) )
+    {
+        LOGPRINT_LOG_E("NULL handle called to %s (hdl=%p callsite=%p fmt=%s)",__FUNCTION__,handle,(void*)callsite,fmt);
+        return false;
+    }
+    
+    bool wasDebugOutput = false;
+    
+    LOGGER_HANDLE_PRV * handlePrv = (LOGGER_HANDLE_PRV*)handle;
+    
+    /* kept whether or not it is output, & before any rate limit. A callsite switched off is not kept either */
+    if ( ( __atomic_load_n(&callsite->control, __ATOMIC_RELAXED) != (uint32_t)LOGGER_CALLSITE_DISABLED ) &&
+         logger_level_isCaptured(handlePrv, callsite->level) )
+    {
+        va_list arg;
+        va_start(arg, fmt);
+        
+        logger_recordCallsite(callsite, __atomic_load_n(&handlePrv->outputs, __ATOMIC_RELAXED), fmt, arg);
+        
+        va_end(arg);
+    }
+    
+    if ( logger_isCallsiteEnabled(handlePrv, callsite) )
+    {
+        uint64_t start = logger_metrics_latencyStart();
+        
+        if ( logger_admitCallsite(handlePrv, callsite) == false )
+        {
+            logger_metrics_latency(start);
+            return true;
+        }
+        
+        logger_metrics_record(callsite->level);
+        
+        uint32_t outputs = __atomic_load_n(&handlePrv->outputs, __ATOMIC_RELAXED);
+        
+        va_list arg;
+        va_start(arg, fmt);
+        
+        /* format later on the writer thread, only a literal format is still there to read */
+        if ( ( fmt == callsite->format ) && logger_binary_isEnabled() )
         {
-            va_list arg;
-            va_start(arg, fmt);
+            va_list argCopy;
+            va_copy(argCopy, arg);
             
-            vsnprintf((char*)logDebug, (size_t)logSize, fmt, arg);
+            wasDebugOutput = logger_binary_capture(callsite, outputs, fmt, argCopy);
             
-            va_end(arg);
+            va_end(argCopy);
         }
-
+        
         /* this is where the message is printed */
-        if ( logger_printLog((char*)logDebug, logSize, (char*)fileName, lineNumber, (char*)functionName, loggerLevel)
-            == LOGGER_STATUS_OK )
+        if ( ( wasDebugOutput == false ) &&
+             ( logger_printLog(fmt, arg, callsite, outputs) == LOGGER_STATUS_OK ) )
         {
             wasDebugOutput = true;
         }
+        
+        va_end(arg);
+        
+        logger_metrics_latency(start);
+        
+        logger_recorderTrigger(callsite->level);
     }
     else
     {
         /* Lie - User does not want this printed. So return success */
-        /*LOGPRINT_LOG_I("(%s:%d) does not want message printed for level:%d", fileName, lineNumber, loggerLevel);*/
+        logger_metrics_filtered();
         wasDebugOutput = true;
     }
     
     return wasDebugOutput;
 }
 
+bool logPrintKV ( LOGGER_OUTPUT_HANDLE handle,
+                  LOGGER_CALLSITE * callsite,
+                  const char * message,
+                  const LOGGER_KV * fields,
+                  uint32_t fieldCount )
+{
+    if ( ( handle == NULL ) || ( callsite == NULL ) )
+    {
+        LOGPRINT_LOG_E("NULL handle called to %s (hdl=%p callsite=%p)",__FUNCTION__,handle,(void*)callsite);
+        return false;
+    }
+    
+    bool wasDebugOutput = true;
+    
+    LOGGER_HANDLE_PRV * handlePrv = (LOGGER_HANDLE_PRV*)handle;
+    
+    /* binary capture only holds format arguments, fielded records are always built here. They are already
+       compact & nothing is formatted until the output. For the same reason the flight recorder does not keep them */
+    if ( logger_isCallsiteEnabled(handlePrv, callsite) )
+    {
+        uint64_t start = logger_metrics_latencyStart();
+        
+        if ( logger_admitCallsite(handlePrv, callsite) )
+        {
+            logger_metrics_record(callsite->level);
+            
+            wasDebugOutput = ( logger_printFields(callsite, __atomic_load_n(&handlePrv->outputs, __ATOMIC_RELAXED), message, fields, fieldCount) == LOGGER_STATUS_OK );
+        }
+        
+        logger_metrics_latency(start);
+        
+        logger_recorderTrigger(callsite->level);
+    }
+    else
+    {
+        logger_metrics_filtered();
+    }
+    
+    return wasDebugOutput;
+}
+
+uint32_t loggerControlCallsites ( const char * match, LOGGER_CALLSITE_CONTROL control )
+{
+    if ( ( control != LOGGER_CALLSITE_DEFAULT ) && ( control != LOGGER_CALLSITE_ENABLED ) && ( control != LOGGER_CALLSITE_DISABLED ) )
+    {
+        LOGPRINT_LOG_E("Invalid callsite control %d called to %s",(int)control,__FUNCTION__);
+        return 0U;
+    }
+    
+    return logger_callsite_control(match, control);
+}
+
+void loggerGetMemoryUsage ( LOGGER_MEMORY_USAGE * usage )
+{
+    if ( usage == NULL )
+    {
+        LOGPRINT_LOG_E("NULL usage called to %s",__FUNCTION__);
+    }
+    else
+    {
+        logger_mem_usage(usage);
+    }
+}
+
+bool loggerGetStats ( LOGGER_STATS * stats )
+{
+    if ( stats == NULL )
+    {
+        LOGPRINT_LOG_E("NULL stats called to %s",__FUNCTION__);
+        return false;
+    }
+    
+    logger_metrics_snapshot(stats);
+    logger_mem_usage(&stats->memory);
+    
+    return true;
+}
+
 uint32_t loggerVersion ( void )
 {
     return LOGGER_VERSION;
@@ -0,0 +1,78 @@
+/**
+ @file
+ Diagnostics print library - backpressure policies
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#include <string.h>
+
+#include "logger_backpressure.h"
+#include "logger_common.h"
+#include "logger_ini.h"
+
+
+/* shed from half full */
+#define LOGGER_BACKPRESSURE_SHED_LOW ( LOGGER_LEVEL_ENTRY | LOGGER_LEVEL_EXIT | LOGGER_LEVEL_TRACE )
+
+/* shed from three quarters full */
+#define LOGGER_BACKPRESSURE_SHED_HIGH ( LOGGER_BACKPRESSURE_SHED_LOW | LOGGER_LEVEL_INFO )
+
+
+LOGGER_BACKPRESSURE logger_backpressure_fromIni ( LOGGER_INI_SECTIONHANDLE paramBag )
+{
+    static const struct
+    {
+        const char * name;
+        LOGGER_BACKPRESSURE policy;
+    } policies[] =
+    {
+        { "block", LOGGER_BACKPRESSURE_BLOCK },
+        { "drop_newest", LOGGER_BACKPRESSURE_DROP_NEWEST },
+        { "drop_oldest", LOGGER_BACKPRESSURE_DROP_OLDEST },
+        { "drop_level", LOGGER_BACKPRESSURE_DROP_LEVEL },
+    };
+
+    LOGGER_BACKPRESSURE policy = LOGGER_BACKPRESSURE_BLOCK;
+    char *value = NULL;
+    size_t valueLen = 0U;
+    bool found = false;
+
+    logger_ini_sectionRetrieveValueFromKey(paramBag, "backpressure", strlen("backpressure"), &value, &valueLen);
+
+    for ( uint32_t i=0U; ( value != NULL ) && ( i<sizeof(policies)/sizeof(policies[0]) ); i++ )
+    {
+        if ( ( strlen(policies[i].name) == valueLen ) && ( strncmp(policies[i].name, value, valueLen) == 0 ) )
+        {
+            policy = policies[i].policy;
+            found = true;
+        }
+    }
+
+    if ( ( value != NULL ) && ( found == false ) )
+    {
+        LOGPRINT_LOG_E("Unknown backpressure=%.*s, blocking",(int)valueLen,value);
+    }
+
+    return policy;
+}
+
+bool logger_backpressure_shed ( LOGGER_LEVEL level, size_t used, size_t capacity )
+{
+    LOGGER_LEVEL shed = LOGGER_LEVEL_NONE;
+
+    if ( used >= capacity - capacity/4U )
+    {
+        shed = LOGGER_BACKPRESSURE_SHED_HIGH;
+    }
+    else if ( used >= capacity/2U )
+    {
+        shed = LOGGER_BACKPRESSURE_SHED_LOW;
+    }
+
+    return ( ( level & shed ) != 0U );
+}
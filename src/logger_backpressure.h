@@ -0,0 +1,81 @@
+/**
+ @file
+ Diagnostics print library - backpressure policies
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#ifndef _LOGGER_BACKPRESSURE_H
+#define _LOGGER_BACKPRESSURE_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "logger.h"
+#include "logger_ini.h"
+
+
+/**
+ @enum _LOGGER_BACKPRESSURE
+ @brief what a printing thread does when an output's queue is full, selected by the output's backpressure= ini key \n
+ #LOGGER_BACKPRESSURE_BLOCK wait for the output's sender - the default, nothing is lost \n
+ #LOGGER_BACKPRESSURE_DROP_NEWEST the record being printed is dropped \n
+ #LOGGER_BACKPRESSURE_DROP_OLDEST the oldest queued record is dropped to make room. Per-thread binary capture
+ buffers are shared by the outputs & only read by the writer. They follow the least dropping policy of the outputs a
+ record is routed to, dropping the newest for drop_oldest \n
+ #LOGGER_BACKPRESSURE_DROP_LEVEL records are shed by level as the queue fills: ENTRY, EXIT & TRACE from half
+ full, INFO from three quarters, everything else once full \n
+ Records of #LOGGER_BACKPRESSURE_KEEP levels are never dropped, whatever the policy
+ */
+typedef enum _LOGGER_BACKPRESSURE
+{
+    LOGGER_BACKPRESSURE_BLOCK = 0,
+    LOGGER_BACKPRESSURE_DROP_NEWEST,
+    LOGGER_BACKPRESSURE_DROP_OLDEST,
+    LOGGER_BACKPRESSURE_DROP_LEVEL,
+} LOGGER_BACKPRESSURE;
+
+
+/**
+ @def LOGGER_BACKPRESSURE_KEEP
+ @brief levels that wait for a full queue rather than be dropped
+ */
+#define LOGGER_BACKPRESSURE_KEEP ( LOGGER_LEVEL_ERROR | LOGGER_LEVEL_FATAL | LOGGER_LEVEL_ASSERT )
+
+
+/**
+ @brief read an output's policy from its [output=...] section key backpressure=
+ @details backpressure = block | drop_newest | drop_oldest | drop_level, missing selects block
+ @param[in] paramBag ini section handle
+ @return policy for the output's full queue
+ */
+LOGGER_BACKPRESSURE logger_backpressure_fromIni ( LOGGER_INI_SECTIONHANDLE paramBag );
+
+
+/**
+ @brief decide whether a record is shed before the queue is full, #LOGGER_BACKPRESSURE_DROP_LEVEL only
+ @param[in] level level of the record
+ @param[in] used records or bytes queued
+ @param[in] capacity most records or bytes the queue holds
+ @return #true if the record should be dropped
+ */
+bool logger_backpressure_shed ( LOGGER_LEVEL level, size_t used, size_t capacity );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _LOGGER_BACKPRESSURE_H */
@@ -0,0 +1,1517 @@
+/**
+ @file
+ Diagnostics print library - deferred binary capture
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+/* strnlen */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "logger_binary.h"
+#include "logger_callsite.h"
+#include "logger_crash.h"
+#include "logger_dedup.h"
+#include "logger_clock.h"
+#include "logger_messageAssemble.h"
+#include "logger_initTerm.h"
+#include "logger_memory.h"
+#include "logger_metrics.h"
+#include "logger_backpressure.h"
+#include "logger_ini.h"
+#include "logger_format.h"
+
+
+/*
+ Each logging thread owns a byte ring it alone writes to, the drain thread alone reads from it.
+ A record is a LOGGER_BINARY_ENTRY followed by the raw argument values in format order, each
+ aligned to LOGGER_BINARY_ALIGN. Strings are stored inline as a uint32_t length then the chars.
+ The format string is parsed again at drain time to know how to read the values back.
+
+ A record the thread had to format itself (a format that cannot be captured, or fields) is stored
+ whole in the same buffer with a NULL format, so the writer sends the thread's records in order.
+
+ Buffers are never freed. When a thread exits its buffer is retired, once drained it is handed
+ to the next thread that starts logging.
+
+ The flight recorder keeps the same entries in a second per-thread ring that is never drained.
+ Its owner overwrites the oldest records, moving tail past them before the bytes are reused.
+ A dump may read any thread's recorder while it is written: the ring is copied first & only the
+ records from the tail read after the copy are kept.
+ */
+
+
+#define LOGGER_BINARY_ALIGN (16U)
+#define LOGGER_BINARY_ALIGNED(x) ( ((x) + (LOGGER_BINARY_ALIGN-1U)) & ~(size_t)(LOGGER_BINARY_ALIGN-1U) )
+
+#define LOGGER_BINARY_STRING_NULL (0xFFFFFFFFU)
+
+/* strings are measured no further than this, a longer one makes the record too big to capture & it is formatted inline */
+#define LOGGER_BINARY_STRING_MAX (LOGGER_BINARY_BUFFER_SIZE/2U)
+
+/* longest conversion spec we will rebuild e.g %-+#0123.456llx */
+#define LOGGER_BINARY_SPEC_SIZE (32U)
+
+
+typedef enum _LOGGER_BINARY_ARG
+{
+    LOGGER_BINARY_ARG_NONE = 0,
+    LOGGER_BINARY_ARG_INT,
+    LOGGER_BINARY_ARG_LONG,
+    LOGGER_BINARY_ARG_LLONG,
+    LOGGER_BINARY_ARG_INTMAX,
+    LOGGER_BINARY_ARG_SIZE,
+    LOGGER_BINARY_ARG_PTRDIFF,
+    LOGGER_BINARY_ARG_DOUBLE,
+    LOGGER_BINARY_ARG_LDOUBLE,
+    LOGGER_BINARY_ARG_STRING,
+    LOGGER_BINARY_ARG_POINTER,
+    LOGGER_BINARY_ARG_UNSUPPORTED,
+} LOGGER_BINARY_ARG;
+
+
+typedef enum _LOGGER_BINARY_STATE
+{
+    LOGGER_BINARY_STATE_OWNED = 0,
+    LOGGER_BINARY_STATE_RETIRED,
+    LOGGER_BINARY_STATE_FREE,
+} LOGGER_BINARY_STATE;
+
+
+/** one parsed % conversion */
+typedef struct _LOGGER_BINARY_SPEC
+{
+    const char * start;
+    size_t length;
+    uint32_t starCount;
+    int precision;          /* -1 when not given */
+    bool starPrecision;     /* precision is the last * argument */
+    LOGGER_BINARY_ARG arg;
+} LOGGER_BINARY_SPEC;
+
+
+typedef union _LOGGER_BINARY_VALUE
+{
+    int i;
+    long l;
+    long long ll;
+    intmax_t im;
+    size_t sz;
+    ptrdiff_t pd;
+    double d;
+    long double ld;
+    const char * s;
+    void * p;
+} LOGGER_BINARY_VALUE;
+
+
+/** arguments of one record pulled off its va_list */
+typedef struct _LOGGER_BINARY_ARGS
+{
+    uint32_t count;
+    size_t size;            /* bytes of the entry they make, header included */
+    LOGGER_BINARY_ARG types[LOGGER_BINARY_MAX_ARGS];
+    LOGGER_BINARY_VALUE values[LOGGER_BINARY_MAX_ARGS];
+    uint32_t lengths[LOGGER_BINARY_MAX_ARGS];  /* bytes kept of each string, #LOGGER_BINARY_STRING_NULL for NULL */
+} LOGGER_BINARY_ARGS;
+
+
+typedef struct _LOGGER_BINARY_ENTRY
+{
+    uint32_t size;          /* bytes including this header & padding. 0 marks a skip to the buffer start */
+    uint32_t outputs;       /* as #LOGGER_RECORD outputs */
+    const char * fmt;       /* NULL for a stored record */
+    const LOGGER_CALLSITE * callsite;
+    LOGGER_TICKS ticks;
+} LOGGER_BINARY_ENTRY;
+
+
+/** follows the entry of a stored record, then the message & fields bytes */
+typedef struct _LOGGER_BINARY_STORED
+{
+    LOGGER_LEVEL level;
+    const char * header;    /* static header of a resolved callsite, or NULL when it starts the message */
+    size_t headerLen;
+    size_t messageLen;
+    size_t fieldsLen;
+} LOGGER_BINARY_STORED;
+
+
+typedef struct _LOGGER_BINARY_RECORDER
+{
+    struct _LOGGER_BINARY_RECORDER * next;
+    uint32_t state;     /* a free recorder keeps its records until another thread takes it over */
+    size_t size;        /* bytes of data, a power of two */
+    size_t head;        /* written by owning thread */
+    size_t tail;        /* oldest whole record, written by owning thread */
+    size_t dumped;      /* records before this have been dumped, dumping thread only */
+    unsigned char * data;
+} LOGGER_BINARY_RECORDER;
+
+
+typedef struct _LOGGER_BINARY_BUFFER
+{
+    struct _LOGGER_BINARY_BUFFER * next;
+    uint32_t state;
+    size_t head;        /* written by owning thread */
+    size_t tail;        /* written by drain thread */
+    unsigned char * data;
+    LOGGER_DEDUP_TABLE * dedup; /* drain thread only, created on first use */
+} LOGGER_BINARY_BUFFER;
+
+
+static bool f_binaryEnabled = false;
+
+static LOGGER_BINARY_BUFFER * f_binaryBuffers = NULL;
+
+static LOGGER_THREAD_LOCAL LOGGER_BINARY_BUFFER * f_threadBuffer = NULL;
+
+/* handler of the drain in progress, for summary records sent by the dedup tables */
+static LOGGER_RECORD_SEND f_drainHandler = NULL;
+
+static pthread_once_t f_binaryKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t f_binaryKey;
+
+/* bytes of recorder given to each new thread, 0 when the flight recorder is off */
+static size_t f_recorderSize = 0U;
+
+static LOGGER_BINARY_RECORDER * f_recorders = NULL;
+
+static LOGGER_THREAD_LOCAL LOGGER_BINARY_RECORDER * f_threadRecorder = NULL;
+
+static pthread_once_t f_recorderKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t f_recorderKey;
+
+static pthread_mutex_t f_recorderDumpMutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+static void logger_binary_threadExit ( void * buffer );
+static void logger_binary_createKey ( void );
+static LOGGER_BINARY_BUFFER * logger_binary_threadBuffer ( void );
+static const char * logger_binary_parseSpec ( const char * fmt, LOGGER_BINARY_SPEC * spec );
+static size_t logger_binary_argSize ( LOGGER_BINARY_ARG arg, uint32_t stringLen );
+static size_t logger_binary_readArg ( const unsigned char * data, LOGGER_BINARY_ARG arg, LOGGER_BINARY_VALUE * value );
+static void logger_binary_appendSpec ( LOGGER_RECORD_BUILDER * builder, size_t maxLen, const LOGGER_BINARY_SPEC * spec, const int * stars, LOGGER_BINARY_VALUE * value );
+static void logger_binary_appendPlain ( LOGGER_RECORD_BUILDER * builder, size_t maxLen, const LOGGER_BINARY_SPEC * spec, const LOGGER_BINARY_VALUE * value );
+static void logger_binary_formatEntry ( LOGGER_RECORD_BUILDER * builder, const LOGGER_BINARY_ENTRY * entry, LOGGER_RECORD * record, bool signalSafe );
+static void logger_binary_storedEntry ( LOGGER_RECORD_BUILDER * builder, const LOGGER_BINARY_ENTRY * entry, LOGGER_RECORD * record );
+static LOGGER_STATUS logger_binary_sendRecord ( const LOGGER_RECORD * record );
+static bool logger_binary_collect ( const char * fmt, va_list args, LOGGER_BINARY_ARGS * collected );
+static void logger_binary_writeEntry ( unsigned char * at, const LOGGER_CALLSITE * callsite, uint32_t outputs, const char * fmt, const LOGGER_BINARY_ARGS * collected );
+static unsigned char * logger_binary_reserve ( LOGGER_BINARY_BUFFER * buffer, size_t size, LOGGER_LEVEL level, uint32_t outputs, size_t * nextHead, bool * dropped );
+static void logger_binary_recorderExit ( void * recorder );
+static void logger_binary_createRecorderKey ( void );
+static LOGGER_BINARY_RECORDER * logger_binary_threadRecorder ( void );
+static size_t logger_binary_recorderCopy ( LOGGER_BINARY_RECORDER * recorder, unsigned char * snapshot, unsigned char * out, size_t outSize );
+static int logger_binary_compareTicks ( const void * a, const void * b );
+static void logger_binary_sendNote ( LOGGER_RECORD_SEND handler, const char * fmt, uint32_t count );
+static void logger_binary_sendNoteSafe ( LOGGER_RECORD_SEND handler, const char * text, uint32_t count );
+static bool logger_binary_crashEntry ( LOGGER_RECORD_SEND handler, const unsigned char * data, size_t dataSize, size_t pos, const size_t * tail );
+
+
+static void logger_binary_threadExit ( void * buffer )
+{
+    __atomic_store_n(&((LOGGER_BINARY_BUFFER *)buffer)->state, LOGGER_BINARY_STATE_RETIRED, __ATOMIC_RELEASE);
+}
+
+static void logger_binary_createKey ( void )
+{
+    pthread_key_create(&f_binaryKey, logger_binary_threadExit);
+}
+
+static LOGGER_BINARY_BUFFER * logger_binary_threadBuffer ( void )
+{
+    if ( f_threadBuffer != NULL )
+    {
+        return f_threadBuffer;
+    }
+
+    pthread_once(&f_binaryKeyOnce, logger_binary_createKey);
+
+    /* reuse a buffer left behind by an exited thread */
+    LOGGER_BINARY_BUFFER * buffer = __atomic_load_n(&f_binaryBuffers, __ATOMIC_ACQUIRE);
+
+    while ( buffer != NULL )
+    {
+        uint32_t expected = LOGGER_BINARY_STATE_FREE;
+
+        if ( __atomic_compare_exchange_n(&buffer->state, &expected, LOGGER_BINARY_STATE_OWNED, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) )
+        {
+            break;
+        }
+
+        buffer = buffer->next;
+    }
+
+    if ( buffer == NULL )
+    {
+        buffer = logger_mem_alloc(sizeof(LOGGER_BINARY_BUFFER));
+
+        if ( buffer == NULL )
+        {
+            LOGPRINT_LOG_E("Malloc failure !!!");
+            return NULL;
+        }
+
+        buffer->data = logger_mem_alloc(LOGGER_BINARY_BUFFER_SIZE);
+
+        if ( buffer->data == NULL )
+        {
+            LOGPRINT_LOG_E("Malloc failure !!!");
+            logger_mem_free(buffer);
+            return NULL;
+        }
+
+        buffer->state = LOGGER_BINARY_STATE_OWNED;
+        buffer->head = 0U;
+        buffer->tail = 0U;
+        buffer->dedup = NULL;
+        buffer->next = __atomic_load_n(&f_binaryBuffers, __ATOMIC_RELAXED);
+
+        while ( __atomic_compare_exchange_n(&f_binaryBuffers, &buffer->next, buffer, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED) == false )
+        {
+            /* buffer->next reloaded by the failed exchange */
+        }
+    }
+
+    pthread_setspecific(f_binaryKey, buffer);
+
+    f_threadBuffer = buffer;
+
+    return buffer;
+}
+
+static const char * logger_binary_parseSpec ( const char * fmt, LOGGER_BINARY_SPEC * spec )
+{
+    /* fmt points at the '%' */
+    const char * p = fmt + 1;
+    uint32_t longCount = 0U;
+    LOGGER_BINARY_ARG sized = LOGGER_BINARY_ARG_NONE;
+    bool longDouble = false;
+
+    spec->start = fmt;
+    spec->starCount = 0U;
+    spec->precision = -1;
+    spec->starPrecision = false;
+    spec->arg = LOGGER_BINARY_ARG_UNSUPPORTED;
+
+    while ( ( *p == '-' ) || ( *p == '+' ) || ( *p == ' ' ) || ( *p == '#' ) || ( *p == '0' ) || ( *p == '\'' ) )
+    {
+        p++;
+    }
+
+    /* width & precision */
+    for ( uint32_t field=0U; field<2U; field++ )
+    {
+        if ( ( field == 1U ) && ( *p != '.' ) )
+        {
+            break;
+        }
+
+        if ( field == 1U )
+        {
+            p++;
+        }
+
+        if ( *p == '*' )
+        {
+            spec->starCount += 1U;
+            spec->starPrecision = ( field == 1U );
+            p++;
+        }
+        else
+        {
+            int digits = 0;
+
+            while ( ( *p >= '0' ) && ( *p <= '9' ) )
+            {
+                /* anything longer than a string we would capture is as good as no limit */
+                digits = ( digits < (int)LOGGER_BINARY_STRING_MAX ) ? digits*10 + (*p - '0') : digits;
+                p++;
+            }
+
+            /* a lone '.' is a precision of 0 */
+            spec->precision = ( field == 1U ) ? digits : spec->precision;
+        }
+    }
+
+    /* length modifier */
+    for ( bool more=true; more; )
+    {
+        switch ( *p )
+        {
+            case 'h': p++; break;
+            case 'l': longCount += 1U; p++; break;
+            case 'q': longCount = 2U; p++; break;
+            case 'j': sized = LOGGER_BINARY_ARG_INTMAX; p++; break;
+            case 'z': sized = LOGGER_BINARY_ARG_SIZE; p++; break;
+            case 't': sized = LOGGER_BINARY_ARG_PTRDIFF; p++; break;
+            case 'L': longDouble = true; p++; break;
+            default: more = false; break;
+        }
+    }
+
+    switch ( *p )
+    {
+        case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+            if ( sized != LOGGER_BINARY_ARG_NONE )
+            {
+                spec->arg = sized;
+            }
+            else if ( longCount >= 2U )
+            {
+                spec->arg = LOGGER_BINARY_ARG_LLONG;
+            }
+            else if ( longCount == 1U )
+            {
+                spec->arg = LOGGER_BINARY_ARG_LONG;
+            }
+            else
+            {
+                spec->arg = LOGGER_BINARY_ARG_INT;
+            }
+            break;
+
+        case 'c':
+            /* %lc takes a wint_t, not worth supporting */
+            spec->arg = ( longCount == 0U ) ? LOGGER_BINARY_ARG_INT : LOGGER_BINARY_ARG_UNSUPPORTED;
+            break;
+
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+            spec->arg = longDouble ? LOGGER_BINARY_ARG_LDOUBLE : LOGGER_BINARY_ARG_DOUBLE;
+            break;
+
+        case 's':
+            spec->arg = ( longCount == 0U ) ? LOGGER_BINARY_ARG_STRING : LOGGER_BINARY_ARG_UNSUPPORTED;
+            break;
+
+        case 'p':
+            spec->arg = LOGGER_BINARY_ARG_POINTER;
+            break;
+
+        case '%':
+            spec->arg = LOGGER_BINARY_ARG_NONE;
+            break;
+
+        default:
+            /* %n, %ls, positional args etc */
+            spec->arg = LOGGER_BINARY_ARG_UNSUPPORTED;
+            break;
+    }
+
+    if ( *p != '\0' )
+    {
+        p++;
+    }
+
+    spec->length = (size_t)(p - fmt);
+
+    if ( spec->length >= LOGGER_BINARY_SPEC_SIZE )
+    {
+        spec->arg = LOGGER_BINARY_ARG_UNSUPPORTED;
+    }
+
+    return p;
+}
+
+static size_t logger_binary_argSize ( LOGGER_BINARY_ARG arg, uint32_t stringLen )
+{
+    size_t size = 0U;
+
+    switch ( arg )
+    {
+        case LOGGER_BINARY_ARG_INT:     size = sizeof(int); break;
+        case LOGGER_BINARY_ARG_LONG:    size = sizeof(long); break;
+        case LOGGER_BINARY_ARG_LLONG:   size = sizeof(long long); break;
+        case LOGGER_BINARY_ARG_INTMAX:  size = sizeof(intmax_t); break;
+        case LOGGER_BINARY_ARG_SIZE:    size = sizeof(size_t); break;
+        case LOGGER_BINARY_ARG_PTRDIFF: size = sizeof(ptrdiff_t); break;
+        case LOGGER_BINARY_ARG_DOUBLE:  size = sizeof(double); break;
+        case LOGGER_BINARY_ARG_LDOUBLE: size = sizeof(long double); break;
+        case LOGGER_BINARY_ARG_POINTER: size = sizeof(void*); break;
+
+        case LOGGER_BINARY_ARG_STRING:
+            size = sizeof(uint32_t) + ( ( stringLen == LOGGER_BINARY_STRING_NULL ) ? 0U : stringLen + 1U );
+            break;
+
+        default:
+            break;
+    }
+
+    return LOGGER_BINARY_ALIGNED(size);
+}
+
+static size_t logger_binary_readArg ( const unsigned char * data, LOGGER_BINARY_ARG arg, LOGGER_BINARY_VALUE * value )
+{
+    size_t size = 0U;
+
+    if ( arg == LOGGER_BINARY_ARG_STRING )
+    {
+        uint32_t len = 0U;
+
+        memcpy(&len, data, sizeof(len));
+
+        value->s = ( len == LOGGER_BINARY_STRING_NULL ) ? NULL : (const char *)&data[sizeof(len)];
+        size = logger_binary_argSize(arg, len);
+    }
+    else
+    {
+        /* aligned scalar sizes never exceed the union */
+        size = logger_binary_argSize(arg, 0U);
+        memcpy(value, data, size);
+    }
+
+    return size;
+}
+
+static void logger_binary_appendSpec ( LOGGER_RECORD_BUILDER * builder, size_t maxLen, const LOGGER_BINARY_SPEC * spec, const int * stars, LOGGER_BINARY_VALUE * value )
+{
+    char conv[LOGGER_BINARY_SPEC_SIZE];
+
+    memcpy(conv, spec->start, spec->length);
+    conv[spec->length] = '\0';
+
+    /* the value is passed through a matching vararg so printf sees the original type */
+#define LOGGER_BINARY_APPEND(v) \
+    do \
+    { \
+        if ( spec->starCount == 0U ) { logger_record_appendFormat(builder, maxLen, conv, (v)); } \
+        else if ( spec->starCount == 1U ) { logger_record_appendFormat(builder, maxLen, conv, stars[0], (v)); } \
+        else { logger_record_appendFormat(builder, maxLen, conv, stars[0], stars[1], (v)); } \
+    } while (0)
+
+    switch ( spec->arg )
+    {
+        case LOGGER_BINARY_ARG_INT:     LOGGER_BINARY_APPEND(value->i); break;
+        case LOGGER_BINARY_ARG_LONG:    LOGGER_BINARY_APPEND(value->l); break;
+        case LOGGER_BINARY_ARG_LLONG:   LOGGER_BINARY_APPEND(value->ll); break;
+        case LOGGER_BINARY_ARG_INTMAX:  LOGGER_BINARY_APPEND(value->im); break;
+        case LOGGER_BINARY_ARG_SIZE:    LOGGER_BINARY_APPEND(value->sz); break;
+        case LOGGER_BINARY_ARG_PTRDIFF: LOGGER_BINARY_APPEND(value->pd); break;
+        case LOGGER_BINARY_ARG_DOUBLE:  LOGGER_BINARY_APPEND(value->d); break;
+        case LOGGER_BINARY_ARG_LDOUBLE: LOGGER_BINARY_APPEND(value->ld); break;
+        case LOGGER_BINARY_ARG_POINTER: LOGGER_BINARY_APPEND(value->p); break;
+        /* NULL as the caller passed it, the C library prints it as it would have inline */
+        case LOGGER_BINARY_ARG_STRING:  LOGGER_BINARY_APPEND(value->s); break;
+        default: break;
+    }
+
+#undef LOGGER_BINARY_APPEND
+}
+
+/* printf-free, for a signal handler. Flags, width & precision are ignored, floating point is written to 6 decimals */
+static void logger_binary_appendPlain ( LOGGER_RECORD_BUILDER * builder, size_t maxLen, const LOGGER_BINARY_SPEC * spec, const LOGGER_BINARY_VALUE * value )
+{
+    char text[LOGGER_FORMAT_DOUBLE_CHARS];
+    size_t textLen = 0U;
+    char conversion = spec->start[spec->length-1U];
+    int64_t signedValue = 0;
+    uint64_t unsignedValue = 0U;
+
+    switch ( spec->arg )
+    {
+        case LOGGER_BINARY_ARG_INT:     signedValue = value->i;              unsignedValue = (unsigned int)value->i; break;
+        case LOGGER_BINARY_ARG_LONG:    signedValue = value->l;              unsignedValue = (unsigned long)value->l; break;
+        case LOGGER_BINARY_ARG_LLONG:   signedValue = value->ll;             unsignedValue = (unsigned long long)value->ll; break;
+        case LOGGER_BINARY_ARG_INTMAX:  signedValue = (int64_t)value->im;    unsignedValue = (uint64_t)value->im; break;
+        case LOGGER_BINARY_ARG_SIZE:    signedValue = (int64_t)value->sz;    unsignedValue = value->sz; break;
+        case LOGGER_BINARY_ARG_PTRDIFF: signedValue = value->pd;             unsignedValue = (uint64_t)value->pd; break;
+        case LOGGER_BINARY_ARG_POINTER: unsignedValue = (uintptr_t)value->p; conversion = 'p'; break;
+        case LOGGER_BINARY_ARG_DOUBLE:  textLen = logger_format_double(text, value->d, 6U); break;
+        case LOGGER_BINARY_ARG_LDOUBLE: textLen = logger_format_double(text, (double)value->ld, 6U); break;
+        case LOGGER_BINARY_ARG_STRING:
+            logger_record_appendString(builder, ( value->s != NULL ) ? value->s : "(null)", maxLen);
+            return;
+        default:
+            return;
+    }
+
+    if ( textLen != 0U )
+    {
+        /* floating point, already written */
+    }
+    else if ( conversion == 'c' )
+    {
+        text[0] = (char)unsignedValue;
+        textLen = 1U;
+    }
+    else if ( conversion == 'p' )
+    {
+        text[0] = '0';
+        text[1] = 'x';
+        textLen = 2U + logger_format_radix(&text[2], unsignedValue, 4U, false);
+    }
+    else if ( ( conversion == 'x' ) || ( conversion == 'X' ) || ( conversion == 'o' ) )
+    {
+        textLen = logger_format_radix(text, unsignedValue, ( conversion == 'o' ) ? 3U : 4U, ( conversion == 'X' ));
+    }
+    else if ( ( conversion == 'd' ) || ( conversion == 'i' ) )
+    {
+        textLen = logger_format_int64(text, signedValue);
+    }
+    else
+    {
+        textLen = logger_format_uint64(text, unsignedValue);
+    }
+
+    logger_record_appendBytes(builder, text, ( textLen < maxLen ) ? textLen : maxLen);
+}
+
+/* fills in record, the message is written to builder. signalSafe formats without printf */
+static void logger_binary_formatEntry ( LOGGER_RECORD_BUILDER * builder, const LOGGER_BINARY_ENTRY * entry, LOGGER_RECORD * record, bool signalSafe )
+{
+    const unsigned char * data = (const unsigned char *)entry + LOGGER_BINARY_ALIGNED(sizeof(LOGGER_BINARY_ENTRY));
+    const char * fmt = entry->fmt;
+
+    if ( fmt == NULL )
+    {
+        logger_binary_storedEntry(builder, entry, record);
+        return;
+    }
+
+    const LOGGER_CALLSITE * callsite = entry->callsite;
+    const LOGGER_CALLSITE_PRV * resolved = logger_callsite_get(callsite);
+
+    record->ticks = entry->ticks;
+    record->level = callsite->level;
+    record->outputs = entry->outputs;
+
+    if ( resolved != NULL )
+    {
+        record->header = resolved->header;
+        record->headerLen = resolved->headerLen;
+    }
+    else
+    {
+        record->header = NULL;
+        record->headerLen = 0U;
+        logger_record_appendHeader(builder, callsite->fileName, callsite->lineNumber, callsite->functionName, callsite->level);
+    }
+
+    size_t messageEnd = builder->length + LOGGER_MESSAGE_MAX_SIZE;
+
+    while ( ( fmt != NULL ) && ( *fmt != '\0' ) && ( builder->length < messageEnd ) )
+    {
+        if ( *fmt != '%' )
+        {
+            logger_record_appendChar(builder, *fmt);
+            fmt++;
+        }
+        else
+        {
+            LOGGER_BINARY_SPEC spec;
+            LOGGER_BINARY_VALUE value;
+            int stars[2] = { 0, 0 };
+
+            fmt = logger_binary_parseSpec(fmt, &spec);
+
+            if ( spec.arg == LOGGER_BINARY_ARG_NONE )
+            {
+                logger_record_appendChar(builder, '%');
+                continue;
+            }
+
+            for ( uint32_t i=0U; i<spec.starCount; i++ )
+            {
+                data += logger_binary_readArg(data, LOGGER_BINARY_ARG_INT, &value);
+                stars[i] = value.i;
+            }
+
+            data += logger_binary_readArg(data, spec.arg, &value);
+
+            if ( signalSafe )
+            {
+                logger_binary_appendPlain(builder, messageEnd - builder->length, &spec, &value);
+            }
+            else
+            {
+                logger_binary_appendSpec(builder, messageEnd - builder->length, &spec, stars, &value);
+            }
+        }
+    }
+
+    record->messageLen = logger_record_end(builder);
+    record->message = builder->buffer;
+    record->fields = NULL;
+    record->fieldsLen = 0U;
+}
+
+/* copied out of the buffer like a formatted message, the space may be reused once the entry is consumed */
+static void logger_binary_storedEntry ( LOGGER_RECORD_BUILDER * builder, const LOGGER_BINARY_ENTRY * entry, LOGGER_RECORD * record )
+{
+    const LOGGER_BINARY_STORED * stored = (const LOGGER_BINARY_STORED *)((const unsigned char *)entry + LOGGER_BINARY_ALIGNED(sizeof(LOGGER_BINARY_ENTRY)));
+    const char * bytes = (const char *)stored + LOGGER_BINARY_ALIGNED(sizeof(LOGGER_BINARY_STORED));
+
+    record->ticks = entry->ticks;
+    record->level = stored->level;
+    record->outputs = entry->outputs;
+    record->header = stored->header;
+    record->headerLen = stored->headerLen;
+
+    logger_record_appendBytes(builder, bytes, stored->messageLen + stored->fieldsLen);
+
+    size_t length = logger_record_end(builder);
+
+    record->message = builder->buffer;
+    record->messageLen = ( length < stored->messageLen ) ? length : stored->messageLen;
+
+    /* a cut short field would not decode */
+    bool whole = ( length == stored->messageLen + stored->fieldsLen ) && ( stored->fieldsLen != 0U );
+
+    record->fields = whole ? (const uint8_t *)&builder->buffer[stored->messageLen] : NULL;
+    record->fieldsLen = whole ? stored->fieldsLen : 0U;
+}
+
+static LOGGER_STATUS logger_binary_sendRecord ( const LOGGER_RECORD * record )
+{
+    return (*f_drainHandler)(record);
+}
+
+void logger_binary_setEnabled ( bool enabled )
+{
+    __atomic_store_n(&f_binaryEnabled, enabled, __ATOMIC_RELEASE);
+}
+
+bool logger_binary_isEnabled ( void )
+{
+    return __atomic_load_n(&f_binaryEnabled, __ATOMIC_RELAXED);
+}
+
+static bool logger_binary_collect ( const char * fmt, va_list args, LOGGER_BINARY_ARGS * collected )
+{
+    LOGGER_BINARY_ARG * argTypes = collected->types;
+    LOGGER_BINARY_VALUE * argValues = collected->values;
+    uint32_t argCount = 0U;
+    size_t size = LOGGER_BINARY_ALIGNED(sizeof(LOGGER_BINARY_ENTRY));
+
+    /* pull every argument off the va_list typed by the format */
+    for ( const char * p=fmt; ( p != NULL ) && ( *p != '\0' ); )
+    {
+        if ( *p != '%' )
+        {
+            p++;
+            continue;
+        }
+
+        LOGGER_BINARY_SPEC spec;
+
+        p = logger_binary_parseSpec(p, &spec);
+
+        if ( spec.arg == LOGGER_BINARY_ARG_NONE )
+        {
+            continue;
+        }
+
+        if ( ( spec.arg == LOGGER_BINARY_ARG_UNSUPPORTED ) || ( argCount+spec.starCount+1U > LOGGER_BINARY_MAX_ARGS ) )
+        {
+            return false;
+        }
+
+        int precision = spec.precision;
+
+        for ( uint32_t i=0U; i<spec.starCount; i++ )
+        {
+            argTypes[argCount] = LOGGER_BINARY_ARG_INT;
+            argValues[argCount].i = va_arg(args, int);
+            argCount += 1U;
+        }
+
+        /* a negative * precision is taken as if it were left out */
+        if ( spec.starPrecision )
+        {
+            precision = argValues[argCount-1U].i;
+        }
+
+        argTypes[argCount] = spec.arg;
+        collected->lengths[argCount] = 0U;
+
+        switch ( spec.arg )
+        {
+            case LOGGER_BINARY_ARG_INT:     argValues[argCount].i = va_arg(args, int); break;
+            case LOGGER_BINARY_ARG_LONG:    argValues[argCount].l = va_arg(args, long); break;
+            case LOGGER_BINARY_ARG_LLONG:   argValues[argCount].ll = va_arg(args, long long); break;
+            case LOGGER_BINARY_ARG_INTMAX:  argValues[argCount].im = va_arg(args, intmax_t); break;
+            case LOGGER_BINARY_ARG_SIZE:    argValues[argCount].sz = va_arg(args, size_t); break;
+            case LOGGER_BINARY_ARG_PTRDIFF: argValues[argCount].pd = va_arg(args, ptrdiff_t); break;
+            case LOGGER_BINARY_ARG_DOUBLE:  argValues[argCount].d = va_arg(args, double); break;
+            case LOGGER_BINARY_ARG_LDOUBLE: argValues[argCount].ld = va_arg(args, long double); break;
+            case LOGGER_BINARY_ARG_STRING:  argValues[argCount].s = va_arg(args, const char *); break;
+            case LOGGER_BINARY_ARG_POINTER: argValues[argCount].p = va_arg(args, void *); break;
+            default: break;
+        }
+
+        /* a string is read no further than its precision, it need not be terminated within it */
+        if ( spec.arg == LOGGER_BINARY_ARG_STRING )
+        {
+            size_t limit = ( ( precision >= 0 ) && ( (size_t)precision < LOGGER_BINARY_STRING_MAX ) ) ? (size_t)precision : LOGGER_BINARY_STRING_MAX;
+
+            collected->lengths[argCount] = ( argValues[argCount].s != NULL ) ? (uint32_t)strnlen(argValues[argCount].s, limit) : LOGGER_BINARY_STRING_NULL;
+        }
+
+        argCount += 1U;
+    }
+
+    for ( uint32_t i=0U; i<argCount; i++ )
+    {
+        size += logger_binary_argSize(argTypes[i], collected->lengths[i]);
+    }
+
+    collected->count = argCount;
+    collected->size = size;
+
+    return true;
+}
+
+static void logger_binary_writeEntry ( unsigned char * at, const LOGGER_CALLSITE * callsite, uint32_t outputs, const char * fmt, const LOGGER_BINARY_ARGS * collected )
+{
+    LOGGER_BINARY_ENTRY * entry = (LOGGER_BINARY_ENTRY *)at;
+    unsigned char * data = &at[LOGGER_BINARY_ALIGNED(sizeof(LOGGER_BINARY_ENTRY))];
+
+    entry->size = (uint32_t)collected->size;
+    entry->outputs = outputs;
+    entry->fmt = ( fmt != NULL ) ? fmt : ""; /* a NULL format prints nothing, NULL marks a stored record */
+    entry->callsite = callsite;
+    entry->ticks = logger_clock_now();
+
+    for ( uint32_t i=0U; i<collected->count; i++ )
+    {
+        const LOGGER_BINARY_VALUE * value = &collected->values[i];
+        uint32_t len = collected->lengths[i];
+        size_t size = logger_binary_argSize(collected->types[i], len);
+
+        if ( collected->types[i] == LOGGER_BINARY_ARG_STRING )
+        {
+            if ( len != LOGGER_BINARY_STRING_NULL )
+            {
+                memcpy(&data[sizeof(len)], value->s, len);
+                data[sizeof(len)+len] = '\0';
+            }
+
+            memcpy(data, &len, sizeof(len));
+        }
+        else
+        {
+            /* aligned scalar sizes never exceed the union */
+            memcpy(data, value, size);
+        }
+
+        data += size;
+    }
+}
+
+/* space for size bytes at the head of buffer, *nextHead is the head to publish once written. NULL when the record
+   was dropped by the backpressure= policy of its outputs (*dropped set) or capture was switched off while waiting */
+static unsigned char * logger_binary_reserve ( LOGGER_BINARY_BUFFER * buffer, size_t size, LOGGER_LEVEL level, uint32_t outputs, size_t * nextHead, bool * dropped )
+{
+    size_t head = buffer->head;
+    size_t offset = head & (LOGGER_BINARY_BUFFER_SIZE-1U);
+    size_t skip = ( offset+size > LOGGER_BINARY_BUFFER_SIZE ) ? LOGGER_BINARY_BUFFER_SIZE-offset : 0U;
+    LOGGER_BACKPRESSURE policy = logger_output_capturePolicy(level, outputs);
+    bool keep = ( ( level & LOGGER_BACKPRESSURE_KEEP ) != 0U );
+
+    *dropped = false;
+
+    if ( ( policy == LOGGER_BACKPRESSURE_DROP_LEVEL ) && ( keep == false ) &&
+         logger_backpressure_shed(level, head - __atomic_load_n(&buffer->tail, __ATOMIC_ACQUIRE), LOGGER_BINARY_BUFFER_SIZE) )
+    {
+        logger_output_dropped(level, outputs);
+        *dropped = true;
+        return NULL;
+    }
+
+    /* wait for the drain thread if the buffer is full */
+    while ( head+skip+size - __atomic_load_n(&buffer->tail, __ATOMIC_ACQUIRE) > LOGGER_BINARY_BUFFER_SIZE )
+    {
+        if ( logger_binary_isEnabled() == false )
+        {
+            return NULL;
+        }
+
+        /* only the drain thread moves the tail, every dropping policy drops the newest here */
+        if ( ( policy != LOGGER_BACKPRESSURE_BLOCK ) && ( keep == false ) )
+        {
+            logger_output_dropped(level, outputs);
+            *dropped = true;
+            return NULL;
+        }
+
+        logger_async_wakeWriter();
+        sched_yield();
+    }
+
+    if ( skip != 0U )
+    {
+        LOGGER_BINARY_ENTRY * marker = (LOGGER_BINARY_ENTRY *)&buffer->data[offset];
+        marker->size = 0U;
+        head += skip;
+        offset = 0U;
+    }
+
+    *nextHead = head+size;
+
+    return &buffer->data[offset];
+}
+
+bool logger_binary_capture ( const LOGGER_CALLSITE * callsite, uint32_t outputs, const char * fmt, va_list args )
+{
+    LOGGER_BINARY_ARGS collected;
+    size_t nextHead = 0U;
+    bool dropped = false;
+
+    if ( logger_binary_collect(fmt, args, &collected) == false )
+    {
+        return false;
+    }
+
+    LOGGER_BINARY_BUFFER * buffer = logger_binary_threadBuffer();
+
+    /* room for the record plus a possible skip marker */
+    if ( ( buffer == NULL ) || ( collected.size > LOGGER_BINARY_BUFFER_SIZE/2U ) )
+    {
+        return false;
+    }
+
+    unsigned char * at = logger_binary_reserve(buffer, collected.size, callsite->level, outputs, &nextHead, &dropped);
+
+    if ( at == NULL )
+    {
+        /* left to the caller when capture is off */
+        return dropped;
+    }
+
+    logger_binary_writeEntry(at, callsite, outputs, fmt, &collected);
+
+    __atomic_store_n(&buffer->head, nextHead, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+bool logger_binary_captureRecord ( const LOGGER_CALLSITE * callsite, const LOGGER_RECORD * record )
+{
+    size_t dataOffset = LOGGER_BINARY_ALIGNED(sizeof(LOGGER_BINARY_ENTRY)) + LOGGER_BINARY_ALIGNED(sizeof(LOGGER_BINARY_STORED));
+    size_t size = LOGGER_BINARY_ALIGNED(dataOffset + record->messageLen + record->fieldsLen);
+    size_t nextHead = 0U;
+    bool dropped = false;
+
+    LOGGER_BINARY_BUFFER * buffer = logger_binary_threadBuffer();
+
+    if ( ( buffer == NULL ) || ( size > LOGGER_BINARY_BUFFER_SIZE/2U ) )
+    {
+        return false;
+    }
+
+    unsigned char * at = logger_binary_reserve(buffer, size, record->level, record->outputs, &nextHead, &dropped);
+
+    if ( at == NULL )
+    {
+        return dropped;
+    }
+
+    LOGGER_BINARY_ENTRY * entry = (LOGGER_BINARY_ENTRY *)at;
+    LOGGER_BINARY_STORED * stored = (LOGGER_BINARY_STORED *)&at[LOGGER_BINARY_ALIGNED(sizeof(LOGGER_BINARY_ENTRY))];
+
+    entry->size = (uint32_t)size;
+    entry->outputs = record->outputs;
+    entry->fmt = NULL;
+    entry->callsite = callsite;
+    entry->ticks = record->ticks;
+
+    stored->level = record->level;
+    stored->header = record->header;
+    stored->headerLen = record->headerLen;
+    stored->messageLen = record->messageLen;
+    stored->fieldsLen = record->fieldsLen;
+
+    memcpy(&at[dataOffset], record->message, record->messageLen);
+
+    if ( record->fieldsLen != 0U )
+    {
+        memcpy(&at[dataOffset + record->messageLen], record->fields, record->fieldsLen);
+    }
+
+    __atomic_store_n(&buffer->head, nextHead, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+uint32_t logger_binary_drain ( LOGGER_RECORD_SEND handler )
+{
+    uint32_t sentCount = 0U;
+    bool dedupEnabled = logger_dedup_isEnabled();
+
+    f_drainHandler = handler;
+
+    for ( LOGGER_BINARY_BUFFER * buffer = __atomic_load_n(&f_binaryBuffers, __ATOMIC_ACQUIRE); buffer != NULL; buffer = buffer->next )
+    {
+        size_t tail = buffer->tail;
+        size_t head = __atomic_load_n(&buffer->head, __ATOMIC_ACQUIRE);
+
+        if ( dedupEnabled && ( buffer->dedup == NULL ) && ( tail != head ) )
+        {
+            /* each buffer is one thread's stream, repeats are compared within it */
+            buffer->dedup = logger_dedup_create(logger_binary_sendRecord);
+        }
+
+        /* a crash handler sends the rest, taken now they would be on no queue it has yet to read */
+        while ( ( tail != head ) && ( logger_crash_isFlushing() == false ) )
+        {
+            size_t offset = tail & (LOGGER_BINARY_BUFFER_SIZE-1U);
+            const LOGGER_BINARY_ENTRY * entry = (const LOGGER_BINARY_ENTRY *)&buffer->data[offset];
+
+            if ( entry->size == 0U )
+            {
+                /* skip marker, record continues at the buffer start */
+                tail += LOGGER_BINARY_BUFFER_SIZE - offset;
+                continue;
+            }
+
+            char completeMessage[LOGGER_RECORD_INLINE_SIZE];
+            LOGGER_RECORD_BUILDER builder;
+            LOGGER_RECORD record;
+
+            logger_record_beginSpill(&builder, completeMessage, sizeof(completeMessage));
+            logger_binary_formatEntry(&builder, entry, &record, false);
+
+            if ( builder.truncated )
+            {
+                logger_metrics_truncated();
+            }
+
+            const LOGGER_CALLSITE * callsite = entry->callsite;
+            bool stored = ( entry->fmt == NULL );
+
+            tail += entry->size;
+
+            /* release the space before the (possibly slow) send */
+            __atomic_store_n(&buffer->tail, tail, __ATOMIC_RELEASE);
+
+            /* only resolved callsites have a static header to report repeats under */
+            /* a stored record was already compared by its own thread */
+            if ( ( dedupEnabled == false ) || ( buffer->dedup == NULL ) || ( record.header == NULL ) || stored ||
+                 logger_dedup_filter(buffer->dedup, callsite, &record) )
+            {
+                (void)logger_binary_sendRecord(&record);
+            }
+            else
+            {
+                logger_metrics_deduplicated();
+            }
+
+            logger_record_release(&builder);
+
+            sentCount += 1U;
+        }
+
+        if ( buffer->dedup != NULL )
+        {
+            /* runs held past the timeout are reported even if the thread has gone quiet */
+            logger_dedup_expire(buffer->dedup, logger_clock_now());
+        }
+
+        if ( __atomic_load_n(&buffer->state, __ATOMIC_ACQUIRE) == LOGGER_BINARY_STATE_RETIRED )
+        {
+            uint32_t expected = LOGGER_BINARY_STATE_RETIRED;
+
+            /* the thread is gone, nothing more will be written */
+            if ( buffer->tail == __atomic_load_n(&buffer->head, __ATOMIC_ACQUIRE) )
+            {
+                if ( buffer->dedup != NULL )
+                {
+                    logger_dedup_flush(buffer->dedup);
+                }
+
+                __atomic_compare_exchange_n(&buffer->state, &expected, LOGGER_BINARY_STATE_FREE, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    return sentCount;
+}
+
+void logger_binary_flushRepeats ( LOGGER_RECORD_SEND handler )
+{
+    f_drainHandler = handler;
+
+    for ( LOGGER_BINARY_BUFFER * buffer = __atomic_load_n(&f_binaryBuffers, __ATOMIC_ACQUIRE); buffer != NULL; buffer = buffer->next )
+    {
+        if ( buffer->dedup != NULL )
+        {
+            logger_dedup_flush(buffer->dedup);
+        }
+    }
+}
+
+static void logger_binary_recorderExit ( void * recorder )
+{
+    __atomic_store_n(&((LOGGER_BINARY_RECORDER *)recorder)->state, LOGGER_BINARY_STATE_FREE, __ATOMIC_RELEASE);
+}
+
+static void logger_binary_createRecorderKey ( void )
+{
+    pthread_key_create(&f_recorderKey, logger_binary_recorderExit);
+}
+
+static LOGGER_BINARY_RECORDER * logger_binary_threadRecorder ( void )
+{
+    if ( f_threadRecorder != NULL )
+    {
+        return f_threadRecorder;
+    }
+
+    size_t size = __atomic_load_n(&f_recorderSize, __ATOMIC_RELAXED);
+
+    if ( size == 0U )
+    {
+        return NULL;
+    }
+
+    pthread_once(&f_recorderKeyOnce, logger_binary_createRecorderKey);
+
+    /* take over a recorder left by an exited thread, its records stay until overwritten */
+    LOGGER_BINARY_RECORDER * recorder = __atomic_load_n(&f_recorders, __ATOMIC_ACQUIRE);
+
+    while ( recorder != NULL )
+    {
+        uint32_t expected = LOGGER_BINARY_STATE_FREE;
+
+        if ( __atomic_compare_exchange_n(&recorder->state, &expected, LOGGER_BINARY_STATE_OWNED, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) )
+        {
+            break;
+        }
+
+        recorder = recorder->next;
+    }
+
+    if ( recorder == NULL )
+    {
+        recorder = logger_mem_alloc(sizeof(LOGGER_BINARY_RECORDER));
+
+        if ( recorder == NULL )
+        {
+            LOGPRINT_LOG_E("Malloc failure !!!");
+            return NULL;
+        }
+
+        recorder->data = logger_mem_alloc(size);
+
+        if ( recorder->data == NULL )
+        {
+            LOGPRINT_LOG_E("Malloc failure !!!");
+            logger_mem_free(recorder);
+            return NULL;
+        }
+
+        recorder->state = LOGGER_BINARY_STATE_OWNED;
+        recorder->size = size;
+        recorder->head = 0U;
+        recorder->tail = 0U;
+        recorder->dumped = 0U;
+        recorder->next = __atomic_load_n(&f_recorders, __ATOMIC_RELAXED);
+
+        while ( __atomic_compare_exchange_n(&f_recorders, &recorder->next, recorder, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED) == false )
+        {
+            /* recorder->next reloaded by the failed exchange */
+        }
+    }
+
+    pthread_setspecific(f_recorderKey, recorder);
+
+    f_threadRecorder = recorder;
+
+    return recorder;
+}
+
+/* copy the whole records not yet dumped into out by way of snapshot, a copy of the ring. Returns bytes copied */
+static size_t logger_binary_recorderCopy ( LOGGER_BINARY_RECORDER * recorder, unsigned char * snapshot, unsigned char * out, size_t outSize )
+{
+    size_t mask = recorder->size - 1U;
+    size_t head = __atomic_load_n(&recorder->head, __ATOMIC_ACQUIRE);
+
+    memcpy(snapshot, recorder->data, recorder->size);
+
+    /* pairs with the owner moving tail before it reuses the bytes, so nothing from the tail read after the copy
+       up to head was overwritten while it was copied */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    size_t pos = __atomic_load_n(&recorder->tail, __ATOMIC_RELAXED);
+    size_t copied = 0U;
+
+    pos = ( pos > recorder->dumped ) ? pos : recorder->dumped;
+
+    while ( pos < head )
+    {
+        size_t offset = pos & mask;
+        const LOGGER_BINARY_ENTRY * entry = (const LOGGER_BINARY_ENTRY *)&snapshot[offset];
+        size_t size = entry->size;
+
+        if ( size == 0U )
+        {
+            pos += recorder->size - offset;
+            continue;
+        }
+
+        if ( ( size < LOGGER_BINARY_ALIGNED(sizeof(LOGGER_BINARY_ENTRY)) ) || ( size > recorder->size - offset ) ||
+             ( copied+size > outSize ) )
+        {
+            break;
+        }
+
+        memcpy(&out[copied], entry, size);
+
+        copied += size;
+        pos += size;
+    }
+
+    recorder->dumped = head;
+
+    return copied;
+}
+
+/* oldest first. Records of one thread were copied in order, so the copy address breaks ties */
+static int logger_binary_compareTicks ( const void * a, const void * b )
+{
+    const LOGGER_BINARY_ENTRY * entryA = *(const LOGGER_BINARY_ENTRY * const *)a;
+    const LOGGER_BINARY_ENTRY * entryB = *(const LOGGER_BINARY_ENTRY * const *)b;
+
+    if ( entryA->ticks != entryB->ticks )
+    {
+        return ( entryA->ticks < entryB->ticks ) ? -1 : 1;
+    }
+
+    return ( entryA < entryB ) ? -1 : ( ( entryA > entryB ) ? 1 : 0 );
+}
+
+static void logger_binary_sendNote ( LOGGER_RECORD_SEND handler, const char * fmt, uint32_t count )
+{
+    char text[LOGGER_MAX_LOGGER_CHARS];
+    LOGGER_RECORD_BUILDER builder;
+    LOGGER_RECORD record;
+
+    logger_record_begin(&builder, text, sizeof(text));
+    logger_record_appendHeader(&builder, __FILE__, __LINE__, __FUNCTION__, LOGGER_LEVEL_EVENT);
+    logger_record_appendFormat(&builder, LOGGER_MESSAGE_SIZE-1U, fmt, count);
+
+    record.ticks = logger_clock_now();
+    record.level = LOGGER_LEVEL_EVENT;
+    record.header = NULL;
+    record.headerLen = 0U;
+    record.messageLen = logger_record_end(&builder);
+    record.message = builder.buffer;
+    record.fields = NULL;
+    record.fieldsLen = 0U;
+    record.outputs = 0U;
+
+    (void)(*handler)(&record);
+}
+
+void logger_binary_recorderFromIni ( LOGGER_INI_SECTIONHANDLE paramBag )
+{
+    char *recorderStr = NULL;
+    size_t recorderStrLen = 0U;
+    size_t kiloBytes = 0U;
+
+    logger_ini_sectionRetrieveValueFromKey(paramBag, "recorder", strlen("recorder"), &recorderStr, &recorderStrLen);
+
+    if ( ( recorderStr != NULL ) && ( atoi(recorderStr) > 0 ) )
+    {
+        kiloBytes = (size_t)atoi(recorderStr);
+    }
+
+    logger_binary_setRecorderSize(kiloBytes * 1024U);
+}
+
+void logger_binary_setRecorderSize ( size_t bytes )
+{
+    size_t size = 0U;
+
+    if ( bytes != 0U )
+    {
+        /* big enough for the largest record it accepts */
+        size = 2U * LOGGER_BINARY_ALIGNED(sizeof(LOGGER_BINARY_ENTRY)) * LOGGER_BINARY_MAX_ARGS;
+
+        while ( size < bytes )
+        {
+            size <<= 1U;
+        }
+    }
+
+    __atomic_store_n(&f_recorderSize, size, __ATOMIC_RELAXED);
+}
+
+bool logger_binary_isRecording ( void )
+{
+    return ( __atomic_load_n(&f_recorderSize, __ATOMIC_RELAXED) != 0U );
+}
+
+void logger_binary_record ( const LOGGER_CALLSITE * callsite, uint32_t outputs, const char * fmt, va_list args )
+{
+    LOGGER_BINARY_RECORDER * recorder = logger_binary_threadRecorder();
+    LOGGER_BINARY_ARGS collected;
+
+    if ( ( recorder == NULL ) || ( logger_binary_collect(fmt, args, &collected) == false ) ||
+         ( collected.size > recorder->size/2U ) )
+    {
+        return;
+    }
+
+    size_t mask = recorder->size - 1U;
+    size_t size = collected.size;
+    size_t head = recorder->head;
+    size_t offset = head & mask;
+    size_t skip = ( offset+size > recorder->size ) ? recorder->size-offset : 0U;
+    size_t tail = recorder->tail;
+
+    /* forget the oldest records until the new one fits */
+    while ( head+skip+size - tail > recorder->size )
+    {
+        const LOGGER_BINARY_ENTRY * oldest = (const LOGGER_BINARY_ENTRY *)&recorder->data[tail & mask];
+
+        tail += ( oldest->size != 0U ) ? oldest->size : recorder->size - ( tail & mask );
+    }
+
+    if ( tail != recorder->tail )
+    {
+        __atomic_store_n(&recorder->tail, tail, __ATOMIC_RELAXED);
+
+        /* a dump copying those bytes sees the new tail & discards its copy */
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+
+    if ( skip != 0U )
+    {
+        LOGGER_BINARY_ENTRY * marker = (LOGGER_BINARY_ENTRY *)&recorder->data[offset];
+        marker->size = 0U;
+        head += skip;
+        offset = 0U;
+    }
+
+    logger_binary_writeEntry(&recorder->data[offset], callsite, outputs, fmt, &collected);
+
+    __atomic_store_n(&recorder->head, head+size, __ATOMIC_RELEASE);
+}
+
+uint32_t logger_binary_dumpRecorder ( LOGGER_RECORD_SEND handler )
+{
+    uint32_t count = 0U;
+    size_t total = 0U;
+
+    pthread_mutex_lock(&f_recorderDumpMutex);
+
+    size_t largest = 0U;
+
+    /* the list only grows at the front, a recorder added after this is not visited */
+    LOGGER_BINARY_RECORDER * recorders = __atomic_load_n(&f_recorders, __ATOMIC_ACQUIRE);
+
+    for ( LOGGER_BINARY_RECORDER * recorder = recorders; recorder != NULL; recorder = recorder->next )
+    {
+        total += recorder->size;
+        largest = ( recorder->size > largest ) ? recorder->size : largest;
+    }
+
+    LOGGER_MEM_MARK mark = logger_mem_scratchMark();
+    unsigned char * copies = ( total != 0U ) ? logger_mem_scratchAlloc(total) : NULL;
+    unsigned char * snapshot = ( total != 0U ) ? logger_mem_scratchAlloc(largest) : NULL;
+
+    if ( ( copies != NULL ) && ( snapshot != NULL ) )
+    {
+        size_t copied = 0U;
+
+        for ( LOGGER_BINARY_RECORDER * recorder = recorders; recorder != NULL; recorder = recorder->next )
+        {
+            copied += logger_binary_recorderCopy(recorder, snapshot, &copies[copied], total - copied);
+        }
+
+        for ( size_t offset=0U; offset<copied; offset+=((const LOGGER_BINARY_ENTRY *)&copies[offset])->size )
+        {
+            count += 1U;
+        }
+
+        const LOGGER_BINARY_ENTRY ** entries = ( count != 0U ) ? logger_mem_scratchAlloc(count * sizeof(*entries)) : NULL;
+
+        if ( entries != NULL )
+        {
+            size_t offset = 0U;
+
+            for ( uint32_t i=0U; i<count; i++ )
+            {
+                entries[i] = (const LOGGER_BINARY_ENTRY *)&copies[offset];
+                offset += entries[i]->size;
+            }
+
+            /* one timeline across every thread */
+            qsort(entries, count, sizeof(*entries), logger_binary_compareTicks);
+
+            logger_binary_sendNote(handler, "flight recorder: %u records", count);
+
+            for ( uint32_t i=0U; i<count; i++ )
+            {
+                char completeMessage[LOGGER_RECORD_INLINE_SIZE];
+                LOGGER_RECORD_BUILDER builder;
+                LOGGER_RECORD record;
+
+                logger_record_beginSpill(&builder, completeMessage, sizeof(completeMessage));
+                logger_binary_formatEntry(&builder, entries[i], &record, false);
+
+                (void)(*handler)(&record);
+
+                logger_record_release(&builder);
+            }
+
+            logger_binary_sendNote(handler, "flight recorder: end of %u records", count);
+        }
+    }
+
+    logger_mem_scratchRelease(mark);
+
+    pthread_mutex_unlock(&f_recorderDumpMutex);
+
+    return count;
+}
+
+/* as logger_binary_sendNote without printf, count follows text unless it is 0 */
+static void logger_binary_sendNoteSafe ( LOGGER_RECORD_SEND handler, const char * text, uint32_t count )
+{
+    char message[LOGGER_MAX_LOGGER_CHARS];
+    char countText[LOGGER_FORMAT_INT32_CHARS];
+    LOGGER_RECORD_BUILDER builder;
+    LOGGER_RECORD record;
+
+    logger_record_begin(&builder, message, sizeof(message));
+    logger_record_appendHeader(&builder, __FILE__, __LINE__, __FUNCTION__, LOGGER_LEVEL_EVENT);
+    logger_record_appendString(&builder, text, LOGGER_MESSAGE_SIZE-1U);
+
+    if ( count != 0U )
+    {
+        logger_record_appendBytes(&builder, countText, logger_format_uint32(countText, count));
+    }
+
+    record.ticks = logger_clock_now();
+    record.level = LOGGER_LEVEL_EVENT;
+    record.header = NULL;
+    record.headerLen = 0U;
+    record.messageLen = logger_record_end(&builder);
+    record.message = builder.buffer;
+    record.fields = NULL;
+    record.fieldsLen = 0U;
+    record.outputs = 0U;
+
+    (void)(*handler)(&record);
+}
+
+/* format & send the entry at pos of a buffer or recorder, read in place. False when it is not a whole entry or
+   tail has moved past it while it was formatted, so it may have been overwritten */
+static bool logger_binary_crashEntry ( LOGGER_RECORD_SEND handler, const unsigned char * data, size_t dataSize, size_t pos, const size_t * tail )
+{
+    size_t offset = pos & (dataSize-1U);
+    const LOGGER_BINARY_ENTRY * entry = (const LOGGER_BINARY_ENTRY *)&data[offset];
+
+    if ( ( entry->size < LOGGER_BINARY_ALIGNED(sizeof(LOGGER_BINARY_ENTRY)) ) || ( entry->size > dataSize - offset ) ||
+         ( entry->callsite == NULL ) )
+    {
+        return false;
+    }
+
+    char completeMessage[LOGGER_MAX_LOGGER_CHARS];
+    LOGGER_RECORD_BUILDER builder;
+    LOGGER_RECORD record;
+
+    /* on the stack only, long messages are cut short */
+    logger_record_begin(&builder, completeMessage, sizeof(completeMessage));
+    logger_binary_formatEntry(&builder, entry, &record, true);
+
+    if ( __atomic_load_n(tail, __ATOMIC_ACQUIRE) > pos )
+    {
+        return false;
+    }
+
+    (void)(*handler)(&record);
+
+    return true;
+}
+
+uint32_t logger_binary_crashDrain ( LOGGER_RECORD_SEND handler )
+{
+    uint32_t sentCount = 0U;
+
+    for ( LOGGER_BINARY_BUFFER * buffer = __atomic_load_n(&f_binaryBuffers, __ATOMIC_ACQUIRE); buffer != NULL; buffer = buffer->next )
+    {
+        size_t head = __atomic_load_n(&buffer->head, __ATOMIC_ACQUIRE);
+
+        /* the writer thread may still be draining, tail is only read */
+        for ( size_t tail = __atomic_load_n(&buffer->tail, __ATOMIC_ACQUIRE); tail < head; )
+        {
+            size_t offset = tail & (LOGGER_BINARY_BUFFER_SIZE-1U);
+            uint32_t size = ((const LOGGER_BINARY_ENTRY *)&buffer->data[offset])->size;
+
+            if ( size == 0U )
+            {
+                tail += LOGGER_BINARY_BUFFER_SIZE - offset;
+            }
+            else if ( logger_binary_crashEntry(handler, buffer->data, LOGGER_BINARY_BUFFER_SIZE, tail, &buffer->tail) )
+            {
+                tail += size;
+                sentCount += 1U;
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+
+    uint32_t recordedCount = 0U;
+
+    for ( LOGGER_BINARY_RECORDER * recorder = __atomic_load_n(&f_recorders, __ATOMIC_ACQUIRE); recorder != NULL; recorder = recorder->next )
+    {
+        size_t mask = recorder->size - 1U;
+        size_t head = __atomic_load_n(&recorder->head, __ATOMIC_ACQUIRE);
+        size_t pos = __atomic_load_n(&recorder->tail, __ATOMIC_ACQUIRE);
+
+        pos = ( pos > recorder->dumped ) ? pos : recorder->dumped;
+
+        if ( ( pos < head ) && ( recordedCount == 0U ) )
+        {
+            logger_binary_sendNoteSafe(handler, "flight recorder at crash, oldest first per thread", 0U);
+        }
+
+        /* one thread at a time, oldest first. Read in place, the owner may be overwriting the oldest */
+        while ( pos < head )
+        {
+            size_t offset = pos & mask;
+            uint32_t size = ((const LOGGER_BINARY_ENTRY *)&recorder->data[offset])->size;
+
+            if ( size == 0U )
+            {
+                pos += recorder->size - offset;
+            }
+            else if ( logger_binary_crashEntry(handler, recorder->data, recorder->size, pos, &recorder->tail) )
+            {
+                pos += size;
+                recordedCount += 1U;
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+
+    if ( recordedCount != 0U )
+    {
+        logger_binary_sendNoteSafe(handler, "flight recorder: end of records, ", recordedCount);
+    }
+
+    return sentCount + recordedCount;
+}
@@ -0,0 +1,164 @@
+/**
+ @file
+ Diagnostics print library - deferred binary capture
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#ifndef _LOGGER_BINARY_H
+#define _LOGGER_BINARY_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "logger.h"
+#include "logger_common.h"
+#include "logger_ini.h"
+#include "logger_messageAssemble.h"
+
+
+/**
+ @def LOGGER_BINARY_BUFFER_SIZE
+ @brief bytes of capture buffer owned by each logging thread. Must be a power of two
+ */
+#define LOGGER_BINARY_BUFFER_SIZE (64U * 1024U)
+
+
+/**
+ @def LOGGER_BINARY_MAX_ARGS
+ @brief formats with more conversions than this are formatted inline instead of captured
+ */
+#define LOGGER_BINARY_MAX_ARGS (32U)
+
+
+/**
+ @brief switch binary capture on or off
+ @details while on, #logger_binary_capture stores records for a later #logger_binary_drain. The caller must
+ keep a thread draining for as long as capture is on
+ @param[in] enabled #true to capture
+ */
+void logger_binary_setEnabled ( bool enabled );
+
+
+/**
+ @brief test if binary capture is on
+ @return #true if records should go to #logger_binary_capture
+ */
+bool logger_binary_isEnabled ( void );
+
+
+/**
+ @brief capture a record without formatting it
+ @details stores the format & callsite pointers, time & the raw argument bytes into the calling thread's buffer.
+ fmt & callsite must be static (or otherwise outlive the drain), %s arguments are copied
+ @param[in] callsite static descriptor of the print statement
+ @param[in] outputs outputs the printing handle is bound to, see #LOGGER_RECORD
+ @param[in] fmt message format
+ @param[in] args format arguments
+ @return #false if the format cannot be captured (%n, wide chars or too many conversions). Caller must format inline.
+ #true also when the record was dropped by the backpressure= policy
+ */
+bool logger_binary_capture ( const LOGGER_CALLSITE * callsite, uint32_t outputs, const char * fmt, va_list args );
+
+
+/**
+ @brief store a record formatted by the calling thread behind the records it captured
+ @details the writer sends the thread's records in the order they were printed. Message & fields are copied, the
+ header must be static as for #LOGGER_RECORD
+ @param[in] callsite static descriptor of the print statement
+ @param[in] record finished record
+ @return #false if the record is too long to store. Caller must send it itself.
+ #true also when the record was dropped by the backpressure= policy
+ */
+bool logger_binary_captureRecord ( const LOGGER_CALLSITE * callsite, const LOGGER_RECORD * record );
+
+
+/**
+ @brief format every captured record & pass each to handler
+ @details must only be called from one thread at a time. When collapsing is on, repeats are counted per capturing thread
+ @param[in] handler output to send formatted records to
+ @return number of records taken from the buffers, including repeats that were only counted
+ */
+uint32_t logger_binary_drain ( LOGGER_RECORD_SEND handler );
+
+
+/**
+ @brief send the counts of every run of repeats still held for captured records
+ @details must be called from the draining thread, after the last #logger_binary_drain
+ @param[in] handler output to send summary records to
+ */
+void logger_binary_flushRepeats ( LOGGER_RECORD_SEND handler );
+
+
+/**
+ @brief configure the flight recorder from the [output=...] section key recorder=
+ @details recorder = kilobytes kept per logging thread, missing or 0 switches the flight recorder off
+ @param[in] paramBag ini section handle
+ */
+void logger_binary_recorderFromIni ( LOGGER_INI_SECTIONHANDLE paramBag );
+
+
+/**
+ @brief size the flight recorder given to each thread that logs from now on
+ @details threads already recording keep their recorder & its size
+ @param[in] bytes recorder size, rounded up to a power of two. 0 switches the flight recorder off
+ */
+void logger_binary_setRecorderSize ( size_t bytes );
+
+
+/**
+ @brief test if the flight recorder is on
+ @return #true if #logger_binary_record keeps records
+ */
+bool logger_binary_isRecording ( void );
+
+
+/**
+ @brief keep a record in the calling thread's flight recorder, overwriting its oldest records when full
+ @details same capture as #logger_binary_capture, formatted only if dumped. Formats that cannot be captured are
+ not recorded
+ @param[in] callsite static descriptor of the print statement
+ @param[in] outputs outputs the printing handle is bound to, see #LOGGER_RECORD
+ @param[in] fmt message format
+ @param[in] args format arguments
+ */
+void logger_binary_record ( const LOGGER_CALLSITE * callsite, uint32_t outputs, const char * fmt, va_list args );
+
+
+/**
+ @brief format the records every thread has recorded since the last dump, oldest first, & pass each to handler
+ @details may be called from any thread, records being overwritten while the dump reads them are skipped.
+ The records are bracketed by two notes giving their count
+ @param[in] handler output to send formatted records to
+ @return number of records dumped
+ */
+uint32_t logger_binary_dumpRecorder ( LOGGER_RECORD_SEND handler );
+
+
+/**
+ @brief from a signal handler, send the records still waiting in every capture buffer, then the flight recorder
+ @details async-signal-safe: no locks, no allocation & no printf. Buffers are read in place without being
+ consumed, width & precision of conversions are ignored. Recorder contents are in thread order, not time order
+ @param[in] handler signal-safe output to send formatted records to
+ @return number of records sent
+ */
+uint32_t logger_binary_crashDrain ( LOGGER_RECORD_SEND handler );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _LOGGER_BINARY_H */
@@ -0,0 +1,361 @@
+/**
+ @file
+ Diagnostics print library - static callsite descriptors
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+/* fnmatch, strtok_r */
+#define _POSIX_C_SOURCE 200809L
+
+#include <fnmatch.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "logger_callsite.h"
+#include "logger_levelManagement.h"
+#include "logger_memory.h"
+
+
+#define LOGGER_CALLSITE_NS_PER_MS (1000000ULL)
+
+
+/** a parsed #loggerControlCallsites query, NULL globs & zero levels match anything */
+typedef struct _LOGGER_CALLSITE_MATCH
+{
+    const char * file;
+    int firstLine;
+    int lastLine;
+    const char * func;
+    const char * format;
+    LOGGER_LEVEL_FLAGS levels;
+} LOGGER_CALLSITE_MATCH;
+
+
+#if defined(__ELF__) && ( defined(__GNUC__) || defined(__clang__) )
+/* bounds of the section filled by LOGGER_CALLSITE_REGISTER, both NULL when nothing linked in registers */
+extern LOGGER_CALLSITE * __start_logger_callsites[] __attribute__((weak));
+extern LOGGER_CALLSITE * __stop_logger_callsites[] __attribute__((weak));
+#define LOGGER_CALLSITE_SECTION
+#endif
+
+static LOGGER_CALLSITE_PRV * f_resolvedCallsites = NULL;
+
+static pthread_mutex_t f_mutex_control = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t f_controlPass = 0U;
+
+
+static void logger_callsite_setRate ( LOGGER_CALLSITE_PRV * resolved, uint32_t rateCount, uint32_t rateIntervalMs );
+
+static bool logger_callsite_parseMatch ( LOGGER_CALLSITE_MATCH * parsed, char * terms );
+
+static bool logger_callsite_matches ( const LOGGER_CALLSITE_MATCH * parsed, const LOGGER_CALLSITE * callsite );
+
+static uint32_t logger_callsite_apply ( const LOGGER_CALLSITE_MATCH * parsed, LOGGER_CALLSITE * callsite, LOGGER_CALLSITE_CONTROL control );
+
+
+static void logger_callsite_setRate ( LOGGER_CALLSITE_PRV * resolved, uint32_t rateCount, uint32_t rateIntervalMs )
+{
+    resolved->rateEmission = 0U;
+    resolved->rateTolerance = 0U;
+    resolved->rateArrival = 0U;
+    resolved->rateSuppressed = 0U;
+
+    if ( ( rateCount != 0U ) && ( rateIntervalMs != 0U ) )
+    {
+        LOGGER_TICKS interval = logger_clock_ticksFromNs( (uint64_t)rateIntervalMs * LOGGER_CALLSITE_NS_PER_MS );
+
+        resolved->rateEmission = interval / rateCount;
+        resolved->rateEmission = ( resolved->rateEmission != 0U ) ? resolved->rateEmission : 1U;
+
+        /* a full bucket lets rateCount records through back to back */
+        resolved->rateTolerance = resolved->rateEmission * (rateCount - 1U);
+    }
+}
+
+LOGGER_CALLSITE_PRV * logger_callsite_resolve ( LOGGER_CALLSITE * callsite, uint32_t rateCount, uint32_t rateIntervalMs )
+{
+    LOGGER_CALLSITE_PRV * resolved = __atomic_load_n(&callsite->resolved, __ATOMIC_ACQUIRE);
+
+    if ( resolved == NULL )
+    {
+        /* the header is kept whole, however long the file name */
+        size_t headerSize = LOGGER_CALLSITE_HEADER_SIZE( strlen( logger_record_baseName( callsite->fileName ) ) );
+        LOGGER_CALLSITE_PRV * rendered = logger_mem_alloc( sizeof(LOGGER_CALLSITE_PRV) + headerSize );
+
+        if ( rendered == NULL )
+        {
+            LOGPRINT_LOG_E("Malloc failure !!!");
+        }
+        else
+        {
+            LOGGER_RECORD_BUILDER builder;
+
+            logger_record_begin( &builder, rendered->header, headerSize );
+            logger_record_appendHeader( &builder, callsite->fileName, callsite->lineNumber, callsite->functionName, callsite->level );
+            rendered->headerLen = logger_record_end( &builder );
+
+            if ( callsite->rateCount != 0U )
+            {
+                /* the macro's own limit wins over the ini */
+                rateCount = callsite->rateCount;
+                rateIntervalMs = callsite->rateIntervalMs;
+            }
+
+            logger_callsite_setRate( rendered, rateCount, rateIntervalMs );
+
+            rendered->callsite = callsite;
+            rendered->controlPass = 0U;
+
+            void * expected = NULL;
+
+            if ( __atomic_compare_exchange_n(&callsite->resolved, &expected, rendered, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) )
+            {
+                resolved = rendered;
+
+                /* listed for logger_callsite_control, which only ever reads the list */
+                rendered->next = __atomic_load_n(&f_resolvedCallsites, __ATOMIC_RELAXED);
+
+                while ( __atomic_compare_exchange_n(&f_resolvedCallsites, &rendered->next, rendered, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED) == false )
+                {
+                    /* rendered->next reloaded by the failed exchange */
+                }
+            }
+            else
+            {
+                /* another thread got there first, use its copy */
+                logger_mem_free(rendered);
+                resolved = expected;
+            }
+        }
+    }
+
+    return resolved;
+}
+
+const LOGGER_CALLSITE_PRV * logger_callsite_get ( const LOGGER_CALLSITE * callsite )
+{
+    return __atomic_load_n(&callsite->resolved, __ATOMIC_ACQUIRE);
+}
+
+bool logger_callsite_admit ( LOGGER_CALLSITE_PRV * resolved, uint32_t * suppressed )
+{
+    *suppressed = 0U;
+
+    if ( resolved->rateEmission == 0U )
+    {
+        return true;
+    }
+
+    LOGGER_TICKS now = logger_clock_now();
+    LOGGER_TICKS arrival = __atomic_load_n(&resolved->rateArrival, __ATOMIC_RELAXED);
+    LOGGER_TICKS start = 0U;
+
+    do
+    {
+        if ( ( arrival <= now ) || ( arrival - now > resolved->rateTolerance + resolved->rateEmission ) )
+        {
+            /* bucket full, or the clock stepped back further than any admitted record could reach */
+            start = now;
+        }
+        else if ( arrival - now > resolved->rateTolerance )
+        {
+            __atomic_fetch_add(&resolved->rateSuppressed, 1U, __ATOMIC_RELAXED);
+            return false;
+        }
+        else
+        {
+            start = arrival;
+        }
+    } while ( __atomic_compare_exchange_n(&resolved->rateArrival, &arrival, start + resolved->rateEmission, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) == false );
+
+    if ( __atomic_load_n(&resolved->rateSuppressed, __ATOMIC_RELAXED) != 0U )
+    {
+        *suppressed = __atomic_exchange_n(&resolved->rateSuppressed, 0U, __ATOMIC_RELAXED);
+    }
+
+    return true;
+}
+
+/* terms is modified, globs point into it */
+static bool logger_callsite_parseMatch ( LOGGER_CALLSITE_MATCH * parsed, char * terms )
+{
+    char * save = NULL;
+
+    memset(parsed, 0, sizeof(LOGGER_CALLSITE_MATCH));
+
+    for ( char * term = strtok_r(terms, " \t", &save); term != NULL; term = strtok_r(NULL, " \t", &save) )
+    {
+        char * value = strchr(term, '=');
+
+        if ( value == NULL )
+        {
+            LOGPRINT_LOG_E("Callsite match term without '=': %s",term);
+            return false;
+        }
+
+        *value++ = '\0';
+
+        if ( strcmp(term, "file") == 0 )
+        {
+            /* file=glob:first[-last], the line range only when the text after the last ':' is a number */
+            char * lines = strrchr(value, ':');
+            char * end = NULL;
+
+            parsed->file = value;
+
+            if ( ( lines != NULL ) && ( lines[1] >= '0' ) && ( lines[1] <= '9' ) )
+            {
+                *lines++ = '\0';
+
+                parsed->firstLine = (int)strtol(lines, &end, 10);
+                parsed->lastLine = ( *end == '-' ) ? (int)strtol(end+1, &end, 10) : parsed->firstLine;
+
+                if ( ( *end != '\0' ) || ( parsed->lastLine < parsed->firstLine ) )
+                {
+                    LOGPRINT_LOG_E("Bad callsite line range: %s",lines);
+                    return false;
+                }
+            }
+        }
+        else if ( strcmp(term, "func") == 0 )
+        {
+            parsed->func = value;
+        }
+        else if ( strcmp(term, "format") == 0 )
+        {
+            parsed->format = value;
+        }
+        else if ( strcmp(term, "level") == 0 )
+        {
+            parsed->levels = loggerFlags_level_stringToFlags(value, strlen(value));
+        }
+        else
+        {
+            LOGPRINT_LOG_E("Unknown callsite match term: %s",term);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool logger_callsite_matches ( const LOGGER_CALLSITE_MATCH * parsed, const LOGGER_CALLSITE * callsite )
+{
+    if ( parsed->file != NULL )
+    {
+        const char * fileName = ( callsite->fileName != NULL ) ? callsite->fileName : "";
+        const char * baseName = strrchr(fileName, '/');
+
+        baseName = ( baseName != NULL ) ? baseName+1 : fileName;
+
+        if ( ( fnmatch(parsed->file, fileName, 0) != 0 ) && ( fnmatch(parsed->file, baseName, 0) != 0 ) )
+        {
+            return false;
+        }
+
+        if ( ( parsed->firstLine != 0 ) &&
+             ( ( callsite->lineNumber < parsed->firstLine ) || ( callsite->lineNumber > parsed->lastLine ) ) )
+        {
+            return false;
+        }
+    }
+
+    if ( ( parsed->func != NULL ) &&
+         ( fnmatch(parsed->func, ( callsite->functionName != NULL ) ? callsite->functionName : "", 0) != 0 ) )
+    {
+        return false;
+    }
+
+    if ( ( parsed->levels != 0U ) && ( ( parsed->levels & (LOGGER_LEVEL_FLAGS)callsite->level ) == 0U ) )
+    {
+        return false;
+    }
+
+    /* the macros keep a literal format in the callsite, so one that has never printed is matched too */
+    if ( ( parsed->format != NULL ) &&
+         ( ( callsite->format == NULL ) || ( fnmatch(parsed->format, callsite->format, 0) != 0 ) ) )
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/* f_mutex_control held. Returns 1 when matched for the first time this pass */
+static uint32_t logger_callsite_apply ( const LOGGER_CALLSITE_MATCH * parsed, LOGGER_CALLSITE * callsite, LOGGER_CALLSITE_CONTROL control )
+{
+    LOGGER_CALLSITE_PRV * resolved = __atomic_load_n(&callsite->resolved, __ATOMIC_ACQUIRE);
+
+    if ( resolved != NULL )
+    {
+        /* registered & resolved callsites are seen twice */
+        if ( resolved->controlPass == f_controlPass )
+        {
+            return 0U;
+        }
+
+        resolved->controlPass = f_controlPass;
+    }
+
+    if ( logger_callsite_matches(parsed, callsite) == false )
+    {
+        return 0U;
+    }
+
+    __atomic_store_n(&callsite->control, (uint32_t)control, __ATOMIC_RELAXED);
+
+    return 1U;
+}
+
+uint32_t logger_callsite_control ( const char * match, LOGGER_CALLSITE_CONTROL control )
+{
+    LOGGER_CALLSITE_MATCH parsed;
+    uint32_t matched = 0U;
+
+    LOGGER_MEM_MARK mark = logger_mem_scratchMark();
+    size_t matchLen = ( match != NULL ) ? strlen(match) : 0U;
+    char * terms = logger_mem_scratchAlloc(matchLen + 1U);
+
+    if ( terms == NULL )
+    {
+        LOGPRINT_LOG_E("Malloc failure !!!");
+        return 0U;
+    }
+
+    memcpy(terms, ( match != NULL ) ? match : "", matchLen + 1U);
+
+    if ( logger_callsite_parseMatch(&parsed, terms) )
+    {
+        pthread_mutex_lock(&f_mutex_control);
+
+        f_controlPass += 1U;
+
+#ifdef LOGGER_CALLSITE_SECTION
+        for ( LOGGER_CALLSITE ** entry = __start_logger_callsites; entry < __stop_logger_callsites; entry++ )
+        {
+            /* NULL for levels compiled out */
+            if ( *entry != NULL )
+            {
+                matched += logger_callsite_apply(&parsed, *entry, control);
+            }
+        }
+#endif
+
+        for ( LOGGER_CALLSITE_PRV * resolved = __atomic_load_n(&f_resolvedCallsites, __ATOMIC_ACQUIRE); resolved != NULL; resolved = resolved->next )
+        {
+            matched += logger_callsite_apply(&parsed, resolved->callsite, control);
+        }
+
+        pthread_mutex_unlock(&f_mutex_control);
+    }
+
+    logger_mem_scratchRelease(mark);
+
+    return matched;
+}
@@ -0,0 +1,110 @@
+/**
+ @file
+ Diagnostics print library - static callsite descriptors
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#ifndef _LOGGER_CALLSITE_H
+#define _LOGGER_CALLSITE_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "logger.h"
+#include "logger_common.h"
+#include "logger_clock.h"
+#include "logger_messageAssemble.h"
+
+
+/**
+ @def LOGGER_CALLSITE_HEADER_SIZE
+ @brief room for "|file|line|function|level|" including the terminating \0
+ @param[in] baseNameLen length of the callsite's file name without its path
+ */
+#define LOGGER_CALLSITE_HEADER_SIZE(baseNameLen) \
+    ( (baseNameLen) + 1U + \
+    LOGGER_LINENUMBER_SIZE + \
+    LOGGER_FUNCTIONNAME_SIZE + \
+    LOGGER_SEVERITY_SIZE + \
+    LOGGER_SEPERATOR_CHAR_SIZE )
+
+
+/**
+ @brief what the library keeps for each callsite once it has printed
+ @details hung off #LOGGER_CALLSITE resolved. Never freed, callsites live as long as the process. \n
+ The rate limit is a token bucket kept as a single "theoretical arrival time" (GCRA): each record moves it
+ on by rateEmission, a record arriving more than rateTolerance before it is suppressed
+ */
+typedef struct _LOGGER_CALLSITE_PRV
+{
+    size_t headerLen;
+    LOGGER_TICKS rateEmission;  /* ticks per token, 0 when unlimited */
+    LOGGER_TICKS rateTolerance; /* burst allowance in ticks */
+    LOGGER_TICKS rateArrival;   /* updated with compare-and-swap */
+    uint32_t rateSuppressed;    /* records dropped since the last one printed */
+    LOGGER_CALLSITE * callsite;
+    struct _LOGGER_CALLSITE_PRV * next; /* every resolved callsite, newest first */
+    uint32_t controlPass;       /* last #logger_callsite_control to visit it, control lock held */
+    char header[];              /* #LOGGER_CALLSITE_HEADER_SIZE for the callsite's file name */
+} LOGGER_CALLSITE_PRV;
+
+
+/**
+ @brief get the private state of a callsite, rendering its fields on first use
+ @details safe to race: concurrent first prints may both render, one copy is kept. The limit is fixed by
+ whichever print resolves the callsite first
+ @param[in] callsite static callsite
+ @param[in] rateCount records allowed per interval when the callsite sets no limit itself. 0 for unlimited
+ @param[in] rateIntervalMs interval for rateCount
+ @return NULL only on allocation failure
+ */
+LOGGER_CALLSITE_PRV * logger_callsite_resolve ( LOGGER_CALLSITE * callsite, uint32_t rateCount, uint32_t rateIntervalMs );
+
+
+/**
+ @brief take a token from the callsite's rate limit
+ @details lock-free, one compare-and-swap when admitted & one atomic add when suppressed
+ @param[in] resolved callsite state from #logger_callsite_resolve
+ @param[out] suppressed records dropped since the last admitted one, reset to 0 by this call
+ @return #false if the record must be dropped
+ */
+bool logger_callsite_admit ( LOGGER_CALLSITE_PRV * resolved, uint32_t * suppressed );
+
+
+/**
+ @brief get the rendered fields of a callsite if it has been resolved
+ @param[in] callsite callsite
+ @return NULL if #logger_callsite_resolve has not yet succeeded
+ */
+const LOGGER_CALLSITE_PRV * logger_callsite_get ( const LOGGER_CALLSITE * callsite );
+
+
+/**
+ @brief set the control word of every callsite matching a #loggerControlCallsites query
+ @details walks the registered callsites, then any resolved callsite not registered. Calls are serialised, prints
+ are never blocked
+ @param[in] match space separated terms, see #loggerControlCallsites
+ @param[in] control new control word
+ @return callsites matched
+ */
+uint32_t logger_callsite_control ( const char * match, LOGGER_CALLSITE_CONTROL control );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _LOGGER_CALLSITE_H */
@@ -0,0 +1,242 @@
+/**
+ @file
+ Diagnostics print library - record clock sources
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+/* clock_gettime, nanosleep, CLOCK_REALTIME_COARSE */
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <time.h>
+
+#include "logger_clock.h"
+#include "logger_ini.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define LOGGER_CLOCK_HAVE_TSC
+#endif
+
+#ifndef CLOCK_REALTIME_COARSE
+#define CLOCK_REALTIME_COARSE CLOCK_REALTIME
+#endif
+
+
+#define LOGGER_CLOCK_NS_PER_SEC (1000000000ULL)
+
+/* time spent measuring the tsc rate at startup */
+#define LOGGER_CLOCK_TSC_CALIBRATE_NS (10000000L)
+
+
+static LOGGER_CLOCK_SOURCE f_clockSource = LOGGER_CLOCK_REALTIME;
+static LOGGER_CLOCK_PRECISION f_clockPrecision = LOGGER_CLOCK_PRECISION_S;
+
+/* wall time (ns since epoch) at the moment the source read anchorTicks */
+static uint64_t f_clockAnchorWallNs = 0U;
+static LOGGER_TICKS f_clockAnchorTicks = 0U;
+static double f_clockNsPerTick = 1.0;
+
+
+static uint64_t logger_clock_readNs ( clockid_t clockId );
+static LOGGER_TICKS logger_clock_readTsc ( void );
+
+
+static uint64_t logger_clock_readNs ( clockid_t clockId )
+{
+    struct timespec ts;
+
+    clock_gettime(clockId, &ts);
+
+    return ((uint64_t)ts.tv_sec * LOGGER_CLOCK_NS_PER_SEC) + (uint64_t)ts.tv_nsec;
+}
+
+static LOGGER_TICKS logger_clock_readTsc ( void )
+{
+#ifdef LOGGER_CLOCK_HAVE_TSC
+    return (LOGGER_TICKS)__rdtsc();
+#else
+    return (LOGGER_TICKS)logger_clock_readNs(CLOCK_MONOTONIC);
+#endif
+}
+
+void logger_clock_configure ( LOGGER_CLOCK_SOURCE source, LOGGER_CLOCK_PRECISION precision )
+{
+    f_clockPrecision = precision;
+    f_clockNsPerTick = 1.0;
+
+#ifndef LOGGER_CLOCK_HAVE_TSC
+    if ( source == LOGGER_CLOCK_TSC )
+    {
+        source = LOGGER_CLOCK_MONOTONIC;
+    }
+#endif
+
+    if ( source == LOGGER_CLOCK_TSC )
+    {
+        struct timespec wait = { 0, LOGGER_CLOCK_TSC_CALIBRATE_NS };
+
+        uint64_t monoStart = logger_clock_readNs(CLOCK_MONOTONIC);
+        LOGGER_TICKS tscStart = logger_clock_readTsc();
+
+        nanosleep(&wait, NULL);
+
+        uint64_t monoEnd = logger_clock_readNs(CLOCK_MONOTONIC);
+        LOGGER_TICKS tscEnd = logger_clock_readTsc();
+
+        if ( ( tscEnd > tscStart ) && ( monoEnd > monoStart ) )
+        {
+            f_clockNsPerTick = (double)(monoEnd - monoStart) / (double)(tscEnd - tscStart);
+        }
+        else
+        {
+            LOGPRINT_LOG_E("tsc not usable, using monotonic clock");
+            source = LOGGER_CLOCK_MONOTONIC;
+        }
+    }
+
+    /* pair a reading of the source with the wall clock so ticks can be converted later */
+    switch ( source )
+    {
+        case LOGGER_CLOCK_MONOTONIC:
+            f_clockAnchorTicks = logger_clock_readNs(CLOCK_MONOTONIC);
+            break;
+
+        case LOGGER_CLOCK_TSC:
+            f_clockAnchorTicks = logger_clock_readTsc();
+            break;
+
+        default:
+            f_clockAnchorTicks = 0U;
+            break;
+    }
+
+    f_clockAnchorWallNs = ( f_clockAnchorTicks != 0U ) ? logger_clock_readNs(CLOCK_REALTIME) : 0U;
+
+    f_clockSource = source;
+}
+
+void logger_clock_configureFromIni ( LOGGER_INI_SECTIONHANDLE paramBag )
+{
+    static const struct
+    {
+        const char * name;
+        LOGGER_CLOCK_SOURCE source;
+    } sources[] =
+    {
+        { "realtime", LOGGER_CLOCK_REALTIME },
+        { "realtime_coarse", LOGGER_CLOCK_REALTIME_COARSE },
+        { "monotonic", LOGGER_CLOCK_MONOTONIC },
+        { "tsc", LOGGER_CLOCK_TSC },
+    };
+
+    static const struct
+    {
+        const char * name;
+        LOGGER_CLOCK_PRECISION precision;
+    } precisions[] =
+    {
+        { "s", LOGGER_CLOCK_PRECISION_S },
+        { "ms", LOGGER_CLOCK_PRECISION_MS },
+        { "us", LOGGER_CLOCK_PRECISION_US },
+        { "ns", LOGGER_CLOCK_PRECISION_NS },
+    };
+
+    LOGGER_CLOCK_SOURCE source = LOGGER_CLOCK_REALTIME;
+    LOGGER_CLOCK_PRECISION precision = LOGGER_CLOCK_PRECISION_S;
+    char *value = NULL;
+    size_t valueLen = 0U;
+
+    logger_ini_sectionRetrieveValueFromKey(paramBag, "clock", strlen("clock"), &value, &valueLen);
+
+    for ( uint32_t i=0U; ( value != NULL ) && ( i<sizeof(sources)/sizeof(sources[0]) ); i++ )
+    {
+        if ( ( strlen(sources[i].name) == valueLen ) && ( strncmp(sources[i].name, value, valueLen) == 0 ) )
+        {
+            source = sources[i].source;
+        }
+    }
+
+    value = NULL;
+    valueLen = 0U;
+
+    logger_ini_sectionRetrieveValueFromKey(paramBag, "precision", strlen("precision"), &value, &valueLen);
+
+    for ( uint32_t i=0U; ( value != NULL ) && ( i<sizeof(precisions)/sizeof(precisions[0]) ); i++ )
+    {
+        if ( ( strlen(precisions[i].name) == valueLen ) && ( strncmp(precisions[i].name, value, valueLen) == 0 ) )
+        {
+            precision = precisions[i].precision;
+        }
+    }
+
+    logger_clock_configure(source, precision);
+}
+
+LOGGER_TICKS logger_clock_now ( void )
+{
+    LOGGER_TICKS ticks = 0U;
+
+    switch ( f_clockSource )
+    {
+        case LOGGER_CLOCK_REALTIME_COARSE:
+            ticks = logger_clock_readNs(CLOCK_REALTIME_COARSE);
+            break;
+
+        case LOGGER_CLOCK_MONOTONIC:
+            ticks = logger_clock_readNs(CLOCK_MONOTONIC);
+            break;
+
+        case LOGGER_CLOCK_TSC:
+            ticks = logger_clock_readTsc();
+            break;
+
+        default:
+            ticks = logger_clock_readNs(CLOCK_REALTIME);
+            break;
+    }
+
+    return ticks;
+}
+
+void logger_clock_toWallTime ( LOGGER_TICKS ticks, time_t * seconds, uint32_t * nanoseconds )
+{
+    uint64_t wallNs = ticks;
+
+    if ( f_clockSource == LOGGER_CLOCK_MONOTONIC )
+    {
+        wallNs = f_clockAnchorWallNs + ( ticks - f_clockAnchorTicks );
+    }
+    else if ( f_clockSource == LOGGER_CLOCK_TSC )
+    {
+        /* signed: records captured by another cpu may read slightly before the anchor */
+        int64_t deltaTicks = (int64_t)( ticks - f_clockAnchorTicks );
+
+        wallNs = f_clockAnchorWallNs + (uint64_t)(int64_t)( (double)deltaTicks * f_clockNsPerTick );
+    }
+
+    *seconds = (time_t)( wallNs / LOGGER_CLOCK_NS_PER_SEC );
+    *nanoseconds = (uint32_t)( wallNs % LOGGER_CLOCK_NS_PER_SEC );
+}
+
+LOGGER_TICKS logger_clock_ticksFromNs ( uint64_t nanoseconds )
+{
+    LOGGER_TICKS ticks = nanoseconds;
+
+    if ( f_clockSource == LOGGER_CLOCK_TSC )
+    {
+        ticks = (LOGGER_TICKS)( (double)nanoseconds / f_clockNsPerTick );
+    }
+
+    return ticks;
+}
+
+LOGGER_CLOCK_PRECISION logger_clock_precision ( void )
+{
+    return f_clockPrecision;
+}
@@ -0,0 +1,120 @@
+/**
+ @file
+ Diagnostics print library - record clock sources
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#ifndef _LOGGER_CLOCK_H
+#define _LOGGER_CLOCK_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "logger_common.h"
+#include "logger_ini.h"
+
+
+/** raw clock reading as captured with the record. Meaning depends on the configured #LOGGER_CLOCK_SOURCE */
+typedef uint64_t LOGGER_TICKS;
+
+
+/**
+ @enum _LOGGER_CLOCK_SOURCE
+ @brief where record timestamps are read from \n
+ #LOGGER_CLOCK_REALTIME clock_gettime(CLOCK_REALTIME) - the default \n
+ #LOGGER_CLOCK_REALTIME_COARSE clock_gettime(CLOCK_REALTIME_COARSE) - cheapest, resolution of the kernel tick \n
+ #LOGGER_CLOCK_MONOTONIC clock_gettime(CLOCK_MONOTONIC) - never steps, shown as wall time from the offset at startup \n
+ #LOGGER_CLOCK_TSC cpu timestamp counter - calibrated against CLOCK_MONOTONIC at startup. Falls back to monotonic where unavailable \n
+ */
+typedef enum _LOGGER_CLOCK_SOURCE
+{
+    LOGGER_CLOCK_REALTIME = 0,
+    LOGGER_CLOCK_REALTIME_COARSE,
+    LOGGER_CLOCK_MONOTONIC,
+    LOGGER_CLOCK_TSC,
+} LOGGER_CLOCK_SOURCE;
+
+
+/**
+ @enum _LOGGER_CLOCK_PRECISION
+ @brief number of sub-second digits shown in the record timestamp
+ */
+typedef enum _LOGGER_CLOCK_PRECISION
+{
+    LOGGER_CLOCK_PRECISION_S = 0,
+    LOGGER_CLOCK_PRECISION_MS = 3,
+    LOGGER_CLOCK_PRECISION_US = 6,
+    LOGGER_CLOCK_PRECISION_NS = 9,
+} LOGGER_CLOCK_PRECISION;
+
+
+/**
+ @brief select the clock & timestamp precision
+ @details must be called before records are captured, changing source mid-stream makes queued records meaningless
+ @param[in] source clock to read
+ @param[in] precision sub-second digits to print
+ */
+void logger_clock_configure ( LOGGER_CLOCK_SOURCE source, LOGGER_CLOCK_PRECISION precision );
+
+
+/**
+ @brief configure from the [output=...] section keys clock= & precision=
+ @details clock = realtime | realtime_coarse | monotonic | tsc \n
+ precision = s | ms | us | ns \n
+ missing keys select realtime & s
+ @param[in] paramBag ini section handle
+ */
+void logger_clock_configureFromIni ( LOGGER_INI_SECTIONHANDLE paramBag );
+
+
+/**
+ @brief read the configured clock
+ @details kept cheap: no conversion is done here
+ @return raw ticks
+ */
+LOGGER_TICKS logger_clock_now ( void );
+
+
+/**
+ @brief convert captured ticks to wall time
+ @param[in] ticks value returned by #logger_clock_now
+ @param[out] seconds seconds since the epoch
+ @param[out] nanoseconds nanoseconds within the second
+ */
+void logger_clock_toWallTime ( LOGGER_TICKS ticks, time_t * seconds, uint32_t * nanoseconds );
+
+
+/**
+ @brief convert a duration to ticks of the configured clock
+ @param[in] nanoseconds duration
+ @return equivalent number of ticks
+ */
+LOGGER_TICKS logger_clock_ticksFromNs ( uint64_t nanoseconds );
+
+
+/**
+ @brief get the configured precision
+ @return sub-second digits to print
+ */
+LOGGER_CLOCK_PRECISION logger_clock_precision ( void );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _LOGGER_CLOCK_H */
@@ -21,6 +21,8 @@ extern "C" {
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "logger.h"
+
 
 /**
  @brief current logger version
@@ -58,16 +60,30 @@ typedef uint32_t LOGGER_LEVEL_FLAGS;
 
 /**
  @brief internal structure holding all variables per logger handle
+ @details must start with #LOGGER_HANDLE_PUBLIC, the print macros read it directly
  */
 typedef struct _LOGGER_HANDLE_PRV
 {
-    LOGGER_LEVEL_FLAGS loggerLevelsEnabled;
+    LOGGER_HANDLE_PUBLIC shared;
+    uint32_t rateCount;         /* per callsite limit from the ini [ratelimit] section, 0 for none */
+    uint32_t rateIntervalMs;
+    uint32_t outputs;           /* bound outputs, 0 for the unbound ones. Atomic, a reload rebinds it */
+    char * baseName;            /* source file the handle was created for, NULL when created from a level */
+    size_t baseNameLen;
+    struct _LOGGER_HANDLE_PRV * registryNext;   /* next live handle, guarded by the registry lock */
 } LOGGER_HANDLE_PRV;
 
 
 
-#define logger_memAlloc malloc
-#define logger_memFree free
+/**
+ @def LOGGER_THREAD_LOCAL
+ @brief storage class for per-thread logger state
+ */
+#if defined(_MSC_VER)
+#define LOGGER_THREAD_LOCAL __declspec(thread)
+#else
+#define LOGGER_THREAD_LOCAL __thread
+#endif
 
 
 /* Enable to trace any defects in DebugPrint */
@@ -0,0 +1,124 @@
+/**
+ @file
+ Diagnostics print library - crash flush
+ 
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+/* sigaction, SA_ONSTACK */
+#define _XOPEN_SOURCE 700
+
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+
+#include "logger_crash.h"
+#include "logger_common.h"
+#include "logger_ini.h"
+#include "logger_initTerm.h"
+#include "logger_messageAssemble.h"
+#include "logger_stringUtil.h"
+
+
+static const int f_crashSignals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+
+#define LOGGER_CRASH_SIGNAL_COUNT (sizeof(f_crashSignals)/sizeof(f_crashSignals[0]))
+
+static struct sigaction f_crashPrevious[LOGGER_CRASH_SIGNAL_COUNT];
+
+static bool f_crashInstalled = false;
+
+/* set by the first crashing thread, any other runs straight on to the previous action */
+static bool f_crashFlushing = false;
+
+
+static void logger_crash_handler ( int sig, siginfo_t * info, void * context );
+
+
+static void logger_crash_handler ( int sig, siginfo_t * info, void * context )
+{
+    (void)info;
+    (void)context;
+    
+    if ( __atomic_exchange_n(&f_crashFlushing, true, __ATOMIC_ACQ_REL) == false )
+    {
+        (void)logger_crashFlush();
+    }
+    
+    for ( uint32_t i=0U; i<LOGGER_CRASH_SIGNAL_COUNT; i++ )
+    {
+        if ( f_crashSignals[i] == sig )
+        {
+            sigaction(sig, &f_crashPrevious[i], NULL);
+        }
+    }
+    
+    /* blocked until the handler returns. A fault is also raised again by the instruction that caused it */
+    raise(sig);
+}
+
+bool logger_crash_isWantedFromIni ( LOGGER_INI_SECTIONHANDLE paramBag )
+{
+    char *value = NULL;
+    size_t valueLen = 0U;
+    
+    logger_ini_sectionRetrieveValueFromKey(paramBag, "crash_flush", strlen("crash_flush"), &value, &valueLen);
+    
+    return logger_string_isTrue(value, valueLen);
+}
+
+void logger_crash_start ( void )
+{
+    if ( f_crashInstalled )
+    {
+        return;
+    }
+    
+    /* the handler cannot call localtime, it reuses the zone offset found here */
+    char timestamp[LOGGER_TIMESTAMP_SIZE];
+    
+    (void)loggerTimeStringFromTime(time(NULL), timestamp, sizeof(timestamp));
+    
+    struct sigaction action;
+    
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = logger_crash_handler;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    
+    __atomic_store_n(&f_crashFlushing, false, __ATOMIC_RELEASE);
+    
+    for ( uint32_t i=0U; i<LOGGER_CRASH_SIGNAL_COUNT; i++ )
+    {
+        if ( sigaction(f_crashSignals[i], &action, &f_crashPrevious[i]) != 0 )
+        {
+            LOGPRINT_LOG_E("Failed to install crash handler for signal %d",f_crashSignals[i]);
+        }
+    }
+    
+    f_crashInstalled = true;
+    
+    LOGPRINT_LOG_I("crash flush enabled");
+}
+
+bool logger_crash_isFlushing ( void )
+{
+    return __atomic_load_n(&f_crashFlushing, __ATOMIC_ACQUIRE);
+}
+
+void logger_crash_stop ( void )
+{
+    if ( f_crashInstalled )
+    {
+        for ( uint32_t i=0U; i<LOGGER_CRASH_SIGNAL_COUNT; i++ )
+        {
+            sigaction(f_crashSignals[i], &f_crashPrevious[i], NULL);
+        }
+        
+        f_crashInstalled = false;
+    }
+}
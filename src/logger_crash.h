@@ -0,0 +1,65 @@
+/**
+ @file
+ Diagnostics print library - crash flush
+ 
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#ifndef _LOGGER_CRASH_H
+#define _LOGGER_CRASH_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdbool.h>
+
+#include "logger.h"
+#include "logger_ini.h"
+
+
+/**
+ @brief read an output's [output=...] section key crash_flush=
+ @param[in] paramBag ini section handle
+ @return #true when the output is to be sent the records left at a crash, see #logger_crash_start
+ */
+bool logger_crash_isWantedFromIni ( LOGGER_INI_SECTIONHANDLE paramBag );
+
+
+/**
+ @brief install the crash handler, called when at least one output asked for crash_flush=
+ @details on SIGSEGV, SIGBUS, SIGILL, SIGFPE & SIGABRT the handler sends the records still queued or captured, &
+ the flight recorder, to the outputs that asked, then restores the previous action & raises the signal again.
+ Handlers already installed by the application are chained to. The handler runs on the application's alternate
+ signal stack when it has one
+ */
+void logger_crash_start ( void );
+
+
+/**
+ @brief whether the crash handler is sending what was left
+ @details the writer thread stops taking captures then, so the handler finds each one either in the captures or on
+ an output's queue
+ @return #true once a crash signal was caught
+ */
+bool logger_crash_isFlushing ( void );
+
+
+/**
+ @brief remove the crash handler, putting back the previous actions. Does nothing when it is not installed
+ */
+void logger_crash_stop ( void );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _LOGGER_CRASH_H */
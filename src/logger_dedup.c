@@ -0,0 +1,380 @@
+/**
+ @file
+ Diagnostics print library - repeated record collapsing
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include "logger_dedup.h"
+#include "logger_ini.h"
+#include "logger_initTerm.h"
+#include "logger_stringUtil.h"
+#include "logger_memory.h"
+
+
+#define LOGGER_DEDUP_NS_PER_MS (1000000ULL)
+
+#define LOGGER_DEDUP_FNV_OFFSET (14695981039346656037ULL)
+#define LOGGER_DEDUP_FNV_PRIME (1099511628211ULL)
+
+#define LOGGER_DEDUP_STATE_FREE  (0U)
+#define LOGGER_DEDUP_STATE_OWNED (1U)
+
+
+static bool f_dedupEnabled = false;
+static LOGGER_TICKS f_dedupTimeout = 0U;
+
+static LOGGER_THREAD_LOCAL LOGGER_DEDUP_TABLE * f_threadTable = NULL;
+
+/* every thread table, for logger_dedup_expireThreads */
+static LOGGER_DEDUP_TABLE * f_threadTables = NULL;
+
+static pthread_once_t f_dedupKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t f_dedupKey;
+
+
+static void logger_dedup_threadExit ( void * table );
+static void logger_dedup_createKey ( void );
+static LOGGER_DEDUP_TABLE * logger_dedup_acquire ( void );
+static void logger_dedup_lock ( LOGGER_DEDUP_TABLE * table );
+static void logger_dedup_unlock ( LOGGER_DEDUP_TABLE * table );
+static uint64_t logger_dedup_hash ( const char * data, size_t dataLen );
+static void logger_dedup_sendSummary ( LOGGER_DEDUP_TABLE * table, LOGGER_DEDUP_ENTRY * entry, LOGGER_RECORD_SEND send );
+static bool logger_dedup_match ( LOGGER_DEDUP_TABLE * table, const void * key, const LOGGER_RECORD * record );
+static void logger_dedup_expireTo ( LOGGER_DEDUP_TABLE * table, LOGGER_TICKS now, LOGGER_RECORD_SEND send );
+
+
+static void logger_dedup_threadExit ( void * table )
+{
+    LOGGER_DEDUP_TABLE * threadTable = (LOGGER_DEDUP_TABLE *)table;
+
+    /* the output may already be gone, only report while collapsing is still on */
+    if ( logger_dedup_isEnabled() == false )
+    {
+        logger_dedup_lock(threadTable);
+        threadTable->pending = 0U;
+        logger_dedup_unlock(threadTable);
+    }
+
+    logger_dedup_flush(threadTable);
+
+    __atomic_store_n(&threadTable->state, LOGGER_DEDUP_STATE_FREE, __ATOMIC_RELEASE);
+}
+
+static void logger_dedup_createKey ( void )
+{
+    pthread_key_create(&f_dedupKey, logger_dedup_threadExit);
+}
+
+static LOGGER_DEDUP_TABLE * logger_dedup_acquire ( void )
+{
+    /* reuse a table left behind by an exited thread */
+    LOGGER_DEDUP_TABLE * table = __atomic_load_n(&f_threadTables, __ATOMIC_ACQUIRE);
+
+    while ( table != NULL )
+    {
+        uint32_t expected = LOGGER_DEDUP_STATE_FREE;
+
+        if ( __atomic_compare_exchange_n(&table->state, &expected, LOGGER_DEDUP_STATE_OWNED, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) )
+        {
+            return table;
+        }
+
+        table = table->next;
+    }
+
+    table = logger_dedup_create(logger_sendRecord);
+
+    if ( table != NULL )
+    {
+        table->next = __atomic_load_n(&f_threadTables, __ATOMIC_RELAXED);
+
+        while ( __atomic_compare_exchange_n(&f_threadTables, &table->next, table, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED) == false )
+        {
+            /* table->next reloaded by the failed exchange */
+        }
+    }
+
+    return table;
+}
+
+/* only ever contended by the async writer expiring the table, which holds it briefly */
+static void logger_dedup_lock ( LOGGER_DEDUP_TABLE * table )
+{
+    while ( __atomic_exchange_n(&table->lock, 1U, __ATOMIC_ACQUIRE) != 0U )
+    {
+        sched_yield();
+    }
+}
+
+static void logger_dedup_unlock ( LOGGER_DEDUP_TABLE * table )
+{
+    __atomic_store_n(&table->lock, 0U, __ATOMIC_RELEASE);
+}
+
+static uint64_t logger_dedup_hash ( const char * data, size_t dataLen )
+{
+    uint64_t hash = LOGGER_DEDUP_FNV_OFFSET;
+
+    for ( size_t i=0U; i<dataLen; i++ )
+    {
+        hash ^= (uint64_t)(unsigned char)data[i];
+        hash *= LOGGER_DEDUP_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+static void logger_dedup_sendSummary ( LOGGER_DEDUP_TABLE * table, LOGGER_DEDUP_ENTRY * entry, LOGGER_RECORD_SEND send )
+{
+    char summary[LOGGER_MESSAGE_SIZE];
+    LOGGER_RECORD_BUILDER builder;
+    LOGGER_RECORD record;
+
+    logger_record_begin(&builder, summary, sizeof(summary));
+    logger_record_appendFormat(&builder, LOGGER_MESSAGE_SIZE-1U, "last message repeated %u times", entry->repeats);
+
+    record.ticks = entry->lastRepeat;
+    record.level = entry->level;
+    record.header = entry->header;
+    record.headerLen = entry->headerLen;
+    record.messageLen = logger_record_end(&builder);
+    record.message = builder.buffer;
+    record.fields = NULL;
+    record.fieldsLen = 0U;
+    record.outputs = entry->outputs;
+
+    entry->repeats = 0U;
+    table->pending -= 1U;
+
+    (void)(*send)(&record);
+}
+
+void logger_dedup_configure ( bool enabled, uint32_t timeoutMs )
+{
+    f_dedupTimeout = logger_clock_ticksFromNs( (uint64_t)timeoutMs * LOGGER_DEDUP_NS_PER_MS );
+
+    __atomic_store_n(&f_dedupEnabled, enabled, __ATOMIC_RELEASE);
+}
+
+void logger_dedup_startFromIni ( LOGGER_INI_SECTIONHANDLE paramBag )
+{
+    char *dedupStr = NULL;
+    size_t dedupStrLen = 0U;
+    char *timeoutStr = NULL;
+    size_t timeoutStrLen = 0U;
+    uint32_t timeoutMs = LOGGER_DEDUP_DEFAULT_TIMEOUT_MS;
+
+    logger_ini_sectionRetrieveValueFromKey(paramBag, "dedup", strlen("dedup"), &dedupStr, &dedupStrLen);
+    logger_ini_sectionRetrieveValueFromKey(paramBag, "dedup_timeout", strlen("dedup_timeout"), &timeoutStr, &timeoutStrLen);
+
+    if ( ( timeoutStr != NULL ) && ( atoi(timeoutStr) > 0 ) )
+    {
+        timeoutMs = (uint32_t)atoi(timeoutStr);
+    }
+
+    logger_dedup_configure(logger_string_isTrue(dedupStr, dedupStrLen), timeoutMs);
+}
+
+bool logger_dedup_isEnabled ( void )
+{
+    return __atomic_load_n(&f_dedupEnabled, __ATOMIC_ACQUIRE);
+}
+
+LOGGER_DEDUP_TABLE * logger_dedup_create ( LOGGER_RECORD_SEND send )
+{
+    LOGGER_DEDUP_TABLE * table = logger_mem_alloc(sizeof(LOGGER_DEDUP_TABLE));
+
+    if ( table == NULL )
+    {
+        LOGPRINT_LOG_E("Malloc failure !!!");
+    }
+    else
+    {
+        table->send = send;
+        table->pending = 0U;
+        table->lock = 0U;
+        table->state = LOGGER_DEDUP_STATE_OWNED;
+        table->next = NULL;
+
+        for ( uint32_t i=0U; i<LOGGER_DEDUP_ENTRIES; i++ )
+        {
+            table->entries[i].key = NULL;
+            table->entries[i].repeats = 0U;
+        }
+    }
+
+    return table;
+}
+
+void logger_dedup_destroy ( LOGGER_DEDUP_TABLE * table )
+{
+    if ( table != NULL )
+    {
+        logger_dedup_flush(table);
+        logger_mem_free(table);
+    }
+}
+
+LOGGER_DEDUP_TABLE * logger_dedup_threadTable ( void )
+{
+    if ( f_threadTable == NULL )
+    {
+        pthread_once(&f_dedupKeyOnce, logger_dedup_createKey);
+
+        f_threadTable = logger_dedup_acquire();
+
+        if ( f_threadTable != NULL )
+        {
+            pthread_setspecific(f_dedupKey, f_threadTable);
+        }
+    }
+
+    return f_threadTable;
+}
+
+void logger_dedup_flushThread ( void )
+{
+    if ( f_threadTable != NULL )
+    {
+        logger_dedup_flush(f_threadTable);
+    }
+}
+
+/* table locked */
+static bool logger_dedup_match ( LOGGER_DEDUP_TABLE * table, const void * key, const LOGGER_RECORD * record )
+{
+    LOGGER_TICKS ticks = record->ticks;
+
+    if ( table->pending != 0U )
+    {
+        logger_dedup_expireTo(table, ticks, table->send);
+    }
+
+    uintptr_t slot = ( (uintptr_t)key >> 4U ) ^ ( (uintptr_t)key >> 10U );
+    LOGGER_DEDUP_ENTRY * entry = &table->entries[slot & (LOGGER_DEDUP_ENTRIES-1U)];
+
+    /* the header is fixed per key, only the message can differ */
+    uint64_t hash = logger_dedup_hash(record->message, record->messageLen);
+
+    if ( ( entry->key == key ) &&
+         ( entry->hash == hash ) &&
+         ( entry->messageLen == record->messageLen ) &&
+         ( memcmp(entry->message, record->message, record->messageLen) == 0 ) )
+    {
+        if ( entry->repeats == 0U )
+        {
+            entry->firstRepeat = ticks;
+            table->pending += 1U;
+        }
+
+        entry->repeats += 1U;
+        entry->lastRepeat = ticks;
+
+        return false;
+    }
+
+    if ( entry->repeats != 0U )
+    {
+        /* run has ended, its count goes out ahead of the new record */
+        logger_dedup_sendSummary(table, entry, table->send);
+    }
+
+    entry->key = key;
+    entry->hash = hash;
+    entry->header = record->header;
+    entry->level = record->level;
+    entry->outputs = record->outputs;
+    entry->headerLen = record->headerLen;
+    entry->messageLen = ( record->messageLen < sizeof(entry->message) ) ? record->messageLen : sizeof(entry->message);
+    memcpy(entry->message, record->message, entry->messageLen);
+
+    return true;
+}
+
+bool logger_dedup_filter ( LOGGER_DEDUP_TABLE * table, const void * key, const LOGGER_RECORD * record )
+{
+    logger_dedup_lock(table);
+
+    bool send = logger_dedup_match(table, key, record);
+
+    logger_dedup_unlock(table);
+
+    return send;
+}
+
+/* table locked */
+static void logger_dedup_expireTo ( LOGGER_DEDUP_TABLE * table, LOGGER_TICKS now, LOGGER_RECORD_SEND send )
+{
+    for ( uint32_t i=0U; ( i<LOGGER_DEDUP_ENTRIES ) && ( table->pending != 0U ); i++ )
+    {
+        LOGGER_DEDUP_ENTRY * entry = &table->entries[i];
+
+        /* a run started after now is not yet due */
+        if ( ( entry->repeats != 0U ) && ( now >= entry->firstRepeat ) && ( now - entry->firstRepeat >= f_dedupTimeout ) )
+        {
+            logger_dedup_sendSummary(table, entry, send);
+        }
+    }
+}
+
+void logger_dedup_expire ( LOGGER_DEDUP_TABLE * table, LOGGER_TICKS now )
+{
+    logger_dedup_lock(table);
+
+    logger_dedup_expireTo(table, now, table->send);
+
+    logger_dedup_unlock(table);
+}
+
+void logger_dedup_flush ( LOGGER_DEDUP_TABLE * table )
+{
+    logger_dedup_lock(table);
+
+    for ( uint32_t i=0U; i<LOGGER_DEDUP_ENTRIES; i++ )
+    {
+        LOGGER_DEDUP_ENTRY * entry = &table->entries[i];
+
+        if ( ( entry->repeats != 0U ) && ( table->pending != 0U ) )
+        {
+            logger_dedup_sendSummary(table, entry, table->send);
+        }
+
+        entry->key = NULL;
+        entry->repeats = 0U;
+    }
+
+    table->pending = 0U;
+
+    logger_dedup_unlock(table);
+}
+
+void logger_dedup_expireThreads ( LOGGER_RECORD_SEND send )
+{
+    if ( logger_dedup_isEnabled() == false )
+    {
+        return;
+    }
+
+    for ( LOGGER_DEDUP_TABLE * table = __atomic_load_n(&f_threadTables, __ATOMIC_ACQUIRE); table != NULL; table = table->next )
+    {
+        /* never waits for a printing thread, a busy table is seen on the next wake */
+        if ( __atomic_exchange_n(&table->lock, 1U, __ATOMIC_ACQUIRE) == 0U )
+        {
+            if ( table->pending != 0U )
+            {
+                logger_dedup_expireTo(table, logger_clock_now(), send);
+            }
+
+            logger_dedup_unlock(table);
+        }
+    }
+}
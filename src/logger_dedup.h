@@ -0,0 +1,176 @@
+/**
+ @file
+ Diagnostics print library - repeated record collapsing
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#ifndef _LOGGER_DEDUP_H
+#define _LOGGER_DEDUP_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "logger.h"
+#include "logger_common.h"
+#include "logger_clock.h"
+#include "logger_ini.h"
+#include "logger_messageAssemble.h"
+
+
+/**
+ @def LOGGER_DEDUP_ENTRIES
+ @brief callsites each table remembers at once. Must be a power of two
+ */
+#define LOGGER_DEDUP_ENTRIES (8U)
+
+
+/**
+ @def LOGGER_DEDUP_DEFAULT_TIMEOUT_MS
+ @brief longest a run of repeats is held before its count is written, when the ini does not specify one
+ */
+#define LOGGER_DEDUP_DEFAULT_TIMEOUT_MS (1000U)
+
+
+/**
+ @brief last record seen from one callsite
+ */
+typedef struct _LOGGER_DEDUP_ENTRY
+{
+    const void * key;           /* callsite, only compared */
+    uint64_t hash;
+    const char * header;        /* static callsite header, reused for the summary */
+    LOGGER_LEVEL level;
+    uint32_t outputs;           /* of the record repeated, the summary goes to the same outputs */
+    size_t headerLen;
+    size_t messageLen;
+    uint32_t repeats;           /* identical records dropped & not yet reported */
+    LOGGER_TICKS firstRepeat;
+    LOGGER_TICKS lastRepeat;
+    char message[LOGGER_MESSAGE_SIZE];
+} LOGGER_DEDUP_ENTRY;
+
+
+/**
+ @brief recent records of one stream, used by one thread
+ @details a printing thread's table may also be expired by the async writer, both take lock for that. Thread
+ tables are never freed, the table of an exited thread is taken over by the next new thread
+ */
+typedef struct _LOGGER_DEDUP_TABLE
+{
+    LOGGER_RECORD_SEND send;    /* where "last message repeated N times" records go */
+    uint32_t pending;           /* entries with repeats != 0 */
+    uint32_t lock;              /* 1 while filtered, flushed or expired */
+    uint32_t state;             /* thread tables only, owned or free for the next thread */
+    struct _LOGGER_DEDUP_TABLE * next; /* thread tables only, every one ever created */
+    LOGGER_DEDUP_ENTRY entries[LOGGER_DEDUP_ENTRIES];
+} LOGGER_DEDUP_TABLE;
+
+
+/**
+ @brief switch collapsing on or off
+ @param[in] enabled #true to collapse repeats
+ @param[in] timeoutMs longest a run of repeats is held before its count is written
+ */
+void logger_dedup_configure ( bool enabled, uint32_t timeoutMs );
+
+
+/**
+ @brief configure from the [output=...] section keys dedup= & dedup_timeout=
+ @details dedup = true to collapse repeats \n
+ dedup_timeout = milliseconds a run is held before its count is written, default #LOGGER_DEDUP_DEFAULT_TIMEOUT_MS
+ @param[in] paramBag ini section handle
+ */
+void logger_dedup_startFromIni ( LOGGER_INI_SECTIONHANDLE paramBag );
+
+
+/**
+ @brief test if collapsing is on
+ @return #true if records should pass through #logger_dedup_filter
+ */
+bool logger_dedup_isEnabled ( void );
+
+
+/**
+ @brief allocate an empty table
+ @param[in] send destination for generated summary records
+ @return NULL on allocation failure
+ */
+LOGGER_DEDUP_TABLE * logger_dedup_create ( LOGGER_RECORD_SEND send );
+
+
+/**
+ @brief write any pending counts & free the table
+ @param[in] table table to destroy, may be NULL
+ */
+void logger_dedup_destroy ( LOGGER_DEDUP_TABLE * table );
+
+
+/**
+ @brief get the calling thread's table, created on first use with #logger_sendRecord as destination
+ @details pending counts are written when the thread exits. Without an async writer a run held past the timeout
+ is only written with the thread's next record, see #logger_dedup_expireThreads
+ @return NULL on allocation failure
+ */
+LOGGER_DEDUP_TABLE * logger_dedup_threadTable ( void );
+
+
+/**
+ @brief write the pending counts of the calling thread's table, if it has one
+ */
+void logger_dedup_flushThread ( void );
+
+
+/**
+ @brief decide whether a record is a repeat
+ @details messages are compared by hash & then bytes against the previous one from the same key. Before a changed
+ record is let through, the count of repeats it ends is sent as its own record
+ @param[in] table table of the stream the record belongs to
+ @param[in] key identity of the callsite, never dereferenced
+ @param[in] record record of a resolved callsite, its header must be static
+ @return #true if the record must be sent, #false if it was counted as a repeat
+ */
+bool logger_dedup_filter ( LOGGER_DEDUP_TABLE * table, const void * key, const LOGGER_RECORD * record );
+
+
+/**
+ @brief write the counts of runs held longer than the timeout
+ @param[in] table table to check
+ @param[in] now current clock ticks
+ */
+void logger_dedup_expire ( LOGGER_DEDUP_TABLE * table, LOGGER_TICKS now );
+
+
+/**
+ @brief write every pending count & forget all records
+ @param[in] table table to flush
+ */
+void logger_dedup_flush ( LOGGER_DEDUP_TABLE * table );
+
+
+/**
+ @brief write the counts of runs held longer than the timeout in every printing thread's table
+ @details called by the async writer each time it wakes, so a run is written even when its thread has gone
+ quiet. A table its thread is using is skipped until the next call
+ @param[in] send destination of the counts, in place of the tables' own
+ */
+void logger_dedup_expireThreads ( LOGGER_RECORD_SEND send );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _LOGGER_DEDUP_H */
@@ -0,0 +1,439 @@
+/**
+ @file
+ Diagnostics print library - structured record fields
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+/* strnlen */
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logger_fields.h"
+#include "logger_format.h"
+#include "logger_ini.h"
+
+
+/* most bytes of a 64 bit varint */
+#define LOGGER_FIELDS_VARINT_MAX (10U)
+
+/* enough for printf("%.17g") of any double */
+#define LOGGER_FIELDS_DOUBLE_CHARS (32U)
+
+
+/** one field as read back from its encoding */
+typedef struct _LOGGER_FIELD
+{
+    uint8_t type;
+    const char * key;
+    size_t keyLen;
+    uint64_t bits;          /* INT zigzag decoded, UINT, DOUBLE bits or BOOL */
+    const char * str;       /* STR only */
+    size_t strLen;
+} LOGGER_FIELD;
+
+
+static void logger_fields_appendVarint ( LOGGER_RECORD_BUILDER * builder, uint64_t value );
+
+static size_t logger_fields_readVarint ( const uint8_t * data, size_t dataLen, uint64_t * value );
+
+static size_t logger_fields_next ( const uint8_t * data, size_t dataLen, LOGGER_FIELD * field );
+
+static void logger_fields_appendValue ( LOGGER_RECORD_BUILDER * builder, const LOGGER_FIELD * field, bool json );
+
+static bool logger_fields_textNeedsQuotes ( const char * str, size_t strLen );
+
+static void logger_fields_appendQuoted ( LOGGER_RECORD_BUILDER * builder, const char * str, size_t strLen );
+
+
+static void logger_fields_appendVarint ( LOGGER_RECORD_BUILDER * builder, uint64_t value )
+{
+    char bytes[LOGGER_FIELDS_VARINT_MAX];
+    size_t length = 0U;
+
+    /* 7 bits a byte, low bits first, top bit set on all but the last */
+    while ( value >= 0x80U )
+    {
+        bytes[length++] = (char)( ( value & 0x7FU ) | 0x80U );
+        value >>= 7U;
+    }
+
+    bytes[length++] = (char)value;
+
+    logger_record_appendBytes(builder, bytes, length);
+}
+
+/* returns bytes read, 0 if data ends first */
+static size_t logger_fields_readVarint ( const uint8_t * data, size_t dataLen, uint64_t * value )
+{
+    uint64_t result = 0U;
+
+    for ( size_t i=0U; ( i<dataLen ) && ( i<LOGGER_FIELDS_VARINT_MAX ); i++ )
+    {
+        result |= (uint64_t)( data[i] & 0x7FU ) << ( 7U * i );
+
+        if ( ( data[i] & 0x80U ) == 0U )
+        {
+            *value = result;
+            return i + 1U;
+        }
+    }
+
+    return 0U;
+}
+
+/* returns bytes the field takes, 0 if it does not decode */
+static size_t logger_fields_next ( const uint8_t * data, size_t dataLen, LOGGER_FIELD * field )
+{
+    if ( dataLen < 2U )
+    {
+        return 0U;
+    }
+
+    field->type = data[0];
+    field->keyLen = data[1];
+    field->key = (const char *)&data[2];
+    field->bits = 0U;
+    field->str = NULL;
+    field->strLen = 0U;
+
+    size_t offset = 2U + field->keyLen;
+
+    if ( offset > dataLen )
+    {
+        return 0U;
+    }
+
+    size_t used = 0U;
+
+    switch ( field->type )
+    {
+        case LOGGER_KV_TYPE_INT:
+        case LOGGER_KV_TYPE_UINT:
+            used = logger_fields_readVarint(&data[offset], dataLen - offset, &field->bits);
+            break;
+
+        case LOGGER_KV_TYPE_DOUBLE:
+            if ( dataLen - offset >= 8U )
+            {
+                for ( size_t i=0U; i<8U; i++ )
+                {
+                    field->bits |= (uint64_t)data[offset+i] << ( 8U * i );
+                }
+
+                used = 8U;
+            }
+            break;
+
+        case LOGGER_KV_TYPE_BOOL:
+            if ( dataLen - offset >= 1U )
+            {
+                field->bits = data[offset];
+                used = 1U;
+            }
+            break;
+
+        case LOGGER_KV_TYPE_STR:
+        {
+            uint64_t strLen = 0U;
+
+            used = logger_fields_readVarint(&data[offset], dataLen - offset, &strLen);
+
+            if ( ( used == 0U ) || ( strLen > dataLen - offset - used ) )
+            {
+                return 0U;
+            }
+
+            field->str = (const char *)&data[offset+used];
+            field->strLen = (size_t)strLen;
+            used += (size_t)strLen;
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    return ( used != 0U ) ? offset + used : 0U;
+}
+
+static bool logger_fields_textNeedsQuotes ( const char * str, size_t strLen )
+{
+    bool needsQuotes = ( strLen == 0U );
+
+    for ( size_t i=0U; ( i<strLen ) && ( needsQuotes == false ); i++ )
+    {
+        unsigned char c = (unsigned char)str[i];
+
+        needsQuotes = ( c <= ' ' ) || ( c == '"' ) || ( c == '=' ) || ( c == '\\' ) || ( c == 0x7FU );
+    }
+
+    return needsQuotes;
+}
+
+/* "..." with JSON escapes, used for JSON & for text values that would not read back unquoted */
+static void logger_fields_appendQuoted ( LOGGER_RECORD_BUILDER * builder, const char * str, size_t strLen )
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    size_t runStart = 0U;
+
+    logger_record_appendChar(builder, '"');
+
+    for ( size_t i=0U; i<strLen; i++ )
+    {
+        unsigned char c = (unsigned char)str[i];
+
+        if ( ( c >= 0x20U ) && ( c != '"' ) && ( c != '\\' ) )
+        {
+            continue;
+        }
+
+        /* copy the plain run before the char needing an escape */
+        logger_record_appendBytes(builder, &str[runStart], i - runStart);
+        runStart = i + 1U;
+
+        logger_record_appendChar(builder, '\\');
+
+        switch ( c )
+        {
+            case '"':  logger_record_appendChar(builder, '"'); break;
+            case '\\': logger_record_appendChar(builder, '\\'); break;
+            case '\n': logger_record_appendChar(builder, 'n'); break;
+            case '\r': logger_record_appendChar(builder, 'r'); break;
+            case '\t': logger_record_appendChar(builder, 't'); break;
+            default:
+            {
+                char escape[5] = { 'u', '0', '0', hexDigits[c >> 4U], hexDigits[c & 0x0FU] };
+
+                logger_record_appendBytes(builder, escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+
+    logger_record_appendBytes(builder, &str[runStart], strLen - runStart);
+    logger_record_appendChar(builder, '"');
+}
+
+static void logger_fields_appendValue ( LOGGER_RECORD_BUILDER * builder, const LOGGER_FIELD * field, bool json )
+{
+    char text[LOGGER_FIELDS_DOUBLE_CHARS];
+    size_t textLen = 0U;
+
+    switch ( field->type )
+    {
+        case LOGGER_KV_TYPE_INT:
+            /* undo the zigzag */
+            textLen = logger_format_int64(text, (int64_t)( ( field->bits >> 1U ) ^ ( 0U - ( field->bits & 1U ) ) ));
+            break;
+
+        case LOGGER_KV_TYPE_UINT:
+            textLen = logger_format_uint64(text, field->bits);
+            break;
+
+        case LOGGER_KV_TYPE_DOUBLE:
+        {
+            double value = 0.0;
+
+            memcpy(&value, &field->bits, sizeof(value));
+
+            if ( json && ( isfinite(value) == 0 ) )
+            {
+                /* JSON has no NaN or infinity */
+                logger_record_appendBytes(builder, "null", 4U);
+            }
+            else
+            {
+                /* shortest of the two that reads back as the same value */
+                int written = snprintf(text, sizeof(text), "%.15g", value);
+
+                if ( strtod(text, NULL) != value )
+                {
+                    written = snprintf(text, sizeof(text), "%.17g", value);
+                }
+
+                textLen = ( written > 0 ) ? (size_t)written : 0U;
+            }
+            break;
+        }
+
+        case LOGGER_KV_TYPE_BOOL:
+            if ( field->bits != 0U )
+            {
+                logger_record_appendBytes(builder, "true", 4U);
+            }
+            else
+            {
+                logger_record_appendBytes(builder, "false", 5U);
+            }
+            break;
+
+        case LOGGER_KV_TYPE_STR:
+            if ( json || logger_fields_textNeedsQuotes(field->str, field->strLen) )
+            {
+                logger_fields_appendQuoted(builder, field->str, field->strLen);
+            }
+            else
+            {
+                logger_record_appendBytes(builder, field->str, field->strLen);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    logger_record_appendBytes(builder, text, textLen);
+}
+
+void logger_fields_encode ( LOGGER_RECORD_BUILDER * builder, const LOGGER_KV * fields, uint32_t fieldCount )
+{
+    for ( uint32_t i=0U; ( fields != NULL ) && ( i<fieldCount ); i++ )
+    {
+        const LOGGER_KV * kv = &fields[i];
+        const char * key = ( kv->key != NULL ) ? kv->key : "";
+        size_t keyLen = strnlen(key, LOGGER_FIELDS_KEY_MAX);
+        bool known = ( kv->type >= LOGGER_KV_TYPE_INT ) && ( kv->type <= LOGGER_KV_TYPE_STR );
+
+        /* an unknown type is written as an empty string so the fields after it still decode */
+        LOGGER_KV_TYPE type = known ? kv->type : LOGGER_KV_TYPE_STR;
+        char prefix[2] = { (char)type, (char)keyLen };
+
+        logger_record_appendBytes(builder, prefix, sizeof(prefix));
+        logger_record_appendBytes(builder, key, keyLen);
+
+        switch ( type )
+        {
+            case LOGGER_KV_TYPE_INT:
+                /* zigzag keeps small negative numbers short */
+                logger_fields_appendVarint(builder, ( (uint64_t)kv->value.i << 1U ) ^ (uint64_t)( kv->value.i >> 63U ));
+                break;
+
+            case LOGGER_KV_TYPE_UINT:
+                logger_fields_appendVarint(builder, kv->value.u);
+                break;
+
+            case LOGGER_KV_TYPE_DOUBLE:
+            {
+                uint64_t bits = 0U;
+                char bytes[8];
+
+                memcpy(&bits, &kv->value.d, sizeof(bits));
+
+                for ( size_t b=0U; b<sizeof(bytes); b++ )
+                {
+                    bytes[b] = (char)( bits >> ( 8U * b ) );
+                }
+
+                logger_record_appendBytes(builder, bytes, sizeof(bytes));
+                break;
+            }
+
+            case LOGGER_KV_TYPE_BOOL:
+                logger_record_appendChar(builder, kv->value.b ? 1 : 0);
+                break;
+
+            default:
+            {
+                const char * str = ( known && ( kv->value.s != NULL ) ) ? kv->value.s : "";
+                size_t strLen = strlen(str);
+
+                logger_fields_appendVarint(builder, strLen);
+                logger_record_appendBytes(builder, str, strLen);
+                break;
+            }
+        }
+    }
+}
+
+void logger_fields_render ( LOGGER_RECORD_BUILDER * builder, const uint8_t * fields, size_t fieldsLen, LOGGER_FIELDS_FORMAT format )
+{
+    if ( format == LOGGER_FIELDS_FORMAT_BINARY )
+    {
+        char prefix[5] = { (char)LOGGER_FIELDS_BINARY_MARKER, (char)fieldsLen, (char)( fieldsLen >> 8U ),
+                           (char)( fieldsLen >> 16U ), (char)( fieldsLen >> 24U ) };
+
+        logger_record_appendBytes(builder, prefix, sizeof(prefix));
+        logger_record_appendBytes(builder, (const char *)fields, fieldsLen);
+        return;
+    }
+
+    bool json = ( format == LOGGER_FIELDS_FORMAT_JSON );
+    size_t offset = 0U;
+    LOGGER_FIELD field;
+
+    logger_record_appendBytes(builder, json ? " {" : " ", json ? 2U : 1U);
+
+    while ( offset < fieldsLen )
+    {
+        size_t used = logger_fields_next(&fields[offset], fieldsLen - offset, &field);
+
+        if ( used == 0U )
+        {
+            break;
+        }
+
+        if ( offset != 0U )
+        {
+            logger_record_appendChar(builder, json ? ',' : ' ');
+        }
+
+        if ( json )
+        {
+            logger_fields_appendQuoted(builder, field.key, field.keyLen);
+            logger_record_appendChar(builder, ':');
+        }
+        else
+        {
+            logger_record_appendBytes(builder, field.key, field.keyLen);
+            logger_record_appendChar(builder, '=');
+        }
+
+        logger_fields_appendValue(builder, &field, json);
+
+        offset += used;
+    }
+
+    if ( json )
+    {
+        logger_record_appendChar(builder, '}');
+    }
+}
+
+LOGGER_FIELDS_FORMAT logger_fields_formatFromIni ( LOGGER_INI_SECTIONHANDLE paramBag )
+{
+    static const struct
+    {
+        const char * name;
+        LOGGER_FIELDS_FORMAT format;
+    } formats[] =
+    {
+        { "text", LOGGER_FIELDS_FORMAT_TEXT },
+        { "json", LOGGER_FIELDS_FORMAT_JSON },
+        { "binary", LOGGER_FIELDS_FORMAT_BINARY },
+    };
+
+    LOGGER_FIELDS_FORMAT format = LOGGER_FIELDS_FORMAT_TEXT;
+    char *value = NULL;
+    size_t valueLen = 0U;
+
+    logger_ini_sectionRetrieveValueFromKey(paramBag, "fields", strlen("fields"), &value, &valueLen);
+
+    for ( uint32_t i=0U; ( value != NULL ) && ( i<sizeof(formats)/sizeof(formats[0]) ); i++ )
+    {
+        if ( ( strlen(formats[i].name) == valueLen ) && ( strncmp(formats[i].name, value, valueLen) == 0 ) )
+        {
+            format = formats[i].format;
+        }
+    }
+
+    return format;
+}
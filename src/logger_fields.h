@@ -0,0 +1,97 @@
+/**
+ @file
+ Diagnostics print library - structured record fields
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#ifndef _LOGGER_FIELDS_H
+#define _LOGGER_FIELDS_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "logger.h"
+#include "logger_ini.h"
+#include "logger_messageAssemble.h"
+
+
+/**
+ @enum _LOGGER_FIELDS_FORMAT
+ @brief how an output renders the fields of a record, selected by the fields= ini key \n
+ #LOGGER_FIELDS_FORMAT_TEXT key=value pairs after the message, strings quoted when they hold spaces - the default \n
+ #LOGGER_FIELDS_FORMAT_JSON one JSON object after the message \n
+ #LOGGER_FIELDS_FORMAT_BINARY the encoded fields as captured: #LOGGER_FIELDS_BINARY_MARKER, a 4 byte little endian
+ length, then the fields. Suits datagram outputs, a reader of a stream must skip by the length as the bytes may
+ contain newlines
+ */
+typedef enum _LOGGER_FIELDS_FORMAT
+{
+    LOGGER_FIELDS_FORMAT_TEXT = 0,
+    LOGGER_FIELDS_FORMAT_JSON,
+    LOGGER_FIELDS_FORMAT_BINARY,
+} LOGGER_FIELDS_FORMAT;
+
+
+/**
+ @def LOGGER_FIELDS_BINARY_MARKER
+ @brief byte separating the message from binary rendered fields (ASCII record separator)
+ */
+#define LOGGER_FIELDS_BINARY_MARKER (0x1EU)
+
+
+/**
+ @def LOGGER_FIELDS_KEY_MAX
+ @brief longest key kept, longer keys are cut short
+ */
+#define LOGGER_FIELDS_KEY_MAX (255U)
+
+
+/**
+ @brief append fields to a record in their encoded form
+ @details each field is a #LOGGER_KV_TYPE byte, a key length byte, the key, then the value: INT zigzag varint,
+ UINT varint, DOUBLE 8 bytes of IEEE-754 bits little endian, BOOL one byte, STR varint length & the bytes. No value
+ is converted to text here
+ @param[in] builder record being built, fields follow whatever it holds
+ @param[in] fields fields to encode
+ @param[in] fieldCount number of fields
+ */
+void logger_fields_encode ( LOGGER_RECORD_BUILDER * builder, const LOGGER_KV * fields, uint32_t fieldCount );
+
+
+/**
+ @brief render encoded fields for output
+ @details stops at the first field that does not decode, so a cut short record still renders what it has
+ @param[in] builder output the rendering is appended to
+ @param[in] fields encoded fields from #logger_fields_encode
+ @param[in] fieldsLen bytes of fields
+ @param[in] format rendering wanted
+ */
+void logger_fields_render ( LOGGER_RECORD_BUILDER * builder, const uint8_t * fields, size_t fieldsLen, LOGGER_FIELDS_FORMAT format );
+
+
+/**
+ @brief read an output's rendering from its [output=...] section key fields=
+ @details fields = text | json | binary, missing selects text
+ @param[in] paramBag ini section handle
+ @return format the output's fields are rendered in
+ */
+LOGGER_FIELDS_FORMAT logger_fields_formatFromIni ( LOGGER_INI_SECTIONHANDLE paramBag );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _LOGGER_FIELDS_H */
@@ -0,0 +1,195 @@
+/**
+ @file
+ Diagnostics print library - record field formatting
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#include <string.h>
+
+#include "logger_format.h"
+
+
+/* "00" "01" ... "99", indexed by value*2 */
+static const char f_digitPairs[200] =
+{
+    '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+    '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+    '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+    '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+    '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+    '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+    '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+    '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+    '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+    '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9',
+};
+
+
+static size_t logger_format_digitCount ( uint32_t value );
+
+
+static size_t logger_format_digitCount ( uint32_t value )
+{
+    static const uint32_t powers[] =
+    {
+        10U, 100U, 1000U, 10000U, 100000U, 1000000U, 10000000U, 100000000U, 1000000000U
+    };
+
+    size_t count = 1U;
+
+    /* compares only, the common small values leave after one or two */
+    while ( ( count <= sizeof(powers)/sizeof(powers[0]) ) && ( value >= powers[count-1U] ) )
+    {
+        count += 1U;
+    }
+
+    return count;
+}
+
+size_t logger_format_uint32 ( char * out, uint32_t value )
+{
+    size_t length = logger_format_digitCount(value);
+
+    logger_format_fixedDigits(out, value, (uint32_t)length);
+
+    return length;
+}
+
+size_t logger_format_int32 ( char * out, int32_t value )
+{
+    size_t length = 0U;
+    uint32_t magnitude = (uint32_t)value;
+
+    if ( value < 0 )
+    {
+        out[0] = '-';
+        length = 1U;
+        magnitude = 0U - magnitude;
+    }
+
+    return length + logger_format_uint32(&out[length], magnitude);
+}
+
+size_t logger_format_uint64 ( char * out, uint64_t value )
+{
+    if ( value <= UINT32_MAX )
+    {
+        return logger_format_uint32(out, (uint32_t)value);
+    }
+
+    /* the leading digits, then the last nine zero padded */
+    size_t length = logger_format_uint64(out, value / 1000000000U);
+
+    logger_format_fixedDigits(&out[length], (uint32_t)( value % 1000000000U ), 9U);
+
+    return length + 9U;
+}
+
+size_t logger_format_int64 ( char * out, int64_t value )
+{
+    size_t length = 0U;
+    uint64_t magnitude = (uint64_t)value;
+
+    if ( value < 0 )
+    {
+        out[0] = '-';
+        length = 1U;
+        magnitude = 0U - magnitude;
+    }
+
+    return length + logger_format_uint64(&out[length], magnitude);
+}
+
+void logger_format_twoDigits ( char * out, uint32_t value )
+{
+    memcpy(out, &f_digitPairs[(value % 100U) * 2U], 2U);
+}
+
+void logger_format_fixedDigits ( char * out, uint32_t value, uint32_t width )
+{
+    uint32_t pos = width;
+
+    /* filled from the right, a pair at a time */
+    while ( pos >= 2U )
+    {
+        pos -= 2U;
+        logger_format_twoDigits(&out[pos], value);
+        value /= 100U;
+    }
+
+    if ( pos != 0U )
+    {
+        out[0] = (char)('0' + (value % 10U));
+    }
+}
+
+size_t logger_format_radix ( char * out, uint64_t value, uint32_t shift, bool upper )
+{
+    const char * digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    uint64_t mask = ( 1U << shift ) - 1U;
+    size_t length = 0U;
+
+    /* count first so the digits can be written from the right */
+    for ( uint64_t rest = value; ( length == 0U ) || ( rest != 0U ); rest >>= shift )
+    {
+        length += 1U;
+    }
+
+    for ( size_t pos = length; pos > 0U; pos-- )
+    {
+        out[pos-1U] = digits[value & mask];
+        value >>= shift;
+    }
+
+    return length;
+}
+
+size_t logger_format_double ( char * out, double value, uint32_t decimals )
+{
+    size_t length = 0U;
+
+    if ( value != value )
+    {
+        memcpy(out, "nan", 3U);
+        return 3U;
+    }
+
+    if ( value < 0.0 )
+    {
+        out[length] = '-';
+        length += 1U;
+        value = -value;
+    }
+
+    if ( value >= 18446744073709551616.0 )
+    {
+        /* infinity included */
+        memcpy(&out[length], "huge", 4U);
+        return length + 4U;
+    }
+
+    uint64_t whole = (uint64_t)value;
+
+    length += logger_format_uint64(&out[length], whole);
+
+    decimals = ( decimals < 9U ) ? decimals : 9U;
+
+    if ( decimals != 0U )
+    {
+        static const uint32_t scales[10] =
+        {
+            1U, 10U, 100U, 1000U, 10000U, 100000U, 1000000U, 10000000U, 100000000U, 1000000000U
+        };
+
+        out[length] = '.';
+        logger_format_fixedDigits(&out[length+1U], (uint32_t)( ( value - (double)whole ) * (double)scales[decimals] ), decimals);
+        length += 1U + decimals;
+    }
+
+    return length;
+}
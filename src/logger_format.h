@@ -0,0 +1,137 @@
+/**
+ @file
+ Diagnostics print library - record field formatting
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#ifndef _LOGGER_FORMAT_H
+#define _LOGGER_FORMAT_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/**
+ @def LOGGER_FORMAT_INT32_CHARS
+ @brief most chars written by #logger_format_int32, "-2147483648"
+ */
+#define LOGGER_FORMAT_INT32_CHARS (11U)
+
+
+/**
+ @def LOGGER_FORMAT_INT64_CHARS
+ @brief most chars written by #logger_format_int64, "-9223372036854775808"
+ */
+#define LOGGER_FORMAT_INT64_CHARS (20U)
+
+
+/**
+ @brief write an unsigned integer in decimal
+ @details two digits per table lookup, no printf parsing. Nothing is NULL terminated
+ @param[out] out at least 10 chars
+ @param[in] value value to write
+ @return number of chars written
+ */
+size_t logger_format_uint32 ( char * out, uint32_t value );
+
+
+/**
+ @brief write a signed integer in decimal, as printf("%d")
+ @param[out] out at least #LOGGER_FORMAT_INT32_CHARS chars
+ @param[in] value value to write
+ @return number of chars written
+ */
+size_t logger_format_int32 ( char * out, int32_t value );
+
+
+/**
+ @brief write a 64 bit unsigned integer in decimal
+ @details values that fit 32 bits take the #logger_format_uint32 path
+ @param[out] out at least 20 chars
+ @param[in] value value to write
+ @return number of chars written
+ */
+size_t logger_format_uint64 ( char * out, uint64_t value );
+
+
+/**
+ @brief write a 64 bit signed integer in decimal, as printf("%lld")
+ @param[out] out at least #LOGGER_FORMAT_INT64_CHARS chars
+ @param[in] value value to write
+ @return number of chars written
+ */
+size_t logger_format_int64 ( char * out, int64_t value );
+
+
+/**
+ @brief write the last two decimal digits of a value, zero padded, as printf("%02d") for 0-99
+ @param[out] out 2 chars
+ @param[in] value value to write, taken modulo 100
+ */
+void logger_format_twoDigits ( char * out, uint32_t value );
+
+
+/**
+ @brief write exactly width decimal digits, zero padded on the left & keeping the lowest digits
+ @param[out] out width chars
+ @param[in] value value to write
+ @param[in] width number of digits, 0 writes nothing
+ */
+void logger_format_fixedDigits ( char * out, uint32_t value, uint32_t width );
+
+
+/**
+ @def LOGGER_FORMAT_RADIX_CHARS
+ @brief most chars written by #logger_format_radix, a 64 bit value in octal
+ */
+#define LOGGER_FORMAT_RADIX_CHARS (22U)
+
+
+/**
+ @brief write an unsigned integer in base 8 or 16, as printf("%llo") / ("%llx")
+ @param[out] out at least #LOGGER_FORMAT_RADIX_CHARS chars
+ @param[in] value value to write
+ @param[in] shift 3 for octal, 4 for hexadecimal
+ @param[in] upper #true for upper case hex digits
+ @return number of chars written
+ */
+size_t logger_format_radix ( char * out, uint64_t value, uint32_t shift, bool upper );
+
+
+/**
+ @def LOGGER_FORMAT_DOUBLE_CHARS
+ @brief most chars written by #logger_format_double
+ */
+#define LOGGER_FORMAT_DOUBLE_CHARS (32U)
+
+
+/**
+ @brief write a floating point value with a fixed number of decimals, without printf
+ @details for paths that may not call printf e.g. a signal handler. Magnitudes too large for 64 bits of integer
+ part are written as "huge", the last decimal is not rounded
+ @param[out] out at least #LOGGER_FORMAT_DOUBLE_CHARS chars
+ @param[in] value value to write
+ @param[in] decimals digits after the point, at most 9
+ @return number of chars written
+ */
+size_t logger_format_double ( char * out, double value, uint32_t decimals );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _LOGGER_FORMAT_H */
@@ -9,6 +9,8 @@
  */
 
 
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -16,6 +18,7 @@
 #include "logger_ini.h"
 #include "logger_common.h"
 #include "logger_stringUtil.h"
+#include "logger_memory.h"
 
 
 typedef struct _IniSection
@@ -33,18 +36,50 @@ typedef struct _IniSection
 } IniSection;
 
 
-static void **f_sectionsArray;
-static uint32_t f_sectionsArrayCount = 0U;
+/** one parsed ini file. Never changed once published, a reload publishes a new one */
+typedef struct _IniSnapshot
+{
+    IniSection **sections;
+    uint32_t sectionCount;
+} IniSnapshot;
+
+
+static IniSnapshot * f_snapshot = NULL;
+
+/* threads between logger_ini_readBegin & logger_ini_readEnd, a replaced snapshot is freed once this is 0 */
+static uint32_t f_snapshotReaders = 0U;
+
+/* serialises loads & guards f_iniPath, the file logger_ini_reload reads again */
+static pthread_mutex_t f_mutex_load = PTHREAD_MUTEX_INITIALIZER;
+static char * f_iniPath = NULL;
+
+
+static IniSection * logger_ini_createSection ( char *sectionName, size_t sectionNameLen, char *sectionBuffer, size_t sectionBufferLen );
+
+static IniSnapshot * logger_ini_current ( void );
+
+static IniSection* logger_ini_sectionAtIndex ( const IniSnapshot * snapshot, uint32_t idx );
+
+static uint32_t logger_ini_numberOfSectionsInBuffer ( const char * fileBuffer, size_t fileBufferSize );
+
+static void logger_ini_formatFileBuffer ( char * fileBuffer, size_t fileBufferSize );
+
+static IniSnapshot * logger_ini_loadFileBuffer ( char * fileBuffer, size_t fileBufferSize );
+
+static bool logger_ini_load ( const char * filePath );
+
+static void logger_ini_publish ( IniSnapshot * snapshot, void * retired );
 
 
 static IniSection * logger_ini_createSection ( char *sectionName, size_t sectionNameLen, char *sectionBuffer, size_t sectionBufferLen )
 {
-    IniSection *setting = logger_memAlloc(sizeof(IniSection));
+    /* everything parsed lives in the config arena & is released together by logger_ini_term */
+    IniSection *setting = logger_mem_configAlloc(sizeof(IniSection));
     
     if ( setting )
     {
-        char * l_name = logger_memAlloc(sizeof(char) * sectionNameLen);
-        char * l_buffer = logger_memAlloc(sizeof(char) * sectionBufferLen);
+        char * l_name = logger_mem_configAlloc(sizeof(char) * (sectionNameLen+1U));
+        char * l_buffer = logger_mem_configAlloc(sizeof(char) * (sectionBufferLen+1U));
         
         if ( ( l_name ) && ( l_buffer ) )
         {
@@ -63,8 +98,8 @@ static IniSection * logger_ini_createSection ( char *sectionName, size_t section
             
             uint32_t allocSize = sizeof(char*) * setting->numberOfKeys;
             
-            setting->keyNames = logger_memAlloc(allocSize);
-            setting->valueNames = logger_memAlloc(allocSize);
+            setting->keyNames = logger_mem_configAlloc(allocSize);
+            setting->valueNames = logger_mem_configAlloc(allocSize);
             
             for ( uint32_t i=0U; i<setting->numberOfKeys; i++ )
             {
@@ -97,7 +132,7 @@ static IniSection * logger_ini_createSection ( char *sectionName, size_t section
                 char *keyName = newlineOffsetBefore + 1U;
                 size_t keyLen = ( equalsOffset - newlineOffsetBefore );
                 
-                setting->keyNames[x] = logger_memAlloc( sizeof(char) * keyLen );
+                setting->keyNames[x] = logger_mem_configAlloc( sizeof(char) * keyLen );
                 
                 strncpy(setting->keyNames[x], keyName, keyLen);
                 
@@ -127,7 +162,7 @@ static IniSection * logger_ini_createSection ( char *sectionName, size_t section
                 
                 if ( valueLen > 0 )
                 {
-                    setting->valueNames[x] = logger_memAlloc( sizeof(char) * valueLen );
+                    setting->valueNames[x] = logger_mem_configAlloc( sizeof(char) * valueLen );
                     
                     strncpy(setting->valueNames[x], valueName, valueLen);
                     
@@ -137,9 +172,6 @@ static IniSection * logger_ini_createSection ( char *sectionName, size_t section
         }
         else
         {
-            logger_memFree(l_name);
-            logger_memFree(l_buffer);
-            
             setting = NULL;
         }
     }
@@ -147,58 +179,24 @@ static IniSection * logger_ini_createSection ( char *sectionName, size_t section
     return setting;
 }
 
-static void logger_ini_freeSection ( IniSection *section )
+/* ordered after a reader's count is raised, so logger_ini_publish sees the count before freeing what was read */
+static IniSnapshot * logger_ini_current ( void )
 {
-    if ( section )
-    {
-        if ( section->sectionName )
-        {
-            logger_memFree((void*)section->sectionName);
-            logger_memFree((void*)section->buffer);
-            
-            for ( uint32_t i=0U; i<section->numberOfKeys; i++ )
-            {
-                logger_memFree( *(section->keyNames + i) );
-                
-                if ( *(section->valueNames + i) )
-                {
-                    logger_memFree( *(section->valueNames + i) );
-                }
-            }
-        }
-    }
-    
-    logger_memFree(section);
+    return __atomic_load_n(&f_snapshot, __ATOMIC_SEQ_CST);
 }
 
-static IniSection* logger_ini_sectionAtIndex ( uint32_t idx )
+static IniSection* logger_ini_sectionAtIndex ( const IniSnapshot * snapshot, uint32_t idx )
 {
     IniSection * s = NULL;
     
-    if ( idx < f_sectionsArrayCount )
+    if ( ( snapshot != NULL ) && ( idx < snapshot->sectionCount ) )
     {
-        s = *(f_sectionsArray + idx);
+        s = *(snapshot->sections + idx);
     }
     
     return s;
 }
 
-static bool logger_ini_removeSection ( IniSection *section )
-{
-    bool didAdd = false;
-    
-    for ( uint32_t i=0U; i<f_sectionsArrayCount; i++ )
-    {
-        if ( *(f_sectionsArray + i) == section )
-        {
-            *(f_sectionsArray + i) = section;
-            didAdd = true;
-        }
-    }
-    
-    return didAdd;
-}
-
 static uint32_t logger_ini_numberOfSectionsInBuffer ( const char * fileBuffer, size_t fileBufferSize )
 {
     uint32_t count = 0U;
@@ -272,19 +270,33 @@ static void logger_ini_formatFileBuffer ( char * fileBuffer, size_t fileBufferSi
 
 }
 
-static bool logger_ini_loadFileBuffer ( char * fileBuffer, size_t fileBufferSize )
+static IniSnapshot * logger_ini_loadFileBuffer ( char * fileBuffer, size_t fileBufferSize )
 {
     logger_ini_formatFileBuffer(fileBuffer, fileBufferSize);
     
-    f_sectionsArrayCount = logger_ini_numberOfSectionsInBuffer(fileBuffer, fileBufferSize);
+    IniSnapshot * snapshot = logger_mem_configAlloc(sizeof(IniSnapshot));
+    
+    if ( snapshot == NULL )
+    {
+        LOGPRINT_LOG_E("Malloc failure !!!");
+        return NULL;
+    }
+    
+    snapshot->sectionCount = logger_ini_numberOfSectionsInBuffer(fileBuffer, fileBufferSize);
     
-    uint32_t allocSize = sizeof(IniSection*) * f_sectionsArrayCount;
+    uint32_t allocSize = sizeof(IniSection*) * snapshot->sectionCount;
     
-    f_sectionsArray = logger_memAlloc(allocSize);
+    snapshot->sections = logger_mem_configAlloc(allocSize);
     
-    for ( uint32_t i=0U; i<f_sectionsArrayCount; i++ )
+    if ( ( snapshot->sections == NULL ) && ( allocSize != 0U ) )
     {
-        *(f_sectionsArray + i) = (void*)0;
+        LOGPRINT_LOG_E("Malloc failure !!!");
+        return NULL;
+    }
+    
+    for ( uint32_t i=0U; i<snapshot->sectionCount; i++ )
+    {
+        *(snapshot->sections + i) = (void*)0;
     }
     
     size_t currentOffset = 0U;
@@ -292,20 +304,21 @@ static bool logger_ini_loadFileBuffer ( char * fileBuffer, size_t fileBufferSize
     while ( ( currentOffset < fileBufferSize ) && ( fileBuffer[currentOffset] != 0 ) )
     {
         char *sectionTagStart = logger_string_findFirstOccurenceOfChar(&fileBuffer[currentOffset], '[') + 1U;
-        char *sectionTagEnd = logger_string_findFirstOccurenceOfChar(sectionTagStart+1U, ']');
+        char *sectionTagEnd = logger_string_findFirstOccurenceOfChar(sectionTagStart, ']');
 
-        char *bufferTagStart = sectionTagEnd+1U;
-        char *bufferTagEnd = logger_string_findFirstOccurenceOfChar(bufferTagStart+1U, '[');
+        /* an empty last section ends at the terminator, never search past it */
+        char *bufferTagStart = ( *sectionTagEnd != '\0' ) ? sectionTagEnd+1U : sectionTagEnd;
+        char *bufferTagEnd = logger_string_findFirstOccurenceOfChar(bufferTagStart, '[');
 
         IniSection *section = logger_ini_createSection(sectionTagStart, sectionTagEnd-sectionTagStart, bufferTagStart, bufferTagEnd-bufferTagStart);
         
         if ( section )
         {
-            for ( uint32_t i=0U; i<f_sectionsArrayCount; i++ )
+            for ( uint32_t i=0U; i<snapshot->sectionCount; i++ )
             {
-                if ( logger_ini_sectionAtIndex(i) == NULL )
+                if ( logger_ini_sectionAtIndex(snapshot, i) == NULL )
                 {
-                    *(f_sectionsArray + i) = section;
+                    *(snapshot->sections + i) = section;
                     break;
                 }
             }
@@ -314,7 +327,7 @@ static bool logger_ini_loadFileBuffer ( char * fileBuffer, size_t fileBufferSize
         currentOffset = bufferTagEnd - fileBuffer;
     }
     
-    return true;
+    return snapshot;
 }
 
 static void logger_ini_getSectionKeyByIndex( IniSection *section, uint32_t index, char *key, uint32_t *keyLen )
@@ -350,65 +363,161 @@ static void logger_ini_getSectionKeyByIndex( IniSection *section, uint32_t index
     
 }
 
-bool logger_ini_initFromFile ( const char * filePath, size_t filePathLen )
+/* f_mutex_load held */
+static bool logger_ini_load ( const char * filePath )
 {
     bool didInit = false;
+    FILE *filePointer = ( filePath != NULL ) ? fopen(filePath, "r") : NULL;
     
-    if ( filePath )
+    if ( filePointer )
     {
-        FILE *filePointer = fopen(filePath, "r");
-        
         fseek(filePointer , 0 , SEEK_END);
         size_t fileBufferSize = ftell(filePointer);
         rewind(filePointer);
         
-        char *fileBuffer = logger_memAlloc(sizeof(char) * fileBufferSize);
-        
-        fread(fileBuffer, 1, fileBufferSize, filePointer);
+        /* the file text is only needed while it is parsed, the parser scans for the terminating \0 */
+        LOGGER_MEM_MARK mark = logger_mem_scratchMark();
+        char *fileBuffer = logger_mem_scratchAlloc(sizeof(char) * (fileBufferSize+1U));
         
         if ( fileBuffer )
         {
-            didInit = logger_ini_loadFileBuffer((char*)fileBuffer,fileBufferSize);
+            fileBufferSize = fread(fileBuffer, 1, fileBufferSize, filePointer);
+            fileBuffer[fileBufferSize] = '\0';
+            
+            /* the settings being replaced stay readable while the new ones are parsed */
+            void * retired = logger_mem_configDetach();
+            IniSnapshot * snapshot = logger_ini_loadFileBuffer((char*)fileBuffer,fileBufferSize);
+            
+            if ( snapshot != NULL )
+            {
+                logger_ini_publish(snapshot, retired);
+            }
+            else
+            {
+                /* a failed load keeps the settings in force */
+                logger_mem_configRestore(retired);
+            }
+            
+            didInit = ( snapshot != NULL );
         }
         
-        logger_memFree(fileBuffer);
+        logger_mem_scratchRelease(mark);
+        
+        fclose(filePointer);
     }
     
     return didInit;
 }
 
-void logger_ini_term ( void )
+/* f_mutex_load held. Swap in snapshot, then free the old one once every reader that could hold it is done */
+static void logger_ini_publish ( IniSnapshot * snapshot, void * retired )
 {
-    for ( uint32_t i=0U; i<f_sectionsArrayCount; i++ )
+    __atomic_store_n(&f_snapshot, snapshot, __ATOMIC_SEQ_CST);
+    
+    while ( __atomic_load_n(&f_snapshotReaders, __ATOMIC_SEQ_CST) != 0U )
+    {
+        sched_yield();
+    }
+    
+    logger_mem_configFree(retired);
+}
+
+bool logger_ini_initFromFile ( const char * filePath, size_t filePathLen )
+{
+    pthread_mutex_lock(&f_mutex_load);
+    
+    bool didInit = logger_ini_load(filePath);
+    
+    if ( didInit )
     {
-        IniSection *section = logger_ini_sectionAtIndex(i);
+        /* kept for logger_ini_reload */
+        char * path = logger_mem_alloc(filePathLen+1U);
         
-        logger_ini_removeSection(section);
+        if ( path != NULL )
+        {
+            memcpy(path, filePath, filePathLen);
+            path[filePathLen] = '\0';
+        }
+        
+        logger_mem_free(f_iniPath);
+        f_iniPath = path;
+    }
+    
+    pthread_mutex_unlock(&f_mutex_load);
+    
+    return didInit;
+}
+
+bool logger_ini_reload ( void )
+{
+    pthread_mutex_lock(&f_mutex_load);
+    
+    bool didLoad = ( f_iniPath != NULL ) && logger_ini_load(f_iniPath);
+    
+    pthread_mutex_unlock(&f_mutex_load);
+    
+    return didLoad;
+}
+
+bool logger_ini_filePath ( char * filePath, size_t filePathSize )
+{
+    bool found = false;
+    
+    pthread_mutex_lock(&f_mutex_load);
+    
+    if ( ( f_iniPath != NULL ) && ( strlen(f_iniPath) < filePathSize ) )
+    {
+        strcpy(filePath, f_iniPath);
+        found = true;
     }
     
-    f_sectionsArray = NULL;
-    f_sectionsArrayCount = 0U;
+    pthread_mutex_unlock(&f_mutex_load);
+    
+    return found;
+}
+
+void logger_ini_term ( void )
+{
+    pthread_mutex_lock(&f_mutex_load);
+    
+    logger_ini_publish(NULL, logger_mem_configDetach());
+    
+    logger_mem_free(f_iniPath);
+    f_iniPath = NULL;
+    
+    pthread_mutex_unlock(&f_mutex_load);
+}
+
+void logger_ini_readBegin ( void )
+{
+    __atomic_add_fetch(&f_snapshotReaders, 1U, __ATOMIC_SEQ_CST);
+}
+
+void logger_ini_readEnd ( void )
+{
+    __atomic_sub_fetch(&f_snapshotReaders, 1U, __ATOMIC_RELEASE);
 }
 
 bool logger_ini_isFileOpen ( void )
 {
-    return f_sectionsArray != NULL;
+    return logger_ini_current() != NULL;
 }
 
 uint32_t logger_ini_numberOfSections ( void )
 {
-    return f_sectionsArrayCount;
+    IniSnapshot * snapshot = logger_ini_current();
+    
+    return ( snapshot != NULL ) ? snapshot->sectionCount : 0U;
 }
 
 
 LOGGER_INI_STATUS logger_ini_sectionHandleByIndex ( LOGGER_INI_SECTIONHANDLE *handle, uint32_t sectionIndex, char **sectionName, size_t *sectionLen )
 {
     LOGGER_INI_STATUS status = LOGGER_INI_STATUS_UNDEF;
+    IniSection *section = logger_ini_sectionAtIndex(logger_ini_current(), sectionIndex);
     
-    if ( ( handle != NULL ) && ( sectionIndex < f_sectionsArrayCount ) )
+    if ( ( handle != NULL ) && ( section != NULL ) )
     {
-        IniSection *section = logger_ini_sectionAtIndex(sectionIndex);
-
         *handle = section;
         
         if ( sectionName )
@@ -436,9 +545,11 @@ LOGGER_INI_STATUS logger_ini_sectionHandleByName ( LOGGER_INI_SECTIONHANDLE *han
     
     if ( ( handle != NULL ) && ( sectionName != NULL ) )
     {
-        for ( uint32_t i=0U; i<f_sectionsArrayCount; i++ )
+        IniSnapshot * snapshot = logger_ini_current();
+        
+        for ( uint32_t i=0U; ( snapshot != NULL ) && ( i<snapshot->sectionCount ); i++ )
         {
-            IniSection *section = logger_ini_sectionAtIndex(i);
+            IniSection *section = logger_ini_sectionAtIndex(snapshot, i);
             
             /* since strcmp can be an expensive operation. Lets compare the string length first */
             if ( section->sectionNameLen == sectionNameLen )
@@ -469,8 +580,10 @@ LOGGER_INI_STATUS logger_ini_sectionNumberOfKeyValuePairs ( LOGGER_INI_SECTIONHA
     {
         IniSection *section = (IniSection *)handle;
         
-        /* at this point after the buffer formatting. The number of lines indicates the number of k,v pairs. Minus 1 for section name */
-        *kvpairCount = logger_string_numberOfOccurencesOfChar(section->buffer,section->bufferLen,'\n') - 1U;
+        /* one key per '=' found when the section was parsed, matches what was allocated in logger_ini_createSection */
+        *kvpairCount = section->numberOfKeys;
+        
+        status = LOGGER_INI_STATUS_SUCCESS;
     }
     else
     {
@@ -488,8 +601,7 @@ LOGGER_INI_STATUS logger_ini_sectionRetrieveKeyValueAtIndex ( LOGGER_INI_SECTION
     {
         IniSection *section = (IniSection *)handle;
         
-        /* at this point after the buffer formatting. The number of lines indicates the number of k,v pairs. Minus 1 for section name */
-        uint32_t numberOfKeyValuePairs = logger_string_numberOfOccurencesOfChar(section->buffer,section->bufferLen,'\n') - 1U;
+        uint32_t numberOfKeyValuePairs = section->numberOfKeys;
 
         if ( sectionIdx < numberOfKeyValuePairs )
         {
@@ -20,6 +20,7 @@ extern "C" {
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 
 
 /**
@@ -63,6 +64,38 @@ bool logger_ini_initFromFile ( const char * filePath, size_t filePathLen );
  @brief Closes ini file
  */
 void logger_ini_term ( void );
+
+
+/**
+ @brief Read the file given to #logger_ini_initFromFile again
+ @details the new settings are parsed on the calling thread & swapped in whole, the old ones are freed once no
+ thread is between #logger_ini_readBegin & #logger_ini_readEnd
+ @return #true on success, the previous settings are kept when the file cannot be opened
+ */
+bool logger_ini_reload ( void );
+
+
+/**
+ @brief Get the path given to the last successful #logger_ini_initFromFile
+ @param[out] filePath NULL terminated copy of the path
+ @param[in] filePathSize size of filePath
+ @return #false when no file is loaded or the path does not fit
+ */
+bool logger_ini_filePath ( char * filePath, size_t filePathSize );
+
+
+/**
+ @brief Keep the current settings alive while they are read
+ @details a reload may swap in new settings at any time, section handles & values read after this call stay
+ valid until #logger_ini_readEnd. Calls may nest. Never taken by a print, only where settings are read
+ */
+void logger_ini_readBegin ( void );
+
+
+/**
+ @brief End a #logger_ini_readBegin, no section handle or value read since may be used afterwards
+ */
+void logger_ini_readEnd ( void );
     
     
 /**
@@ -0,0 +1,193 @@
+/**
+ @file
+ Diagnostics print library - ini file watcher
+ 
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+/* poll */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+#include "logger_iniWatch.h"
+#include "logger_common.h"
+#include "logger_ini.h"
+#include "logger_stringUtil.h"
+
+
+#define LOGGER_INIWATCH_PATH_SIZE (4096U)
+
+/* how long the thread waits for an event before checking it should stop */
+#define LOGGER_INIWATCH_POLL_MS (100)
+
+
+static pthread_t f_watchThread;
+
+static bool f_watchRunning = false;
+
+static int f_watchFd = -1;
+
+/* the file's name within the watched directory */
+static char f_watchName[LOGGER_INIWATCH_PATH_SIZE];
+
+
+#ifdef __linux__
+
+static void * logger_iniWatch_thread ( void * arg );
+
+
+static void * logger_iniWatch_thread ( void * arg )
+{
+    (void)arg;
+    
+    /* room for at least one event with the longest name */
+    char events[sizeof(struct inotify_event) + LOGGER_INIWATCH_PATH_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+    
+    while ( __atomic_load_n(&f_watchRunning, __ATOMIC_ACQUIRE) )
+    {
+        struct pollfd pollFd = { f_watchFd, POLLIN, 0 };
+        
+        if ( poll(&pollFd, 1, LOGGER_INIWATCH_POLL_MS) <= 0 )
+        {
+            continue;
+        }
+        
+        ssize_t readLen = read(f_watchFd, events, sizeof(events));
+        bool changed = false;
+        
+        for ( ssize_t offset = 0; offset < readLen; )
+        {
+            const struct inotify_event * event = (const struct inotify_event *)&events[offset];
+            
+            if ( ( event->len != 0U ) && ( strcmp(event->name, f_watchName) == 0 ) )
+            {
+                changed = true;
+            }
+            
+            offset += (ssize_t)(sizeof(struct inotify_event) + event->len);
+        }
+        
+        /* one reload for a burst of events */
+        if ( changed )
+        {
+            (void)loggerReloadIniFile();
+        }
+    }
+    
+    return NULL;
+}
+
+bool logger_iniWatch_isWantedFromIni ( LOGGER_INI_SECTIONHANDLE paramBag )
+{
+    char *value = NULL;
+    size_t valueLen = 0U;
+    
+    logger_ini_sectionRetrieveValueFromKey(paramBag, "ini_watch", strlen("ini_watch"), &value, &valueLen);
+    
+    return logger_string_isTrue(value, valueLen);
+}
+
+void logger_iniWatch_start ( void )
+{
+    char path[LOGGER_INIWATCH_PATH_SIZE];
+    
+    if ( f_watchRunning )
+    {
+        return;
+    }
+    
+    if ( logger_ini_filePath(path, sizeof(path)) == false )
+    {
+        LOGPRINT_LOG_E("ini_watch without an ini file path");
+        return;
+    }
+    
+    /* the directory is watched, a file renamed over the old one keeps being seen */
+    char * separator = strrchr(path, '/');
+    const char * directory = ".";
+    
+    if ( separator != NULL )
+    {
+        *separator = '\0';
+        directory = ( separator == path ) ? "/" : path;
+    }
+    
+    strcpy(f_watchName, ( separator != NULL ) ? separator+1U : path);
+    
+    f_watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    
+    if ( ( f_watchFd < 0 ) || ( inotify_add_watch(f_watchFd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0 ) )
+    {
+        LOGPRINT_LOG_E("Cannot watch %s for ini changes",directory);
+        
+        if ( f_watchFd >= 0 )
+        {
+            close(f_watchFd);
+            f_watchFd = -1;
+        }
+        return;
+    }
+    
+    __atomic_store_n(&f_watchRunning, true, __ATOMIC_RELEASE);
+    
+    if ( pthread_create(&f_watchThread, NULL, logger_iniWatch_thread, NULL) != 0 )
+    {
+        LOGPRINT_LOG_E("Failed to start ini watch thread");
+        
+        __atomic_store_n(&f_watchRunning, false, __ATOMIC_RELEASE);
+        close(f_watchFd);
+        f_watchFd = -1;
+    }
+}
+
+void logger_iniWatch_stop ( void )
+{
+    if ( __atomic_load_n(&f_watchRunning, __ATOMIC_ACQUIRE) )
+    {
+        __atomic_store_n(&f_watchRunning, false, __ATOMIC_RELEASE);
+        
+        pthread_join(f_watchThread, NULL);
+        
+        close(f_watchFd);
+        f_watchFd = -1;
+    }
+}
+
+#else /* __linux__ */
+
+bool logger_iniWatch_isWantedFromIni ( LOGGER_INI_SECTIONHANDLE paramBag )
+{
+    char *value = NULL;
+    size_t valueLen = 0U;
+    
+    logger_ini_sectionRetrieveValueFromKey(paramBag, "ini_watch", strlen("ini_watch"), &value, &valueLen);
+    
+    if ( logger_string_isTrue(value, valueLen) )
+    {
+        LOGPRINT_LOG_W("ini_watch is not supported on this platform, use loggerReloadIniFile");
+    }
+    
+    return false;
+}
+
+void logger_iniWatch_start ( void )
+{
+}
+
+void logger_iniWatch_stop ( void )
+{
+}
+
+#endif /* __linux__ */
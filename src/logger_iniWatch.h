@@ -0,0 +1,56 @@
+/**
+ @file
+ Diagnostics print library - ini file watcher
+ 
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#ifndef _LOGGER_INIWATCH_H
+#define _LOGGER_INIWATCH_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdbool.h>
+
+#include "logger.h"
+#include "logger_ini.h"
+
+
+/**
+ @brief read the [output=...] section key ini_watch=
+ @details Linux only, elsewhere the key is ignored with a warning
+ @param[in] paramBag ini section handle
+ @return #true when #logger_iniWatch_start should be called
+ */
+bool logger_iniWatch_isWantedFromIni ( LOGGER_INI_SECTIONHANDLE paramBag );
+
+
+/**
+ @brief watch the loaded ini file. Does nothing when already running
+ @details a thread calls #loggerReloadIniFile each time the file is written or replaced, editors that save by
+ renaming a new file over the old one are seen too. Takes the ini load lock, so must not be called between
+ logger_ini_readBegin & logger_ini_readEnd: a reload waiting for readers holds that lock
+ */
+void logger_iniWatch_start ( void );
+
+
+/**
+ @brief stop watching & join the thread. Does nothing when it is not running
+ */
+void logger_iniWatch_stop ( void );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _LOGGER_INIWATCH_H */
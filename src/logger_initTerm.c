@@ -9,10 +9,28 @@
  */
 
 
+/* clock_gettime */
+#define _POSIX_C_SOURCE 200809L
+
 #include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include "logger_initTerm.h"
+#include "logger_clock.h"
+#include "logger_messageAssemble.h"
+#include "logger_ring.h"
+#include "logger_binary.h"
+#include "logger_dedup.h"
+#include "logger_fields.h"
+#include "logger_metrics.h"
+#include "logger_backpressure.h"
+#include "logger_crash.h"
+#include "logger_iniWatch.h"
+#include "logger_levelManagement.h"
+#include "logger_stringUtil.h"
 #include "logger_pluginStdout.h"
 #include "logger_pluginFile.h"
 #include "logger_pluginUdp.h"
@@ -23,10 +41,106 @@ static uint32_t f_registeredCount = 0U;
 
 static pthread_mutex_t f_mutex_initCount = PTHREAD_MUTEX_INITIALIZER;
 
+
+/** a thread that sleeps until it is woken or its idle poll comes round */
+typedef struct _LOGGER_WORKER
+{
+    bool running;
+    pthread_t thread;
+    pthread_mutex_t wakeMutex;
+    pthread_cond_t wakeCond;
+} LOGGER_WORKER;
+
+
+/** a ring of records drained by its own thread */
+typedef struct _LOGGER_QUEUE
+{
+    LOGGER_RING ring;
+    LOGGER_WORKER worker;
+    LOGGER_BACKPRESSURE policy;     /* from backpressure= of the output's section */
+    uint32_t dropped;   /* since the thread last reported them */
+} LOGGER_QUEUE;
+
+
+/* longest name= kept for an output, terminator included */
+#define LOGGER_OUTPUT_NAME_SIZE (32U)
+
+
+/** one started [output=...] section */
+typedef struct _LOGGER_OUTPUT
+{
+    uint32_t plugin;    /* index into the plugin arrays */
+    void * instance;    /* the plugin's context for this section */
+    char name[LOGGER_OUTPUT_NAME_SIZE];    /* from name=, the plugin name when the section has none */
+    bool bound;         /* has a name=, only handles bound to it are sent to it */
+    LOGGER_LEVEL_FLAGS levels;  /* from levels=, every level when the section has none */
+    LOGGER_FIELDS_FORMAT fields;    /* from fields= */
+    bool crashFlush;    /* from crash_flush=, written to by the crash handler */
+    bool async;         /* from async=, implied when there is more than one output or binary capture */
+    uint32_t queueSlots;    /* from queue= */
+    bool queued;        /* sent from its own queue, a slow output then holds up no other */
+    LOGGER_QUEUE queue;
+} LOGGER_OUTPUT;
+
+
 static LOGGER_STATUS logger_startup ( void );
 
 static LOGGER_STATUS logger_shutdown ( void );
 
+static bool logger_worker_start ( LOGGER_WORKER * worker, void * (*threadMain)(void *), void * arg );
+
+static void logger_worker_stop ( LOGGER_WORKER * worker );
+
+static bool logger_worker_isRunning ( LOGGER_WORKER * worker );
+
+static void logger_worker_wait ( LOGGER_WORKER * worker );
+
+static void logger_worker_wake ( LOGGER_WORKER * worker );
+
+static bool logger_queue_start ( LOGGER_QUEUE * queue, uint32_t slotCount, void * (*threadMain)(void *), void * arg );
+
+static void logger_queue_stop ( LOGGER_QUEUE * queue );
+
+static bool logger_queue_push ( LOGGER_QUEUE * queue, const LOGGER_RECORD * record );
+
+static void logger_queue_drop ( LOGGER_QUEUE * queue );
+
+static uint32_t logger_queue_takeDropped ( LOGGER_QUEUE * queue );
+
+static void logger_output_configureFromIni ( LOGGER_OUTPUT * output, LOGGER_INI_SECTIONHANDLE paramBag );
+
+static void logger_output_warnGlobalKeys ( LOGGER_INI_SECTIONHANDLE paramBag, const char * outputName );
+
+static void logger_async_start ( bool binaryCapture );
+
+static void logger_async_stop ( void );
+
+static uint32_t logger_async_drain ( void );
+
+static void * logger_async_writerMain ( void * arg );
+
+static uint32_t logger_output_drain ( LOGGER_OUTPUT * output );
+
+static void * logger_output_senderMain ( void * arg );
+
+static LOGGER_STATUS logger_output_dispatch ( const LOGGER_RECORD * record );
+
+static uint32_t logger_output_route ( LOGGER_LEVEL level, uint32_t outputs );
+
+static void logger_output_buildRoutes ( void );
+
+static LOGGER_STATUS logger_plugin_transmit ( const LOGGER_RECORD * record, uint32_t targets );
+
+static LOGGER_STATUS logger_plugin_sendv ( const LOGGER_OUTPUT * output, const struct iovec * segments, int segmentCount );
+
+static LOGGER_STATUS logger_plugin_crashTransmit ( const LOGGER_RECORD * record );
+
+static LOGGER_STATUS logger_plugin_crashSend ( const LOGGER_RECORD * record, const LOGGER_OUTPUT * output );
+
+static uint32_t logger_output_crashDrain ( void );
+
+static void logger_async_reportDropped ( uint32_t dropped, const LOGGER_OUTPUT * output );
+
 static LOGGER_TEMPLATE_INIT f_pluginInitArray[] =
 {
     logger_stdout_initialize,
@@ -43,11 +157,19 @@ static LOGGER_TEMPLATE_TERM f_pluginTermArray[] =
 };
 
 
-static LOGGER_TEMPLATE_SEND f_pluginSendArray[] =
+static LOGGER_TEMPLATE_SENDV f_pluginSendArray[] =
 {
-    logger_stdout_transmit,
-    logger_file_transmit,
-    logger_udp_transmit
+    logger_stdout_transmitv,
+    logger_file_transmitv,
+    logger_udp_transmitv
+};
+
+
+static LOGGER_TEMPLATE_CRASHV f_pluginCrashArray[] =
+{
+    logger_stdout_crashv,
+    logger_file_crashv,
+    logger_udp_crashv
 };
 
 
@@ -60,12 +182,578 @@ static LOGGER_TEMPLATE_NAME f_pluginNameArray[] =
 
 #define OUTPUT_LOCATION_COUNT 3U
 
-static uint32_t f_pluginIndex = 0U; /* default */
+/* every output started from the ini, in section order. Index is also the metrics output index */
+#define LOGGER_OUTPUTS_MAX LOGGER_STATS_OUTPUTS_MAX
+
+static LOGGER_OUTPUT f_outputs[LOGGER_OUTPUTS_MAX];
+static uint32_t f_outputCount = 0U;
+
+/* bit n of an output set is f_outputs[n] */
+#define LOGGER_OUTPUT_BIT(output) ( 1U << (uint32_t)( (output) - f_outputs ) )
+
+/* outputs wanted by each level, indexed by the level's bit. Built at startup from every output's levels= */
+static uint32_t f_routes[LOGGER_STATS_LEVELS];
+
+/* outputs without a name=, where records of a handle bound to none go */
+static uint32_t f_unboundOutputs = 0U;
 
 
+/* idle poll interval of a worker with nothing to do */
+#define LOGGER_ASYNC_IDLE_SLEEP_NS (1000000L)
+
+/* outputs are sent from their queues */
+static bool f_asyncEnabled = false;
+
+/* formats binary captures & expires held repeat counts, only run while outputs are queued. Never destroyed, a
+   producer may still wake it while it stops */
+static LOGGER_WORKER f_writer = { .wakeMutex = PTHREAD_MUTEX_INITIALIZER, .wakeCond = PTHREAD_COND_INITIALIZER };
+
+
+static bool logger_worker_start ( LOGGER_WORKER * worker, void * (*threadMain)(void *), void * arg )
+{
+    __atomic_store_n(&worker->running, true, __ATOMIC_RELEASE);
+    
+    if ( pthread_create(&worker->thread, NULL, threadMain, arg) != 0 )
+    {
+        __atomic_store_n(&worker->running, false, __ATOMIC_RELEASE);
+        return false;
+    }
+    
+    return true;
+}
+
+/* the thread finishes its work before it exits */
+static void logger_worker_stop ( LOGGER_WORKER * worker )
+{
+    __atomic_store_n(&worker->running, false, __ATOMIC_RELEASE);
+    
+    logger_worker_wake(worker);
+    
+    pthread_join(worker->thread, NULL);
+}
+
+static bool logger_worker_isRunning ( LOGGER_WORKER * worker )
+{
+    return __atomic_load_n(&worker->running, __ATOMIC_ACQUIRE);
+}
+
+static void logger_worker_wait ( LOGGER_WORKER * worker )
+{
+    struct timespec wakeAt;
+    
+    clock_gettime(CLOCK_REALTIME, &wakeAt);
+    
+    wakeAt.tv_nsec += LOGGER_ASYNC_IDLE_SLEEP_NS;
+    
+    if ( wakeAt.tv_nsec >= 1000000000L )
+    {
+        wakeAt.tv_sec += 1;
+        wakeAt.tv_nsec -= 1000000000L;
+    }
+    
+    /* producers only signal when they find a queue full */
+    pthread_mutex_lock(&worker->wakeMutex);
+    pthread_cond_timedwait(&worker->wakeCond, &worker->wakeMutex, &wakeAt);
+    pthread_mutex_unlock(&worker->wakeMutex);
+}
+
+static void logger_worker_wake ( LOGGER_WORKER * worker )
+{
+    pthread_mutex_lock(&worker->wakeMutex);
+    pthread_cond_signal(&worker->wakeCond);
+    pthread_mutex_unlock(&worker->wakeMutex);
+}
+
+static bool logger_queue_start ( LOGGER_QUEUE * queue, uint32_t slotCount, void * (*threadMain)(void *), void * arg )
+{
+    if ( logger_ring_create(&queue->ring, slotCount) == false )
+    {
+        return false;
+    }
+    
+    queue->dropped = 0U;
+    
+    pthread_mutex_init(&queue->worker.wakeMutex, NULL);
+    pthread_cond_init(&queue->worker.wakeCond, NULL);
+    
+    if ( logger_worker_start(&queue->worker, threadMain, arg) == false )
+    {
+        pthread_cond_destroy(&queue->worker.wakeCond);
+        pthread_mutex_destroy(&queue->worker.wakeMutex);
+        logger_ring_destroy(&queue->ring);
+        return false;
+    }
+    
+    return true;
+}
+
+/* the thread drains what is left before it exits */
+static void logger_queue_stop ( LOGGER_QUEUE * queue )
+{
+    logger_worker_stop(&queue->worker);
+    
+    pthread_cond_destroy(&queue->worker.wakeCond);
+    pthread_mutex_destroy(&queue->worker.wakeMutex);
+    
+    logger_ring_destroy(&queue->ring);
+}
+
+/* false when the queue's thread has stopped, the caller then delivers the record itself */
+static bool logger_queue_push ( LOGGER_QUEUE * queue, const LOGGER_RECORD * record )
+{
+    LOGGER_BACKPRESSURE policy = queue->policy;
+    bool keep = ( ( record->level & LOGGER_BACKPRESSURE_KEEP ) != 0U );
+    
+    if ( ( policy == LOGGER_BACKPRESSURE_DROP_LEVEL ) && ( keep == false ) &&
+         logger_backpressure_shed(record->level, logger_ring_used(&queue->ring), logger_ring_capacity(&queue->ring)) )
+    {
+        logger_queue_drop(queue);
+        return true;
+    }
+    
+    while ( logger_ring_push(&queue->ring, record) == false )
+    {
+        if ( logger_worker_isRunning(&queue->worker) == false )
+        {
+            /* thread has gone, deliver directly rather than lose the record */
+            return false;
+        }
+        
+        if ( policy == LOGGER_BACKPRESSURE_DROP_OLDEST )
+        {
+            /* make room, unless the oldest is itself a record that must be kept */
+            if ( logger_ring_evict(&queue->ring, LOGGER_BACKPRESSURE_KEEP) )
+            {
+                logger_queue_drop(queue);
+                continue;
+            }
+        }
+        else if ( ( policy != LOGGER_BACKPRESSURE_BLOCK ) && ( keep == false ) )
+        {
+            logger_queue_drop(queue);
+            return true;
+        }
+        
+        /* ring full - let the thread catch up */
+        logger_worker_wake(&queue->worker);
+        sched_yield();
+    }
+    
+    return true;
+}
+
+static void logger_queue_drop ( LOGGER_QUEUE * queue )
+{
+    __atomic_add_fetch(&queue->dropped, 1U, __ATOMIC_RELAXED);
+    
+    logger_metrics_dropped();
+}
+
+static uint32_t logger_queue_takeDropped ( LOGGER_QUEUE * queue )
+{
+    /* checked on every pass of the thread, only exchanged when there is something to take */
+    if ( __atomic_load_n(&queue->dropped, __ATOMIC_RELAXED) == 0U )
+    {
+        return 0U;
+    }
+    
+    return __atomic_exchange_n(&queue->dropped, 0U, __ATOMIC_RELAXED);
+}
+
+
+/* format captured records onto the output queues. Returns number of records sent */
+static uint32_t logger_async_drain ( void )
+{
+    /* records captured in binary form are formatted here, off the callers thread */
+    uint32_t sentCount = logger_binary_drain(logger_output_dispatch);
+    
+    /* runs held past the timeout are reported even if their thread has gone quiet */
+    logger_dedup_expireThreads(logger_output_dispatch);
+    
+    /* an output without a queue of its own has its capture drops reported here */
+    for ( uint32_t i=0U; i<f_outputCount; i++ )
+    {
+        if ( f_outputs[i].queued == false )
+        {
+            logger_async_reportDropped(logger_queue_takeDropped(&f_outputs[i].queue), &f_outputs[i]);
+        }
+    }
+    
+    return sentCount;
+}
+
+/* straight to the output that dropped them, a note pushed to its queue could be dropped too */
+static void logger_async_reportDropped ( uint32_t dropped, const LOGGER_OUTPUT * output )
+{
+    if ( dropped != 0U )
+    {
+        char text[LOGGER_MAX_LOGGER_CHARS];
+        LOGGER_RECORD_BUILDER builder;
+        LOGGER_RECORD record;
+        
+        logger_record_begin(&builder, text, sizeof(text));
+        logger_record_appendHeader(&builder, __FILE__, __LINE__, __FUNCTION__, LOGGER_LEVEL_WARN);
+        logger_record_appendFormat(&builder, LOGGER_MESSAGE_SIZE-1U, "%u records dropped", dropped);
+        
+        record.ticks = logger_clock_now();
+        record.level = LOGGER_LEVEL_WARN;
+        record.header = NULL;
+        record.headerLen = 0U;
+        record.messageLen = logger_record_end(&builder);
+        record.message = builder.buffer;
+        record.fields = NULL;
+        record.fieldsLen = 0U;
+        record.outputs = 0U;
+        
+        (void)logger_plugin_transmit(&record, LOGGER_OUTPUT_BIT(output));
+    }
+}
+
+static void * logger_async_writerMain ( void * arg )
+{
+    (void)arg;
+    
+    while ( logger_worker_isRunning(&f_writer) )
+    {
+        if ( logger_async_drain() == 0U )
+        {
+            logger_worker_wait(&f_writer);
+        }
+    }
+    
+    /* pick up anything pushed before the stop request */
+    (void)logger_async_drain();
+    
+    logger_binary_flushRepeats(logger_output_dispatch);
+    
+    return NULL;
+}
+
+/* send every record queued for one output. Returns number of records sent */
+static uint32_t logger_output_drain ( LOGGER_OUTPUT * output )
+{
+    uint32_t sentCount = 0U;
+    LOGGER_RING_SLOT *slot = NULL;
+    
+    while ( ( slot = logger_ring_peek(&output->queue.ring) ) != NULL )
+    {
+        const char * message = logger_ring_message(slot);
+        LOGGER_RECORD record = { slot->ticks, slot->level, slot->header, slot->headerLen, message, slot->msgLen,
+                                 (const uint8_t *)&message[slot->msgLen], slot->fieldsLen, slot->outputs };
+        
+        (void)logger_plugin_transmit(&record, LOGGER_OUTPUT_BIT(output));
+        
+        logger_ring_release(&output->queue.ring, slot);
+        
+        sentCount += 1U;
+    }
+    
+    logger_async_reportDropped(logger_queue_takeDropped(&output->queue), output);
+    
+    return sentCount;
+}
+
+static void * logger_output_senderMain ( void * arg )
+{
+    LOGGER_OUTPUT * output = (LOGGER_OUTPUT *)arg;
+    
+    while ( logger_worker_isRunning(&output->queue.worker) )
+    {
+        if ( logger_output_drain(output) == 0U )
+        {
+            logger_worker_wait(&output->queue.worker);
+        }
+    }
+    
+    (void)logger_output_drain(output);
+    
+    return NULL;
+}
+
+/* to the outputs routed its level. Queued outputs get a copy of the finished record, the rest share one rendering */
+static LOGGER_STATUS logger_output_dispatch ( const LOGGER_RECORD * record )
+{
+    uint32_t targets = 0U;
+    
+    for ( uint32_t pending = logger_output_route(record->level, record->outputs); pending != 0U; pending &= pending-1U )
+    {
+        LOGGER_OUTPUT * output = &f_outputs[__builtin_ctz(pending)];
+        
+        /* sent by this thread when its queue has stopped */
+        if ( ( output->queued == false ) || ( logger_queue_push(&output->queue, record) == false ) )
+        {
+            targets |= LOGGER_OUTPUT_BIT(output);
+        }
+    }
+    
+    return ( targets != 0U ) ? logger_plugin_transmit(record, targets) : LOGGER_STATUS_OK;
+}
+
+/* one table lookup, a record without a single level bit goes to every output. Narrowed to the outputs the
+   printing handle is bound to, or those bound to no handle */
+static uint32_t logger_output_route ( LOGGER_LEVEL level, uint32_t outputs )
+{
+    uint32_t index = ( level != 0U ) ? (uint32_t)__builtin_ctz((unsigned int)level) : LOGGER_STATS_LEVELS;
+    uint32_t routed = ( index < LOGGER_STATS_LEVELS ) ? f_routes[index] : ( 1U << f_outputCount ) - 1U;
+    
+    return routed & ( ( outputs != 0U ) ? outputs : f_unboundOutputs );
+}
+
+static void logger_output_buildRoutes ( void )
+{
+    f_unboundOutputs = 0U;
+    
+    for ( uint32_t i=0U; i<f_outputCount; i++ )
+    {
+        f_unboundOutputs |= ( f_outputs[i].bound == false ) ? 1U << i : 0U;
+    }
+    
+    for ( uint32_t index=0U; index<LOGGER_STATS_LEVELS; index++ )
+    {
+        f_routes[index] = 0U;
+        
+        for ( uint32_t i=0U; i<f_outputCount; i++ )
+        {
+            if ( ( f_outputs[i].levels & ( 1U << index ) ) != 0U )
+            {
+                f_routes[index] |= 1U << i;
+            }
+        }
+    }
+}
+
+/* to each output in targets. The plugins gather the record from its pieces, none of them are joined here & they
+   are rendered once however many outputs are sent them */
+static LOGGER_STATUS logger_plugin_transmit ( const LOGGER_RECORD * record, uint32_t targets )
+{
+    LOGGER_STATUS status = LOGGER_STATUS_OK;
+    char fraction[LOGGER_TIMESTAMP_FRACTION_SIZE];
+    struct iovec segments[LOGGER_RECORD_SEGMENTS_MAX];
+    char renderedFields[LOGGER_RECORD_INLINE_SIZE];
+    LOGGER_RECORD_BUILDER builder;
+    
+    int segmentCount = logger_record_segments(record, fraction, segments);
+    bool rendered = false;
+    LOGGER_FIELDS_FORMAT renderedFormat = LOGGER_FIELDS_FORMAT_TEXT;
+    
+    for ( ; targets != 0U; targets &= targets-1U )
+    {
+        const LOGGER_OUTPUT * output = &f_outputs[__builtin_ctz(targets)];
+        int outputCount = segmentCount;
+        
+        if ( record->fieldsLen != 0U )
+        {
+            /* fields are rendered only now, in the form each output wants. Kept for the next output of that form */
+            if ( rendered && ( renderedFormat != output->fields ) )
+            {
+                logger_record_release(&builder);
+                rendered = false;
+            }
+            
+            if ( rendered == false )
+            {
+                logger_record_beginSpill(&builder, renderedFields, sizeof(renderedFields));
+                logger_fields_render(&builder, record->fields, record->fieldsLen, output->fields);
+                
+                segments[segmentCount].iov_base = builder.buffer;
+                segments[segmentCount].iov_len = logger_record_end(&builder);
+                
+                rendered = true;
+                renderedFormat = output->fields;
+            }
+            
+            outputCount += 1;
+        }
+        
+        LOGGER_STATUS sent = logger_plugin_sendv(output, segments, outputCount);
+        
+        status = ( status == LOGGER_STATUS_OK ) ? sent : status;
+    }
+    
+    if ( rendered )
+    {
+        logger_record_release(&builder);
+    }
+    
+    return status;
+}
+
+/* every send to a plugin goes through here to be counted */
+static LOGGER_STATUS logger_plugin_sendv ( const LOGGER_OUTPUT * output, const struct iovec * segments, int segmentCount )
+{
+    size_t bytes = 0U;
+    
+    for ( int i=0; i<segmentCount; i++ )
+    {
+        bytes += segments[i].iov_len;
+    }
+    
+    LOGGER_STATUS status = (*f_pluginSendArray[output->plugin])(output->instance, segments, segmentCount);
+    
+    logger_metrics_output((uint32_t)(output - f_outputs), bytes, ( status != LOGGER_STATUS_OK ));
+    
+    return status;
+}
+
+/* signal handler only, to the outputs routed its level that asked for crash_flush= */
+static LOGGER_STATUS logger_plugin_crashTransmit ( const LOGGER_RECORD * record )
+{
+    LOGGER_STATUS status = LOGGER_STATUS_OK;
+    
+    for ( uint32_t pending = logger_output_route(record->level, record->outputs); pending != 0U; pending &= pending-1U )
+    {
+        const LOGGER_OUTPUT * output = &f_outputs[__builtin_ctz(pending)];
+        
+        if ( output->crashFlush )
+        {
+            LOGGER_STATUS sent = logger_plugin_crashSend(record, output);
+            
+            status = ( status == LOGGER_STATUS_OK ) ? sent : status;
+        }
+    }
+    
+    return status;
+}
+
+/* signal handler only, timestamps are worked out without localtime & fields are left off */
+static LOGGER_STATUS logger_plugin_crashSend ( const LOGGER_RECORD * record, const LOGGER_OUTPUT * output )
+{
+    char timestamp[LOGGER_TIMESTAMP_SIZE];
+    struct iovec segments[LOGGER_RECORD_SEGMENTS_MAX];
+    
+    int segmentCount = logger_record_segmentsSafe(record, timestamp, segments);
+    
+    return (*f_pluginCrashArray[output->plugin])(output->instance, segments, segmentCount);
+}
+
+/* keys of the [output=...] sections that set up the whole logger, so are only read from the first one */
+static char * const f_globalKeys[] =
+{
+    "clock", "precision", "binary", "dedup", "dedup_timeout", "recorder", "ini_watch", "latency"
+};
+
+/* the keys of one [output=...] section that set up that output alone */
+static void logger_output_configureFromIni ( LOGGER_OUTPUT * output, LOGGER_INI_SECTIONHANDLE paramBag )
+{
+    char *levelsStr = NULL;
+    size_t levelsStrLen = 0U;
+    char *asyncStr = NULL;
+    size_t asyncStrLen = 0U;
+    char *queueStr = NULL;
+    size_t queueStrLen = 0U;
+    
+    logger_ini_sectionRetrieveValueFromKey(paramBag, "levels", strlen("levels"), &levelsStr, &levelsStrLen);
+    logger_ini_sectionRetrieveValueFromKey(paramBag, "async", strlen("async"), &asyncStr, &asyncStrLen);
+    logger_ini_sectionRetrieveValueFromKey(paramBag, "queue", strlen("queue"), &queueStr, &queueStrLen);
+    
+    output->levels = ( levelsStr != NULL ) ? loggerFlags_level_stringToFlags(levelsStr, levelsStrLen) : LOGGER_LEVEL_ALL;
+    output->fields = logger_fields_formatFromIni(paramBag);
+    output->crashFlush = logger_crash_isWantedFromIni(paramBag);
+    output->async = logger_string_isTrue(asyncStr, asyncStrLen);
+    output->queueSlots = ( ( queueStr != NULL ) && ( atoi(queueStr) > 0 ) ) ? (uint32_t)atoi(queueStr) : LOGGER_RING_DEFAULT_SLOTS;
+    output->queue.policy = logger_backpressure_fromIni(paramBag);
+    output->queue.dropped = 0U;
+    output->queued = false;
+}
+
+static void logger_output_warnGlobalKeys ( LOGGER_INI_SECTIONHANDLE paramBag, const char * outputName )
+{
+    /* only read by the diagnostic print */
+    (void)outputName;
+    
+    for ( uint32_t i=0U; i<sizeof(f_globalKeys)/sizeof(f_globalKeys[0]); i++ )
+    {
+        char *value = NULL;
+        size_t valueLen = 0U;
+        
+        logger_ini_sectionRetrieveValueFromKey(paramBag, f_globalKeys[i], strlen(f_globalKeys[i]), &value, &valueLen);
+        
+        if ( value != NULL )
+        {
+            LOGPRINT_LOG_W("%s= of output=%s ignored, only the first output section sets it",f_globalKeys[i],outputName);
+        }
+    }
+}
+
+/* with more than one output each is sent from its own queue, so a slow output holds up no other. A single output
+   is queued with async= or binary capture. The writer runs alongside when there are captures to format or
+   repeats to expire */
+static void logger_async_start ( bool binaryCapture )
+{
+    bool queued = false;
+    
+    for ( uint32_t i=0U; i<f_outputCount; i++ )
+    {
+        LOGGER_OUTPUT * output = &f_outputs[i];
+        
+        if ( ( f_outputCount == 1U ) && ( output->async == false ) && ( binaryCapture == false ) )
+        {
+            continue;
+        }
+        
+        if ( logger_queue_start(&output->queue, output->queueSlots, logger_output_senderMain, output) )
+        {
+            output->queued = true;
+            queued = true;
+        }
+        else
+        {
+            LOGPRINT_LOG_E("Failed to start queue for output %s, sent inline",output->name);
+        }
+    }
+    
+    __atomic_store_n(&f_asyncEnabled, queued, __ATOMIC_RELEASE);
+    
+    if ( ( queued ) && ( binaryCapture || logger_dedup_isEnabled() ) )
+    {
+        if ( logger_worker_start(&f_writer, logger_async_writerMain, NULL) )
+        {
+            logger_binary_setEnabled(binaryCapture);
+        }
+        else
+        {
+            LOGPRINT_LOG_E("Failed to start writer thread, formatting inline");
+        }
+    }
+    
+    LOGPRINT_LOG_I("async output enabled. queued:%d binary:%d outputs:%u",queued,logger_binary_isEnabled(),f_outputCount);
+}
+
+static void logger_async_stop ( void )
+{
+    if ( logger_worker_isRunning(&f_writer) )
+    {
+        /* callers go back to formatting inline, the writer drains what was captured */
+        logger_binary_setEnabled(false);
+        
+        logger_worker_stop(&f_writer);
+    }
+    
+    /* after the writer, which may still be filling them */
+    for ( uint32_t i=0U; i<f_outputCount; i++ )
+    {
+        LOGGER_OUTPUT * output = &f_outputs[i];
+        
+        if ( output->queued )
+        {
+            logger_queue_stop(&output->queue);
+            
+            output->queued = false;
+        }
+    }
+    
+    __atomic_store_n(&f_asyncEnabled, false, __ATOMIC_RELEASE);
+}
+
 static LOGGER_STATUS logger_startup ( void )
 {
     LOGGER_STATUS status = LOGGER_STATUS_UNDEF;
+    LOGGER_INI_SECTIONHANDLE firstSection = NULL;
+    bool watchIni = false;
+    bool crashFlush = false;
+
+    /* a reload cannot free the sections while the plugins read them */
+    logger_ini_readBegin();
 
     for ( uint32_t i=0U; i<logger_ini_numberOfSections(); i++ )
     {
@@ -76,26 +764,114 @@ static LOGGER_STATUS logger_startup ( void )
         
         logger_ini_sectionHandleByIndex(&handle, i, &sectionname, &sectionlen);
         
-        if ( strncmp(sectionname, "output=", strlen("output=")) == 0 )
+        if ( strncmp(sectionname, "output=", strlen("output=")) != 0 )
         {
-            char *outputName = &sectionname[strlen("output")+1U];
+            continue;
+        }
+        
+        char *outputName = &sectionname[strlen("output")+1U];
+        uint32_t plugin = OUTPUT_LOCATION_COUNT;
+        char *nameStr = NULL;
+        size_t nameStrLen = 0U;
+        
+        logger_ini_sectionRetrieveValueFromKey(handle, "name", strlen("name"), &nameStr, &nameStrLen);
 
-            for ( uint32_t y=0U; y<OUTPUT_LOCATION_COUNT; y++ )
+        for ( uint32_t y=0U; y<OUTPUT_LOCATION_COUNT; y++ )
+        {
+            if ( strncmp((*f_pluginNameArray[y])(), outputName, strlen(outputName)) == 0 )
             {
-                if ( strncmp((*f_pluginNameArray[y])(), outputName, strlen(outputName)) == 0 )
-                {
-                    f_pluginIndex = y;
-                    break;
-                }
+                plugin = y;
+                break;
             }
+        }
+        
+        if ( plugin == OUTPUT_LOCATION_COUNT )
+        {
+            LOGPRINT_LOG_E("Unknown output=%s, skipped",outputName);
+            continue;
+        }
+        
+        if ( ( f_outputCount == LOGGER_OUTPUTS_MAX ) ||
+             ( ( nameStr != NULL ) && ( ( nameStrLen == 0U ) || ( nameStrLen >= LOGGER_OUTPUT_NAME_SIZE ) ||
+                                      ( logger_output_find(nameStr, nameStrLen) != 0U ) ) ) )
+        {
+            /* a handle is bound by name, two outputs of one name could not be told apart */
+            LOGPRINT_LOG_E("output=%s has a bad or repeated name, or too many outputs, skipped",outputName);
+            continue;
+        }
+        
+        if ( firstSection == NULL )
+        {
+            /* settings shared by every output come from the first section */
             
-            LOGPRINT_ASSERT(f_pluginInitArray[f_pluginIndex]!=NULL);
+            /* before any record is captured, ticks are meaningless across a clock change */
+            logger_clock_configureFromIni(handle);
             
-            status = (*f_pluginInitArray[f_pluginIndex])(handle);
+            logger_dedup_startFromIni(handle);
             
+            logger_binary_recorderFromIni(handle);
             
-            break;
+            logger_metrics_configureFromIni(handle);
+        }
+        else
+        {
+            logger_output_warnGlobalKeys(handle, outputName);
+        }
+        
+        LOGGER_OUTPUT * output = &f_outputs[f_outputCount];
+        
+        if ( (*f_pluginInitArray[plugin])(handle, &output->instance) != LOGGER_STATUS_OK )
+        {
+            LOGPRINT_LOG_E("Failed to start output=%s",outputName);
+            continue;
         }
+        
+        /* copied, the section goes away on the next reload */
+        snprintf(output->name, sizeof(output->name), "%.*s", ( nameStr != NULL ) ? (int)nameStrLen : (int)strlen(outputName),
+                 ( nameStr != NULL ) ? nameStr : outputName);
+        
+        output->plugin = plugin;
+        output->bound = ( nameStr != NULL );
+        
+        logger_output_configureFromIni(output, handle);
+        
+        crashFlush = crashFlush || output->crashFlush;
+        
+        logger_metrics_nameOutput(f_outputCount, output->name);
+        
+        f_outputCount += 1U;
+        
+        firstSection = ( firstSection != NULL ) ? firstSection : handle;
+    }
+    
+    /* before any record is dispatched */
+    logger_output_buildRoutes();
+    
+    if ( f_outputCount != 0U )
+    {
+        char *binaryStr = NULL;
+        size_t binaryStrLen = 0U;
+        
+        logger_ini_sectionRetrieveValueFromKey(firstSection, "binary", strlen("binary"), &binaryStr, &binaryStrLen);
+        
+        logger_async_start(logger_string_isTrue(binaryStr, binaryStrLen));
+        
+        if ( crashFlush )
+        {
+            logger_crash_start();
+        }
+        
+        watchIni = logger_iniWatch_isWantedFromIni(firstSection);
+        
+        status = LOGGER_STATUS_OK;
+    }
+
+    logger_ini_readEnd();
+
+    /* once the sections are released, it reads the ini path under the lock a reload holds while it waits for them */
+    if ( watchIni )
+    {
+        logger_iniWatch_start();
     }
 
     return status;
@@ -103,11 +879,37 @@ static LOGGER_STATUS logger_startup ( void )
 
 static LOGGER_STATUS logger_shutdown ( void )
 {
-    LOGGER_STATUS status = LOGGER_STATUS_UNDEF;
+    LOGGER_STATUS status = LOGGER_STATUS_OK;
+    
+    /* no reload once shutdown has begun */
+    logger_iniWatch_stop();
     
-    LOGPRINT_ASSERT(f_pluginTermArray[f_pluginIndex]!=NULL);
+    /* the queue & the plugin are about to go away under the handler */
+    logger_crash_stop();
+    
+    /* counts held by this thread go out while the output is still there */
+    logger_dedup_flushThread();
+    
+    /* flush queued records before the plugins go away */
+    logger_async_stop();
+    
+    logger_dedup_configure(false, 0U);
+    
+    /* recorded records stay dumpable, the next startup reads recorder= again */
+    logger_binary_setRecorderSize(0U);
 
-    status = (*f_pluginTermArray[f_pluginIndex])();
+    for ( uint32_t i=0U; i<f_outputCount; i++ )
+    {
+        LOGGER_STATUS stopped = (*f_pluginTermArray[f_outputs[i].plugin])(f_outputs[i].instance);
+        
+        f_outputs[i].instance = NULL;
+        
+        status = ( status == LOGGER_STATUS_OK ) ? stopped : status;
+    }
+    
+    f_outputCount = 0U;
+    
+    logger_output_buildRoutes();
     
     return status;
 }
@@ -174,12 +976,127 @@ bool logger_term ( void )
     return success;
 }
 
+uint32_t logger_output_find ( const char * name, size_t nameLen )
+{
+    for ( uint32_t i=0U; i<f_outputCount; i++ )
+    {
+        if ( f_outputs[i].bound && ( strlen(f_outputs[i].name) == nameLen ) && ( strncmp(f_outputs[i].name, name, nameLen) == 0 ) )
+        {
+            return 1U << i;
+        }
+    }
+    
+    return 0U;
+}
+
+LOGGER_BACKPRESSURE logger_output_capturePolicy ( LOGGER_LEVEL level, uint32_t outputs )
+{
+    uint32_t pending = logger_output_route(level, outputs);
+    LOGGER_BACKPRESSURE policy = ( pending != 0U ) ? LOGGER_BACKPRESSURE_DROP_LEVEL : LOGGER_BACKPRESSURE_BLOCK;
+    
+    for ( ; ( pending != 0U ) && ( policy != LOGGER_BACKPRESSURE_BLOCK ); pending &= pending-1U )
+    {
+        LOGGER_BACKPRESSURE outputPolicy = f_outputs[__builtin_ctz(pending)].queue.policy;
+        
+        if ( outputPolicy != LOGGER_BACKPRESSURE_DROP_LEVEL )
+        {
+            policy = ( outputPolicy == LOGGER_BACKPRESSURE_BLOCK ) ? LOGGER_BACKPRESSURE_BLOCK : LOGGER_BACKPRESSURE_DROP_NEWEST;
+        }
+    }
+    
+    return policy;
+}
+
+void logger_output_dropped ( LOGGER_LEVEL level, uint32_t outputs )
+{
+    for ( uint32_t pending = logger_output_route(level, outputs); pending != 0U; pending &= pending-1U )
+    {
+        __atomic_add_fetch(&f_outputs[__builtin_ctz(pending)].queue.dropped, 1U, __ATOMIC_RELAXED);
+    }
+    
+    /* one record, however many outputs missed it */
+    logger_metrics_dropped();
+}
+
 char* logger_currentOutput ( void )
 {
-    return (*f_pluginNameArray[f_pluginIndex])();
+    /* the first output, stdout when none started */
+    return ( f_outputCount != 0U ) ? f_outputs[0].name : (*f_pluginNameArray[0])();
+}
+
+void logger_async_wakeWriter ( void )
+{
+    logger_worker_wake(&f_writer);
 }
 
-LOGGER_TEMPLATE_SEND logger_getPrintHandler ( void )
+LOGGER_STATUS logger_sendRecord ( const LOGGER_RECORD * record )
 {
-    return f_pluginSendArray[f_pluginIndex];
+    LOGGER_STATUS status = LOGGER_STATUS_UNDEF;
+    
+    if ( logger_output_route(record->level, record->outputs) == 0U )
+    {
+        /* no output takes this level, not worth a place in the queue */
+        status = LOGGER_STATUS_OK;
+    }
+    else
+    {
+        /* onto the queue of each output sent from one, inline to the others */
+        status = logger_output_dispatch(record);
+    }
+    
+    return status;
+}
+
+bool logger_async_isEnabled ( void )
+{
+    /* pairs with the release in start, the output queues are set up before it reads true */
+    return __atomic_load_n(&f_asyncEnabled, __ATOMIC_ACQUIRE);
+}
+
+/* signal handler only, claimed like the senders do, so neither sends a record twice. The one a sender holds is its
+   own to finish */
+static uint32_t logger_output_crashDrain ( void )
+{
+    uint32_t sentCount = 0U;
+    LOGGER_RING_SLOT *slot = NULL;
+    
+    for ( uint32_t i=0U; i<f_outputCount; i++ )
+    {
+        while ( f_outputs[i].crashFlush && f_outputs[i].queued &&
+                ( ( slot = logger_ring_peek(&f_outputs[i].queue.ring) ) != NULL ) )
+        {
+            LOGGER_RECORD record = { slot->ticks, slot->level, slot->header, slot->headerLen, logger_ring_message(slot),
+                                     slot->msgLen, NULL, 0U, slot->outputs };
+            
+            (void)logger_plugin_crashSend(&record, &f_outputs[i]);
+            
+            logger_ring_abandon(&f_outputs[i].queue.ring, slot);
+            
+            sentCount += 1U;
+        }
+    }
+    
+    return sentCount;
+}
+
+uint32_t logger_crashFlush ( void )
+{
+    /* an output's own queue holds older records than the captures, so goes first. Again after, for the capture
+       the writer was moving onto the queues as the handler began */
+    uint32_t sentCount = logger_output_crashDrain();
+    
+    sentCount += logger_binary_crashDrain(logger_plugin_crashTransmit);
+    
+    sentCount += logger_output_crashDrain();
+    
+    /* no record, outputs write out what they still hold */
+    for ( uint32_t i=0U; i<f_outputCount; i++ )
+    {
+        if ( f_outputs[i].crashFlush )
+        {
+            (void)(*f_pluginCrashArray[f_outputs[i].plugin])(f_outputs[i].instance, NULL, 0);
+        }
+    }
+    
+    return sentCount;
 }
@@ -23,6 +23,9 @@ extern "C" {
 #include "logger.h"
 #include "logger_template.h"
 #include "logger_common.h"
+#include "logger_clock.h"
+#include "logger_backpressure.h"
+#include "logger_messageAssemble.h"
 
 
 /**
@@ -43,6 +46,16 @@ bool logger_init ( void );
 bool logger_term ( void );
 
 
+/**
+ @brief look up a started output by the name= of its section
+ @details the set of outputs only changes when the last handle terminates, so the result can be kept by a handle
+ @param[in] name output name, need not be terminated
+ @param[in] nameLen chars in name
+ @return the output's bit for #LOGGER_RECORD outputs, 0 when no output has that name
+ */
+uint32_t logger_output_find ( const char * name, size_t nameLen );
+
+
 /**
  @brief get the current location of logger output
  @return !NULL on success
@@ -51,10 +64,57 @@ char* logger_currentOutput ( void );
 
 
 /**
- @brief get the current function handler for printing messages
- @return !NULL on success
+ @brief hand a record to the outputs routed its level
+ @details onto the queue of each output that has one, sent inline to the others. The timestamp is rendered just
+ before the plugin send, on the output's sender thread when it is queued
+ @param[in] record finished record. Only the message is copied when it has to be queued
+ @return #LOGGER_STATUS_OK on success
+ */
+LOGGER_STATUS logger_sendRecord ( const LOGGER_RECORD * record );
+
+
+/**
+ @brief wake the writer thread early
+ @details for producers that found the binary capture full, the writer otherwise polls every millisecond
+ */
+void logger_async_wakeWriter ( void );
+
+
+/**
+ @brief whether records reach the outputs from their sender threads rather than the logging thread
+ @return true while the outputs are queued: with more than one output, async= or binary=
+ */
+bool logger_async_isEnabled ( void );
+
+
+/**
+ @brief backpressure= policy for a binary capture, shared by every output a record goes to
+ @details the least dropping of the policies of the outputs routed the record: block, then drop_newest or
+ drop_oldest (both drop the newest from a capture buffer), then drop_level
+ @param[in] level level of the record
+ @param[in] outputs named outputs of the record's handle, 0 for the unnamed ones
+ @return policy for a full capture buffer
+ */
+LOGGER_BACKPRESSURE logger_output_capturePolicy ( LOGGER_LEVEL level, uint32_t outputs );
+
+
+/**
+ @brief count a record dropped before it reached the output queues
+ @details each output routed the record reports the drop in its own "N records dropped" note
+ @param[in] level level of the record
+ @param[in] outputs named outputs of the record's handle, 0 for the unnamed ones
+ */
+void logger_output_dropped ( LOGGER_LEVEL level, uint32_t outputs );
+
+
+/**
+ @brief from a signal handler, send every record still queued or captured, then the flight recorder, to the
+ outputs with crash_flush=
+ @details async-signal-safe, see #LOGGER_TEMPLATE_CRASHV. Records a sender thread is sending at the same time are
+ left to it. Each of those outputs is then sent no record so it writes out what it buffers
+ @return number of records sent
  */
-LOGGER_TEMPLATE_SEND logger_getPrintHandler ( void );
+uint32_t logger_crashFlush ( void );
 
     
 #ifdef __cplusplus
@@ -93,17 +93,17 @@ LOGGER_LEVEL_FLAGS loggerFlags_level_stringToFlags ( char * loggerLevel, size_t
     return flags;
 }
 
-/* convert enum to flag bit form */
+/* convert enum to flag bit form, bits outside the levels would land in the capture mask */
 static LOGGER_LEVEL_FLAGS logger_level_flags ( LOGGER_LEVEL loggerLevel )
 {
-    return (LOGGER_LEVEL_FLAGS)loggerLevel;
+    return (LOGGER_LEVEL_FLAGS)loggerLevel & (LOGGER_LEVEL_FLAGS)LOGGER_LEVEL_ALL;
 }
 
 void logger_level_add ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_LEVEL loggerLevel )
 {
     if ( handlePrv )
     {
-        handlePrv->loggerLevelsEnabled = handlePrv->loggerLevelsEnabled | logger_level_flags(loggerLevel);
+        __atomic_fetch_or(&handlePrv->shared.loggerLevels, logger_level_flags(loggerLevel), __ATOMIC_RELAXED);
     }
 }
 
@@ -111,7 +111,23 @@ void logger_level_remove ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_LEVEL loggerLev
 {
     if ( handlePrv )
     {
-        handlePrv->loggerLevelsEnabled = handlePrv->loggerLevelsEnabled & ~logger_level_flags(loggerLevel);
+        __atomic_fetch_and(&handlePrv->shared.loggerLevels, ~logger_level_flags(loggerLevel), __ATOMIC_RELAXED);
+    }
+}
+
+void logger_level_set ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_LEVEL loggerLevel )
+{
+    if ( handlePrv )
+    {
+        LOGGER_LEVEL_FLAGS enabled = logger_level_flags(loggerLevel);
+        LOGGER_LEVEL_FLAGS levels = __atomic_load_n(&handlePrv->shared.loggerLevels, __ATOMIC_RELAXED);
+        
+        while ( __atomic_compare_exchange_n(&handlePrv->shared.loggerLevels, &levels,
+                                            ( levels & ~(LOGGER_LEVEL_FLAGS)LOGGER_LEVEL_ALL ) | enabled,
+                                            true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) == false )
+        {
+            /* levels reloaded by the failed exchange */
+        }
     }
 }
 
@@ -121,7 +137,7 @@ bool logger_level_isEnabled ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_LEVEL logger
     
     if ( handlePrv )
     {
-        if ( (handlePrv->loggerLevelsEnabled) & logger_level_flags(loggerLevel) )
+        if ( __atomic_load_n(&handlePrv->shared.loggerLevels, __ATOMIC_RELAXED) & logger_level_flags(loggerLevel) )
         {
             loggerEnabled = true;
         }
@@ -129,3 +145,27 @@ bool logger_level_isEnabled ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_LEVEL logger
     
     return loggerEnabled;
 }
+
+void logger_level_setCaptured ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_LEVEL loggerLevel )
+{
+    if ( handlePrv )
+    {
+        LOGGER_LEVEL_FLAGS captured = logger_level_flags(loggerLevel) << LOGGER_LEVELS_CAPTURE_SHIFT;
+        LOGGER_LEVEL_FLAGS levels = __atomic_load_n(&handlePrv->shared.loggerLevels, __ATOMIC_RELAXED);
+        
+        /* the whole capture half is replaced, the emit half kept as it is at the moment of the exchange */
+        while ( __atomic_compare_exchange_n(&handlePrv->shared.loggerLevels, &levels,
+                                            ( levels & (LOGGER_LEVEL_FLAGS)LOGGER_LEVEL_ALL ) | captured,
+                                            true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) == false )
+        {
+            /* levels reloaded by the failed exchange */
+        }
+    }
+}
+
+bool logger_level_isCaptured ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_LEVEL loggerLevel )
+{
+    return ( handlePrv != NULL ) &&
+           ( ( ( __atomic_load_n(&handlePrv->shared.loggerLevels, __ATOMIC_RELAXED) >> LOGGER_LEVELS_CAPTURE_SHIFT ) &
+               logger_level_flags(loggerLevel) ) != 0U );
+}
@@ -63,6 +63,14 @@ void logger_level_add ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_LEVEL loggerLevel
 void logger_level_remove ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_LEVEL loggerLevel );
 
 
+/**
+ @brief replace the levels enabled in handlePrv
+ @param[in] handlePrv handle to logger to be changed
+ @param[in] loggerLevel levels to be enabled, all others are disabled
+ */
+void logger_level_set ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_LEVEL loggerLevel );
+
+
 /**
  @brief test if #LOGGER_LEVEL is enabled in handlePrv
  @param[in] handlePrv handle to logger to be tested
@@ -71,6 +79,23 @@ void logger_level_remove ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_LEVEL loggerLev
  */
 bool logger_level_isEnabled ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_LEVEL loggerLevel );
 
+
+/**
+ @brief replace the levels the flight recorder keeps for handlePrv
+ @param[in] handlePrv handle to logger to be changed
+ @param[in] loggerLevel levels to be captured
+ */
+void logger_level_setCaptured ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_LEVEL loggerLevel );
+
+
+/**
+ @brief test if #LOGGER_LEVEL is captured in handlePrv
+ @param[in] handlePrv handle to logger to be tested
+ @param[in] loggerLevel level to test for
+ @return #true if the flight recorder should keep it
+ */
+bool logger_level_isCaptured ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_LEVEL loggerLevel );
+
     
 #ifdef __cplusplus
 }
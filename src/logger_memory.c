@@ -0,0 +1,423 @@
+/**
+ @file
+ Diagnostics print library - memory allocation
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+/* pthread_once, pthread keys */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <string.h>
+
+#include "logger_memory.h"
+#include "logger_common.h"
+
+
+/* every block handed out is aligned for any type */
+#define LOGGER_MEM_ALIGN (16U)
+
+#define LOGGER_MEM_ROUND(size) ( ( (size) + LOGGER_MEM_ALIGN - 1U ) & ~(size_t)( LOGGER_MEM_ALIGN - 1U ) )
+
+
+/** block of arena memory, the data follows the header */
+typedef struct _LOGGER_MEM_CHUNK
+{
+    struct _LOGGER_MEM_CHUNK * next;    /* chunks after the arena's current one are free, kept for reuse */
+    size_t capacity;                    /* bytes of data */
+    size_t used;
+} LOGGER_MEM_CHUNK;
+
+#define LOGGER_MEM_CHUNK_HEADER LOGGER_MEM_ROUND(sizeof(LOGGER_MEM_CHUNK))
+
+
+/** bump allocator over a list of chunks */
+typedef struct _LOGGER_MEM_ARENA
+{
+    LOGGER_MEM_CHUNK * first;
+    LOGGER_MEM_CHUNK * current;     /* NULL only while first is */
+    size_t reserved;                /* bytes taken from the system for every chunk */
+    size_t * counter;               /* usage counter the arena reports to */
+} LOGGER_MEM_ARENA;
+
+
+/** in front of each heap block so its size is known when it is freed */
+typedef union _LOGGER_MEM_HEAP_HEADER
+{
+    size_t size;
+    long double alignLongDouble;
+    void * alignPointer;
+    uint64_t alignInteger;
+} LOGGER_MEM_HEAP_HEADER;
+
+
+static size_t f_heapBytes = 0U;
+static size_t f_configBytes = 0U;
+static size_t f_scratchBytes = 0U;
+static size_t f_peakBytes = 0U;
+
+static LOGGER_MEM_ARENA f_configArena = { NULL, NULL, 0U, &f_configBytes };
+static pthread_mutex_t f_configMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static LOGGER_THREAD_LOCAL LOGGER_MEM_ARENA f_scratchArena = { NULL, NULL, 0U, &f_scratchBytes };
+
+static pthread_once_t f_scratchKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t f_scratchKey;
+
+
+static void logger_mem_count ( size_t * counter, size_t bytes );
+
+static void logger_mem_uncount ( size_t * counter, size_t bytes );
+
+static char * logger_mem_chunkData ( LOGGER_MEM_CHUNK * chunk );
+
+static LOGGER_MEM_CHUNK * logger_mem_chunkCreate ( LOGGER_MEM_ARENA * arena, size_t size );
+
+static void logger_mem_chunkFreeFrom ( LOGGER_MEM_ARENA * arena, LOGGER_MEM_CHUNK * chunk );
+
+static void * logger_mem_arenaAlloc ( LOGGER_MEM_ARENA * arena, size_t size );
+
+static void logger_mem_arenaRelease ( LOGGER_MEM_ARENA * arena, LOGGER_MEM_CHUNK * chunk, size_t used );
+
+static void logger_mem_threadExit ( void * data );
+
+static void logger_mem_createKey ( void );
+
+
+static void logger_mem_count ( size_t * counter, size_t bytes )
+{
+    __atomic_add_fetch(counter, bytes, __ATOMIC_RELAXED);
+
+    size_t total = __atomic_load_n(&f_heapBytes, __ATOMIC_RELAXED) +
+                   __atomic_load_n(&f_configBytes, __ATOMIC_RELAXED) +
+                   __atomic_load_n(&f_scratchBytes, __ATOMIC_RELAXED);
+    size_t peak = __atomic_load_n(&f_peakBytes, __ATOMIC_RELAXED);
+
+    while ( ( total > peak ) &&
+            ( __atomic_compare_exchange_n(&f_peakBytes, &peak, total, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) == false ) )
+    {
+        /* peak reloaded by the failed exchange */
+    }
+}
+
+static void logger_mem_uncount ( size_t * counter, size_t bytes )
+{
+    __atomic_sub_fetch(counter, bytes, __ATOMIC_RELAXED);
+}
+
+static char * logger_mem_chunkData ( LOGGER_MEM_CHUNK * chunk )
+{
+    return (char *)chunk + LOGGER_MEM_CHUNK_HEADER;
+}
+
+static LOGGER_MEM_CHUNK * logger_mem_chunkCreate ( LOGGER_MEM_ARENA * arena, size_t size )
+{
+    size_t chunkSize = LOGGER_MEM_CHUNK_SIZE;
+
+    /* powers of two, so a thread settles at its largest need after a few chunks */
+    while ( chunkSize - LOGGER_MEM_CHUNK_HEADER < size )
+    {
+        chunkSize *= 2U;
+    }
+
+    LOGGER_MEM_CHUNK * chunk = malloc(chunkSize);
+
+    if ( chunk == NULL )
+    {
+        LOGPRINT_LOG_E("Malloc failure !!!");
+    }
+    else
+    {
+        chunk->next = NULL;
+        chunk->capacity = chunkSize - LOGGER_MEM_CHUNK_HEADER;
+        chunk->used = 0U;
+
+        arena->reserved += chunkSize;
+        logger_mem_count(arena->counter, chunkSize);
+    }
+
+    return chunk;
+}
+
+/* free chunk & every chunk after it, the caller unlinks them */
+static void logger_mem_chunkFreeFrom ( LOGGER_MEM_ARENA * arena, LOGGER_MEM_CHUNK * chunk )
+{
+    while ( chunk != NULL )
+    {
+        LOGGER_MEM_CHUNK * next = chunk->next;
+        size_t chunkSize = chunk->capacity + LOGGER_MEM_CHUNK_HEADER;
+
+        arena->reserved -= chunkSize;
+        logger_mem_uncount(arena->counter, chunkSize);
+
+        free(chunk);
+        chunk = next;
+    }
+}
+
+static void * logger_mem_arenaAlloc ( LOGGER_MEM_ARENA * arena, size_t size )
+{
+    LOGGER_MEM_CHUNK * chunk = arena->current;
+
+    size = LOGGER_MEM_ROUND(size);
+
+    if ( ( chunk != NULL ) && ( chunk->capacity - chunk->used >= size ) )
+    {
+        void * block = logger_mem_chunkData(chunk) + chunk->used;
+
+        chunk->used += size;
+
+        return block;
+    }
+
+    /* move on to the next chunk, reusing a released one when it is big enough */
+    LOGGER_MEM_CHUNK * next = ( chunk != NULL ) ? chunk->next : NULL;
+
+    if ( ( next != NULL ) && ( next->capacity < size ) )
+    {
+        logger_mem_chunkFreeFrom(arena, next);
+        next = NULL;
+    }
+
+    if ( next == NULL )
+    {
+        next = logger_mem_chunkCreate(arena, size);
+
+        if ( next == NULL )
+        {
+            if ( chunk != NULL )
+            {
+                chunk->next = NULL;
+            }
+
+            return NULL;
+        }
+
+        if ( chunk != NULL )
+        {
+            chunk->next = next;
+        }
+        else
+        {
+            arena->first = next;
+        }
+    }
+
+    next->used = size;
+    arena->current = next;
+
+    return logger_mem_chunkData(next);
+}
+
+/* chunk NULL releases everything */
+static void logger_mem_arenaRelease ( LOGGER_MEM_ARENA * arena, LOGGER_MEM_CHUNK * chunk, size_t used )
+{
+    if ( arena->first == NULL )
+    {
+        return;
+    }
+
+    if ( chunk == NULL )
+    {
+        chunk = arena->first;
+        used = 0U;
+    }
+
+    chunk->used = used;
+    arena->current = chunk;
+
+    /* chunks past the mark are kept for the next allocation unless the arena has grown beyond its bound */
+    if ( ( arena->reserved > LOGGER_MEM_SCRATCH_RETAIN ) && ( chunk->next != NULL ) )
+    {
+        logger_mem_chunkFreeFrom(arena, chunk->next);
+        chunk->next = NULL;
+    }
+}
+
+static void logger_mem_threadExit ( void * data )
+{
+    LOGGER_MEM_ARENA * arena = data;
+
+    logger_mem_chunkFreeFrom(arena, arena->first);
+
+    arena->first = NULL;
+    arena->current = NULL;
+}
+
+static void logger_mem_createKey ( void )
+{
+    pthread_key_create(&f_scratchKey, logger_mem_threadExit);
+}
+
+void * logger_mem_alloc ( size_t size )
+{
+    LOGGER_MEM_HEAP_HEADER * header = malloc( sizeof(LOGGER_MEM_HEAP_HEADER) + size );
+
+    if ( header == NULL )
+    {
+        return NULL;
+    }
+
+    header->size = sizeof(LOGGER_MEM_HEAP_HEADER) + size;
+    logger_mem_count(&f_heapBytes, header->size);
+
+    return header + 1;
+}
+
+void logger_mem_free ( void * ptr )
+{
+    if ( ptr != NULL )
+    {
+        LOGGER_MEM_HEAP_HEADER * header = (LOGGER_MEM_HEAP_HEADER *)ptr - 1;
+
+        logger_mem_uncount(&f_heapBytes, header->size);
+        free(header);
+    }
+}
+
+void * logger_mem_configAlloc ( size_t size )
+{
+    pthread_mutex_lock(&f_configMutex);
+
+    void * block = logger_mem_arenaAlloc(&f_configArena, size);
+
+    pthread_mutex_unlock(&f_configMutex);
+
+    return block;
+}
+
+void logger_mem_configReset ( void )
+{
+    pthread_mutex_lock(&f_configMutex);
+
+    logger_mem_chunkFreeFrom(&f_configArena, f_configArena.first);
+
+    f_configArena.first = NULL;
+    f_configArena.current = NULL;
+
+    pthread_mutex_unlock(&f_configMutex);
+}
+
+void * logger_mem_configDetach ( void )
+{
+    pthread_mutex_lock(&f_configMutex);
+
+    LOGGER_MEM_CHUNK * detached = f_configArena.first;
+
+    f_configArena.first = NULL;
+    f_configArena.current = NULL;
+
+    pthread_mutex_unlock(&f_configMutex);
+
+    return detached;
+}
+
+void logger_mem_configFree ( void * detached )
+{
+    pthread_mutex_lock(&f_configMutex);
+
+    logger_mem_chunkFreeFrom(&f_configArena, detached);
+
+    pthread_mutex_unlock(&f_configMutex);
+}
+
+void logger_mem_configRestore ( void * detached )
+{
+    pthread_mutex_lock(&f_configMutex);
+
+    logger_mem_chunkFreeFrom(&f_configArena, f_configArena.first);
+
+    /* nothing is released from the config arena, so allocation carries on in its last chunk */
+    LOGGER_MEM_CHUNK * current = detached;
+
+    while ( ( current != NULL ) && ( current->next != NULL ) )
+    {
+        current = current->next;
+    }
+
+    f_configArena.first = detached;
+    f_configArena.current = current;
+
+    pthread_mutex_unlock(&f_configMutex);
+}
+
+LOGGER_MEM_MARK logger_mem_scratchMark ( void )
+{
+    LOGGER_MEM_ARENA * arena = &f_scratchArena;
+    LOGGER_MEM_MARK mark = { arena->current, ( arena->current != NULL ) ? arena->current->used : 0U };
+
+    return mark;
+}
+
+void * logger_mem_scratchAlloc ( size_t size )
+{
+    LOGGER_MEM_ARENA * arena = &f_scratchArena;
+    bool firstChunk = ( arena->first == NULL );
+
+    void * block = logger_mem_arenaAlloc(arena, size);
+
+    if ( firstChunk && ( arena->first != NULL ) )
+    {
+        /* hand the chunks back when the thread exits */
+        pthread_once(&f_scratchKeyOnce, logger_mem_createKey);
+        pthread_setspecific(f_scratchKey, arena);
+    }
+
+    return block;
+}
+
+void * logger_mem_scratchResize ( void * block, size_t used, size_t size )
+{
+    LOGGER_MEM_CHUNK * chunk = f_scratchArena.current;
+
+    if ( chunk != NULL )
+    {
+        char * data = logger_mem_chunkData(chunk);
+
+        if ( ( (char *)block >= data ) && ( (char *)block < data + chunk->used ) )
+        {
+            size_t offset = (size_t)( (char *)block - data );
+
+            if ( LOGGER_MEM_ROUND(size) <= chunk->capacity - offset )
+            {
+                chunk->used = offset + LOGGER_MEM_ROUND(size);
+
+                return block;
+            }
+        }
+    }
+
+    void * moved = logger_mem_scratchAlloc(size);
+
+    if ( moved != NULL )
+    {
+        memcpy(moved, block, ( used < size ) ? used : size);
+    }
+
+    return moved;
+}
+
+size_t logger_mem_scratchAvailable ( void )
+{
+    LOGGER_MEM_CHUNK * chunk = f_scratchArena.current;
+
+    return ( chunk != NULL ) ? chunk->capacity - chunk->used : 0U;
+}
+
+void logger_mem_scratchRelease ( LOGGER_MEM_MARK mark )
+{
+    logger_mem_arenaRelease(&f_scratchArena, mark.chunk, mark.used);
+}
+
+void logger_mem_usage ( LOGGER_MEMORY_USAGE * usage )
+{
+    usage->heapBytes = __atomic_load_n(&f_heapBytes, __ATOMIC_RELAXED);
+    usage->configBytes = __atomic_load_n(&f_configBytes, __ATOMIC_RELAXED);
+    usage->scratchBytes = __atomic_load_n(&f_scratchBytes, __ATOMIC_RELAXED);
+    usage->peakBytes = __atomic_load_n(&f_peakBytes, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,162 @@
+/**
+ @file
+ Diagnostics print library - memory allocation
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#ifndef _LOGGER_MEMORY_H
+#define _LOGGER_MEMORY_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "logger.h"
+
+
+/**
+ @def LOGGER_MEM_CHUNK_SIZE
+ @brief smallest block an arena takes from the system. Larger requests get a chunk of their own
+ */
+#define LOGGER_MEM_CHUNK_SIZE (4096U)
+
+
+/**
+ @def LOGGER_MEM_SCRATCH_RETAIN
+ @brief bytes a thread's scratch arena keeps for reuse once released, anything above is handed back
+ */
+#define LOGGER_MEM_SCRATCH_RETAIN (256U * 1024U)
+
+
+/**
+ @brief position in the calling thread's scratch arena, see #logger_mem_scratchMark
+ */
+typedef struct _LOGGER_MEM_MARK
+{
+    void * chunk;
+    size_t used;
+} LOGGER_MEM_MARK;
+
+
+/**
+ @brief allocate memory that lives as long as the object owning it, e.g. a handle or queue
+ @details counted in #LOGGER_MEMORY_USAGE heapBytes. May be freed from any thread
+ @param[in] size bytes wanted
+ @return memory or NULL on failure
+ */
+void * logger_mem_alloc ( size_t size );
+
+
+/**
+ @brief free memory from #logger_mem_alloc
+ @param[in] ptr memory to free, NULL is ignored
+ */
+void logger_mem_free ( void * ptr );
+
+
+/**
+ @brief allocate from the config arena
+ @details for data parsed from the ini file. Nothing is freed individually, the whole arena is released by
+ #logger_mem_configReset
+ @param[in] size bytes wanted
+ @return memory or NULL on failure
+ */
+void * logger_mem_configAlloc ( size_t size );
+
+
+/**
+ @brief release everything allocated by #logger_mem_configAlloc
+ @details no config pointer may be used afterwards
+ */
+void logger_mem_configReset ( void );
+
+
+/**
+ @brief set aside everything allocated by #logger_mem_configAlloc so far, later allocations start afresh
+ @details the memory set aside stays valid, & counted, until passed to #logger_mem_configFree. Lets a new
+ configuration be built while readers still hold the old one
+ @return the memory set aside, NULL when there was none
+ */
+void * logger_mem_configDetach ( void );
+
+
+/**
+ @brief release memory set aside by #logger_mem_configDetach
+ @param[in] detached result of #logger_mem_configDetach, NULL is ignored
+ */
+void logger_mem_configFree ( void * detached );
+
+
+/**
+ @brief undo #logger_mem_configDetach, for a new configuration that could not be built
+ @details everything allocated since the detach is released & the memory set aside becomes the arena again
+ @param[in] detached result of #logger_mem_configDetach
+ */
+void logger_mem_configRestore ( void * detached );
+
+
+/**
+ @brief remember the current position of the calling thread's scratch arena
+ @return mark to pass to #logger_mem_scratchRelease
+ */
+LOGGER_MEM_MARK logger_mem_scratchMark ( void );
+
+
+/**
+ @brief allocate transient memory from the calling thread's scratch arena
+ @details only valid on the calling thread & until the arena is released past it. Nothing is taken from the
+ system once the arena has grown to what the thread needs
+ @param[in] size bytes wanted
+ @return memory or NULL on failure
+ */
+void * logger_mem_scratchAlloc ( size_t size );
+
+
+/**
+ @brief resize the most recent scratch allocation
+ @details grows in place when the chunk has room, otherwise the first used bytes are copied to a new block
+ @param[in] block the thread's last #logger_mem_scratchAlloc or #logger_mem_scratchResize result
+ @param[in] used bytes of block to keep
+ @param[in] size bytes wanted
+ @return memory, possibly moved, or NULL on failure in which case block is untouched
+ */
+void * logger_mem_scratchResize ( void * block, size_t used, size_t size );
+
+
+/**
+ @brief space left in the calling thread's current scratch chunk
+ @return bytes a #logger_mem_scratchAlloc can have without taking a new chunk, 0 before the first allocation
+ */
+size_t logger_mem_scratchAvailable ( void );
+
+
+/**
+ @brief release everything the calling thread allocated from its scratch arena since mark was taken
+ @param[in] mark from #logger_mem_scratchMark on the same thread
+ */
+void logger_mem_scratchRelease ( LOGGER_MEM_MARK mark );
+
+
+/**
+ @brief read the allocation counters
+ @param[out] usage bytes currently held
+ */
+void logger_mem_usage ( LOGGER_MEMORY_USAGE * usage );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _LOGGER_MEMORY_H */
@@ -9,79 +9,602 @@
  */
 
 
+/* localtime_r, tzset */
+#define _POSIX_C_SOURCE 200809L
+
 #include <time.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "logger.h"
 #include "logger_messageAssemble.h"
+#include "logger_format.h"
+#include "logger_memory.h"
+
+
+/* offset of the seconds digits in "hh:mm:ss dd/mm/yy" */
+#define LOGGER_TIMESTAMP_SECONDS_OFFSET (6U)
+
+/* sub-second digits go after "hh:mm:ss" */
+#define LOGGER_TIMESTAMP_FRACTION_OFFSET (8U)
+
+
+/** last rendered timestamp of this thread, valid for the whole minute starting at minuteStart */
+typedef struct _LOGGER_TIMESTAMP_CACHE
+{
+    time_t minuteStart;
+    time_t second;      /* time text currently shows */
+    const char * tzEnv; /* setenv("TZ") always allocates, a new pointer means a new zone */
+    size_t length;      /* 0 when empty */
+    char text[LOGGER_TIMESTAMP_SIZE];
+} LOGGER_TIMESTAMP_CACHE;
+
+
+static LOGGER_THREAD_LOCAL LOGGER_TIMESTAMP_CACHE f_timestampCache;
+
+/* local time minus UTC in seconds, as of the last timestamp rendered through localtime */
+static long f_timestampUtcOffset = 0L;
+
+
+/** fixed severity tags, indexed by the bit number of the level */
+typedef struct _LOGGER_LEVEL_TAG
+{
+    const char * tag;   /* NULL for levels without a tag */
+    size_t length;
+} LOGGER_LEVEL_TAG;
+
+static const LOGGER_LEVEL_TAG f_levelTags[] =
+{
+    { "-->", 3U },      /* LOGGER_LEVEL_ENTRY */
+    { "<--", 3U },      /* LOGGER_LEVEL_EXIT */
+    { NULL, 0U },       /* LOGGER_LEVEL_TRACE */
+    { "INFO", 4U },     /* LOGGER_LEVEL_INFO */
+    { "WARN", 4U },     /* LOGGER_LEVEL_WARN */
+    { "ERROR", 5U },    /* LOGGER_LEVEL_ERROR */
+    { "FATAL", 5U },    /* LOGGER_LEVEL_FATAL */
+    { "ASSRT", 5U },    /* LOGGER_LEVEL_ASSERT */
+    { "EVENT", 5U },    /* LOGGER_LEVEL_EVENT */
+};
+
+static const LOGGER_LEVEL_TAG f_levelTagUnknown = { "?????", 5U };
+
+/* divisor taking nanoseconds down to the given number of sub-second digits */
+static const uint32_t f_fractionDivisors[10] =
+{
+    1000000000U, 100000000U, 10000000U, 1000000U, 100000U, 10000U, 1000U, 100U, 10U, 1U
+};
 
 
-#define LOGGER_LOG_ENTRY_FORMAT ("%s%c%s%c%s%c%s%c%s%c%s")
+static const char * logger_timestamp_render ( time_t timestamp, size_t * textLen );
 
+static int logger_timestamp_segments ( LOGGER_TICKS ticks, char * fraction, struct iovec * segments );
+
+static int64_t logger_timestamp_daysFromCivil ( int64_t year, uint32_t month, uint32_t day );
+
+static size_t logger_timestamp_renderSafe ( LOGGER_TICKS ticks, char * text );
+
+static size_t logger_record_reserve ( LOGGER_RECORD_BUILDER * builder, size_t chars );
+
+
+/* make room for chars more, returns the space now available excluding the terminating \0 */
+static size_t logger_record_reserve ( LOGGER_RECORD_BUILDER * builder, size_t chars )
+{
+    size_t space = builder->capacity - builder->length - 1U;
+    
+    if ( ( space >= chars ) || ( builder->spill == false ) )
+    {
+        return space;
+    }
+    
+    size_t needed = builder->length + chars + 1U;
+    size_t limit = LOGGER_MESSAGE_MAX_SIZE + LOGGER_MAX_LOGGER_CHARS;
+    
+    needed = ( needed < limit ) ? needed : limit;
+    
+    if ( needed > builder->capacity )
+    {
+        /* doubling, so a long record takes a few moves at most */
+        size_t capacity = builder->capacity * 2U;
+        
+        capacity = ( capacity < needed ) ? needed : capacity;
+        capacity = ( capacity < limit ) ? capacity : limit;
+        
+        /* the record keeps its text, wherever it was built so far */
+        char * data = logger_mem_scratchResize( builder->buffer, builder->length, capacity );
+        
+        if ( data == NULL )
+        {
+            LOGPRINT_LOG_E("Malloc failure !!!");
+            return space;
+        }
+        
+        builder->buffer = data;
+        builder->capacity = capacity;
+    }
+    
+    return builder->capacity - builder->length - 1U;
+}
 
-void logger_assemble_string ( char * string, size_t string_size, char * timestamp, char * filename, char * linenumber, char * functionname, char * severity, char * message )
+void logger_record_begin ( LOGGER_RECORD_BUILDER * builder, char * buffer, size_t capacity )
 {
-    snprintf( (char*)(string), (string_size), LOGGER_LOG_ENTRY_FORMAT, \
-             (char*)(timestamp), LOGGER_SEPERATOR_CHAR, \
-             (char*)(filename), LOGGER_SEPERATOR_CHAR, \
-             (char*)(linenumber), LOGGER_SEPERATOR_CHAR, \
-             (char*)(functionname), LOGGER_SEPERATOR_CHAR, \
-             (char*)(severity), LOGGER_SEPERATOR_CHAR, \
-             (char*)(message) );
+    builder->buffer = buffer;
+    builder->capacity = capacity;
+    builder->length = 0U;
+    builder->spill = false;
+    builder->truncated = false;
 }
 
-void loggerLevelStringFromLevel ( LOGGER_LEVEL level, char * stringSeverity, uint8_t stringSize )
+void logger_record_beginSpill ( LOGGER_RECORD_BUILDER * builder, char * buffer, size_t capacity )
 {
-    char * levelStr = NULL;
+    size_t available = logger_mem_scratchAvailable();
+    
+    builder->mark = logger_mem_scratchMark();
     
-    switch ( level )
+    /* once a thread has scratch space it is used from the start. It is already allocated & finding a message is too
+       long by a truncated vsnprintf costs many times the format itself */
+    if ( available > capacity )
     {
-        case LOGGER_LEVEL_ENTRY:
-            levelStr = "-->";
-            break;
-            
-        case LOGGER_LEVEL_EXIT:
-            levelStr = "<--";
-            break;
-            
-        case LOGGER_LEVEL_INFO:
-            levelStr = "INFO";
-            break;
-            
-        case LOGGER_LEVEL_WARN:
-            levelStr = "WARN";
-            break;
-            
-        case LOGGER_LEVEL_ERROR:
-            levelStr = "ERROR";
-            break;
-            
-        case LOGGER_LEVEL_FATAL:
-            levelStr = "FATAL";
-            break;
-            
-        case LOGGER_LEVEL_ASSERT:
-            levelStr = "ASSRT";
-            break;
-            
-        case LOGGER_LEVEL_EVENT:
-            levelStr = "EVENT";
-            break;
+        logger_record_begin( builder, logger_mem_scratchAlloc( available ), available );
+    }
+    else
+    {
+        logger_record_begin( builder, buffer, capacity );
+    }
+    
+    builder->spill = true;
+}
+
+void logger_record_release ( LOGGER_RECORD_BUILDER * builder )
+{
+    if ( builder->spill )
+    {
+        logger_mem_scratchRelease( builder->mark );
+    }
+}
+
+void logger_record_appendChar ( LOGGER_RECORD_BUILDER * builder, char c )
+{
+    if ( ( builder->length+1U < builder->capacity ) || ( logger_record_reserve( builder, 1U ) != 0U ) )
+    {
+        builder->buffer[builder->length] = c;
+        builder->length += 1U;
+    }
+    else
+    {
+        builder->truncated = true;
+    }
+}
+
+void logger_record_appendString ( LOGGER_RECORD_BUILDER * builder, const char * str, size_t maxLen )
+{
+    if ( str != NULL )
+    {
+        size_t space = builder->capacity - builder->length - 1U;
+        
+        if ( ( space < maxLen ) && builder->spill )
+        {
+            space = logger_record_reserve( builder, strnlen( str, maxLen ) );
+        }
+        
+        size_t limit = ( maxLen < space ) ? maxLen : space;
+        char * out = &builder->buffer[builder->length];
+        size_t i = 0U;
+        
+        /* copy & measure in the same pass */
+        while ( ( i < limit ) && ( str[i] != '\0' ) )
+        {
+            out[i] = str[i];
+            i++;
+        }
+        
+        if ( ( i == space ) && ( space < maxLen ) && ( str[i] != '\0' ) )
+        {
+            builder->truncated = true;
+        }
+        
+        builder->length += i;
+    }
+}
+
+void logger_record_appendBytes ( LOGGER_RECORD_BUILDER * builder, const char * data, size_t dataLen )
+{
+    size_t space = logger_record_reserve( builder, dataLen );
+    size_t len = ( dataLen < space ) ? dataLen : space;
+    
+    memcpy(&builder->buffer[builder->length], data, len);
+    builder->length += len;
+    builder->truncated |= ( len < dataLen );
+}
+
+void logger_record_appendFormatV ( LOGGER_RECORD_BUILDER * builder, size_t maxLen, const char * fmt, va_list args )
+{
+    if ( fmt != NULL )
+    {
+        size_t space = builder->capacity - builder->length;
+        size_t limit = ( maxLen+1U < space ) ? maxLen+1U : space;
+        va_list argsRetry;
+        
+        va_copy(argsRetry, args);
+        
+        int written = vsnprintf(&builder->buffer[builder->length], limit, fmt, args);
+        
+        if ( ( written > 0 ) && ( (size_t)written >= limit ) && ( limit <= maxLen ) && builder->spill )
+        {
+            /* did not fit, continue in the scratch arena & format again now the length is known */
+            space = logger_record_reserve( builder, ( (size_t)written < maxLen ) ? (size_t)written : maxLen ) + 1U;
+            limit = ( maxLen+1U < space ) ? maxLen+1U : space;
             
-        default:
-            levelStr = "?????";
-            LOGPRINT_LOG_E("Unrecognised logger level %d",level);
-            break;
+            written = vsnprintf(&builder->buffer[builder->length], limit, fmt, argsRetry);
+        }
+        
+        va_end(argsRetry);
+        
+        if ( written > 0 )
+        {
+            /* vsnprintf reports the untruncated length */
+            builder->length += ( (size_t)written < limit ) ? (size_t)written : limit-1U;
+            builder->truncated |= ( (size_t)written >= limit );
+        }
     }
+}
+
+void logger_record_appendFormat ( LOGGER_RECORD_BUILDER * builder, size_t maxLen, const char * fmt, ... )
+{
+    va_list args;
+    va_start(args, fmt);
+    
+    logger_record_appendFormatV(builder, maxLen, fmt, args);
+    
+    va_end(args);
+}
+
+const char * logger_record_baseName ( const char * fileName )
+{
+    const char * baseName = strrchr(fileName, '/');
+    
+    return ( baseName != NULL ) ? baseName+1 : fileName;
+}
+
+void logger_record_appendHeader ( LOGGER_RECORD_BUILDER * builder, const char * fileName, int lineNumber, const char * functionName, LOGGER_LEVEL severity )
+{
+    const char * baseName = logger_record_baseName(fileName);
     
-    snprintf((char *)stringSeverity, stringSize, "%s",(char*)levelStr);
+    char lineText[LOGGER_FORMAT_INT32_CHARS];
+    size_t lineTextLen = logger_format_int32( lineText, (int32_t)lineNumber );
+    
+    size_t tagLen = 0U;
+    const char * tag = loggerLevelTagFromLevel( severity, &tagLen );
+    
+    /* no printf anywhere in the header */
+    logger_record_appendChar( builder, LOGGER_SEPERATOR_CHAR );
+    logger_record_appendString( builder, baseName, SIZE_MAX );
+    logger_record_appendChar( builder, LOGGER_SEPERATOR_CHAR );
+    logger_record_appendBytes( builder, lineText, ( lineTextLen < LOGGER_LINENUMBER_SIZE-1U ) ? lineTextLen : LOGGER_LINENUMBER_SIZE-1U );
+    logger_record_appendChar( builder, LOGGER_SEPERATOR_CHAR );
+    logger_record_appendString( builder, functionName, LOGGER_FUNCTIONNAME_SIZE-1U );
+    logger_record_appendChar( builder, LOGGER_SEPERATOR_CHAR );
+    logger_record_appendBytes( builder, tag, tagLen );
+    logger_record_appendChar( builder, LOGGER_SEPERATOR_CHAR );
+}
+
+int logger_record_segments ( const LOGGER_RECORD * record, char * fraction, struct iovec * segments )
+{
+    int segmentCount = logger_timestamp_segments( record->ticks, fraction, segments );
+    
+    if ( record->header != NULL )
+    {
+        segments[segmentCount].iov_base = (void *)record->header;
+        segments[segmentCount].iov_len = record->headerLen;
+        segmentCount += 1;
+    }
+    
+    segments[segmentCount].iov_base = (void *)record->message;
+    segments[segmentCount].iov_len = record->messageLen;
+    segmentCount += 1;
+    
+    return segmentCount;
 }
 
-void loggerGetTimeString ( char * stringTimestamp, size_t stringSize )
+int logger_record_segmentsSafe ( const LOGGER_RECORD * record, char * timestamp, struct iovec * segments )
 {
-    time_t  t = time(NULL);
-    struct  tm *tme = localtime(&t);
+    int segmentCount = 1;
+    
+    segments[0].iov_base = timestamp;
+    segments[0].iov_len = logger_timestamp_renderSafe( record->ticks, timestamp );
+    
+    if ( record->header != NULL )
+    {
+        segments[segmentCount].iov_base = (void *)record->header;
+        segments[segmentCount].iov_len = record->headerLen;
+        segmentCount += 1;
+    }
+    
+    segments[segmentCount].iov_base = (void *)record->message;
+    segments[segmentCount].iov_len = record->messageLen;
+    segmentCount += 1;
+    
+    return segmentCount;
+}
+
+size_t logger_record_end ( LOGGER_RECORD_BUILDER * builder )
+{
+    builder->buffer[builder->length] = '\0';
+    
+    return builder->length;
+}
+
+const char * loggerLevelTagFromLevel ( LOGGER_LEVEL level, size_t * tagLength )
+{
+    const LOGGER_LEVEL_TAG * levelTag = &f_levelTagUnknown;
+    
+    /* exactly one level bit set */
+    if ( ( level != 0U ) && ( ( level & (level - 1U) ) == 0U ) )
+    {
+        uint32_t bit = (uint32_t)__builtin_ctz((unsigned int)level);
+        
+        if ( ( bit < sizeof(f_levelTags)/sizeof(f_levelTags[0]) ) && ( f_levelTags[bit].tag != NULL ) )
+        {
+            levelTag = &f_levelTags[bit];
+        }
+    }
+    
+    if ( levelTag == &f_levelTagUnknown )
+    {
+        LOGPRINT_LOG_E("Unrecognised logger level %d",level);
+    }
+    
+    *tagLength = levelTag->length;
+    
+    return levelTag->tag;
+}
+
+const char * loggerLevelNameFromLevel ( LOGGER_LEVEL level )
+{
+    size_t tagLength = 0U;
+    
+    return loggerLevelTagFromLevel(level, &tagLength);
+}
+
+void loggerLevelStringFromLevel ( LOGGER_LEVEL level, char * stringSeverity, uint8_t stringSize )
+{
+    size_t tagLength = 0U;
+    const char * tag = loggerLevelTagFromLevel(level, &tagLength);
+    
+    if ( stringSize != 0U )
+    {
+        tagLength = ( tagLength < stringSize ) ? tagLength : stringSize-1U;
+        
+        memcpy(stringSeverity, tag, tagLength);
+        stringSeverity[tagLength] = '\0';
+    }
+}
+
+size_t loggerGetTimeString ( char * stringTimestamp, size_t stringSize )
+{
+    return loggerTimeStringFromTime(time(NULL), stringTimestamp, stringSize);
+}
+
+static const char * logger_timestamp_render ( time_t timestamp, size_t * textLen )
+{
+    LOGGER_TIMESTAMP_CACHE * cache = &f_timestampCache;
+    
+    *textLen = cache->length;
+    
+    if ( ( *textLen != 0U ) && ( timestamp == cache->second ) )
+    {
+        /* same second, text is already correct */
+    }
+    else if ( ( *textLen != 0U ) &&
+              ( timestamp >= cache->minuteStart ) &&
+              ( timestamp < cache->minuteStart + 60 ) &&
+              ( getenv("TZ") == cache->tzEnv ) )
+    {
+        /* same minute & zone, only the seconds digits move */
+        logger_format_twoDigits( &cache->text[LOGGER_TIMESTAMP_SECONDS_OFFSET], (uint32_t)(timestamp - cache->minuteStart) );
+        cache->second = timestamp;
+    }
+    else
+    {
+        struct tm tme;
+        
+        /* pick up TZ changes. Zone offsets only ever change on a minute boundary */
+        cache->tzEnv = getenv("TZ");
+        tzset();
+        localtime_r(&timestamp, &tme);
+        
+        /* kept for rendering from a signal handler, where localtime may not be called */
+        int64_t localSeconds = logger_timestamp_daysFromCivil(tme.tm_year+1900, (uint32_t)(tme.tm_mon+1), (uint32_t)tme.tm_mday) * 86400 +
+                               tme.tm_hour * 3600 + tme.tm_min * 60 + tme.tm_sec;
+        
+        __atomic_store_n(&f_timestampUtcOffset, (long)( localSeconds - (int64_t)timestamp ), __ATOMIC_RELAXED);
+        
+        /* "hh:mm:ss dd/mm/yy", the year keeps a third digit from 2100 as printf("%02d") did */
+        char * text = cache->text;
+        uint32_t year = (uint32_t)(tme.tm_year+1900) % 1000U;
+        
+        logger_format_twoDigits( &text[0], (uint32_t)tme.tm_hour );
+        text[2] = ':';
+        logger_format_twoDigits( &text[3], (uint32_t)tme.tm_min );
+        text[5] = ':';
+        logger_format_twoDigits( &text[6], (uint32_t)tme.tm_sec );
+        text[8] = ' ';
+        logger_format_twoDigits( &text[9], (uint32_t)tme.tm_mday );
+        text[11] = '/';
+        logger_format_twoDigits( &text[12], (uint32_t)(tme.tm_mon+1) );
+        text[14] = '/';
+        
+        if ( year < 100U )
+        {
+            logger_format_twoDigits( &text[15], year );
+            *textLen = 17U;
+        }
+        else
+        {
+            *textLen = 15U + logger_format_uint32( &text[15], year );
+        }
+        
+        text[*textLen] = '\0';
+        
+        if ( tme.tm_sec > 59 )
+        {
+            /* leap second, use it once & render again next time */
+            cache->length = 0U;
+        }
+        else
+        {
+            cache->minuteStart = timestamp - tme.tm_sec;
+            cache->second = timestamp;
+            cache->length = *textLen;
+        }
+    }
+    
+    return cache->text;
+}
+
+size_t loggerTimeStringFromTime ( time_t timestamp, char * stringTimestamp, size_t stringSize )
+{
+    size_t textLen = 0U;
+    const char * text = logger_timestamp_render(timestamp, &textLen);
+    
+    size_t len = ( textLen < stringSize ) ? textLen : stringSize-1U;
+    
+    memcpy(stringTimestamp, text, len);
+    stringTimestamp[len] = '\0';
+    
+    return len;
+}
+
+/* days since 1970-01-01 of a proleptic Gregorian date */
+static int64_t logger_timestamp_daysFromCivil ( int64_t year, uint32_t month, uint32_t day )
+{
+    year -= ( month <= 2U ) ? 1 : 0;
+    
+    int64_t era = ( ( year >= 0 ) ? year : year-399 ) / 400;
+    int64_t yearOfEra = year - era * 400;
+    int64_t dayOfYear = ( 153 * (int64_t)( ( month > 2U ) ? month-3U : month+9U ) + 2 ) / 5 + (int64_t)day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra/4 - yearOfEra/100 + dayOfYear;
+    
+    return era * 146097 + dayOfEra - 719468;
+}
+
+/* as the cached text & fraction joined, by arithmetic alone. Returns chars written */
+static size_t logger_timestamp_renderSafe ( LOGGER_TICKS ticks, char * text )
+{
+    time_t seconds = 0;
+    uint32_t nanoseconds = 0U;
+    uint32_t digits = (uint32_t)logger_clock_precision();
+    
+    logger_clock_toWallTime(ticks, &seconds, &nanoseconds);
+    
+    int64_t local = (int64_t)seconds + __atomic_load_n(&f_timestampUtcOffset, __ATOMIC_RELAXED);
+    int64_t days = ( ( local >= 0 ) ? local : local - 86399 ) / 86400;
+    uint32_t secondOfDay = (uint32_t)( local - days * 86400 );
+    
+    /* civil date from the day count, the inverse of logger_timestamp_daysFromCivil */
+    days += 719468;
+    
+    int64_t era = ( ( days >= 0 ) ? days : days - 146096 ) / 146097;
+    int64_t dayOfEra = days - era * 146097;
+    int64_t yearOfEra = ( dayOfEra - dayOfEra/1460 + dayOfEra/36524 - dayOfEra/146096 ) / 365;
+    int64_t dayOfYear = dayOfEra - ( 365 * yearOfEra + yearOfEra/4 - yearOfEra/100 );
+    int64_t monthIndex = ( 5 * dayOfYear + 2 ) / 153;
+    uint32_t day = (uint32_t)( dayOfYear - ( 153 * monthIndex + 2 ) / 5 + 1 );
+    uint32_t month = (uint32_t)( ( monthIndex < 10 ) ? monthIndex+3 : monthIndex-9 );
+    int64_t year = yearOfEra + era * 400 + ( ( month <= 2U ) ? 1 : 0 );
+    
+    size_t length = LOGGER_TIMESTAMP_FRACTION_OFFSET;
+    
+    logger_format_twoDigits( &text[0], secondOfDay / 3600U );
+    text[2] = ':';
+    logger_format_twoDigits( &text[3], ( secondOfDay / 60U ) % 60U );
+    text[5] = ':';
+    logger_format_twoDigits( &text[6], secondOfDay % 60U );
+    
+    if ( digits != 0U )
+    {
+        text[length] = '.';
+        logger_format_fixedDigits( &text[length+1U], nanoseconds / f_fractionDivisors[digits], digits );
+        length += digits + 1U;
+    }
+    
+    text[length] = ' ';
+    logger_format_twoDigits( &text[length+1U], day );
+    text[length+3U] = '/';
+    logger_format_twoDigits( &text[length+4U], month );
+    text[length+6U] = '/';
+    length += 7U;
+    
+    uint32_t shortYear = (uint32_t)( ( year > 0 ) ? year : 0 ) % 1000U;
+    
+    if ( shortYear < 100U )
+    {
+        logger_format_twoDigits( &text[length], shortYear );
+        length += 2U;
+    }
+    else
+    {
+        length += logger_format_uint32( &text[length], shortYear );
+    }
+    
+    return length;
+}
+
+/* "hh:mm:ss" + "." + digits + " dd/mm/yy", the cached text is pointed at rather than copied */
+static int logger_timestamp_segments ( LOGGER_TICKS ticks, char * fraction, struct iovec * segments )
+{
+    time_t seconds = 0;
+    uint32_t nanoseconds = 0U;
+    uint32_t digits = (uint32_t)logger_clock_precision();
+    
+    logger_clock_toWallTime(ticks, &seconds, &nanoseconds);
+    
+    size_t textLen = 0U;
+    const char * text = logger_timestamp_render(seconds, &textLen);
+    
+    if ( ( digits == 0U ) || ( textLen < LOGGER_TIMESTAMP_FRACTION_OFFSET ) )
+    {
+        segments[0].iov_base = (void *)text;
+        segments[0].iov_len = textLen;
+        
+        return 1;
+    }
+    
+    fraction[0] = '.';
+    logger_format_fixedDigits( &fraction[1], nanoseconds / f_fractionDivisors[digits], digits );
+    
+    segments[0].iov_base = (void *)text;
+    segments[0].iov_len = LOGGER_TIMESTAMP_FRACTION_OFFSET;
+    segments[1].iov_base = fraction;
+    segments[1].iov_len = digits + 1U;
+    segments[2].iov_base = (void *)&text[LOGGER_TIMESTAMP_FRACTION_OFFSET];
+    segments[2].iov_len = textLen - LOGGER_TIMESTAMP_FRACTION_OFFSET;
+    
+    return 3;
+}
+
+size_t loggerTimeStringFromTicks ( LOGGER_TICKS ticks, char * stringTimestamp, size_t stringSize )
+{
+    char fraction[LOGGER_TIMESTAMP_FRACTION_SIZE];
+    struct iovec segments[3];
+    size_t len = 0U;
+    
+    int segmentCount = logger_timestamp_segments(ticks, fraction, segments);
+    
+    for ( int i=0; i<segmentCount; i++ )
+    {
+        size_t segmentLen = segments[i].iov_len;
+        
+        if ( len+segmentLen >= stringSize )
+        {
+            segmentLen = stringSize-1U-len;
+        }
+        
+        memcpy(&stringTimestamp[len], segments[i].iov_base, segmentLen);
+        len += segmentLen;
+    }
+    
+    stringTimestamp[len] = '\0';
     
-    snprintf((char*)stringTimestamp, (size_t)stringSize, "%02d:%02d:%02d %02d/%02d/%02d",
-             tme->tm_hour, tme->tm_min, tme->tm_sec, tme->tm_mday, (tme->tm_mon+1), (tme->tm_year+1900)%1000 );
+    return len;
 }
@@ -18,10 +18,16 @@ extern "C" {
 #endif
 
 
+#include <stdarg.h>
+#include <stdbool.h>
 #include <stdint.h>
+#include <time.h>
+#include <sys/uio.h>
 
 #include "logger.h"
 #include "logger_common.h"
+#include "logger_clock.h"
+#include "logger_memory.h"
 
 
 /**
@@ -32,7 +38,7 @@ extern "C" {
 #define LOGGER_SEPERATOR_CHAR_SIZE (1)
 
 /* sizes include terminating \0 char */
-#define LOGGER_TIMESTAMP_SIZE        (18U)     /* size of the timestamp string */
+#define LOGGER_TIMESTAMP_SIZE        (28U)     /* size of the timestamp string, with up to 9 sub-second digits */
 #define LOGGER_FUNCTIONNAME_SIZE     (62U)
 #define LOGGER_FILENAME_SIZE         (20U)
 #define LOGGER_LINENUMBER_SIZE       (6U)
@@ -61,17 +67,222 @@ extern "C" {
 
 
 /**
- @brief from the given message properties write to string assembling output
- @param[in] string string to write to
- @param[in] string_size max chars to write into string
- @param[in] timestamp NULL terminated string detailing current momemnt of time
- @param[in] filename NULL terminated string of filename (filename without path)
- @param[in] linenumber NULL terminated string of linenumber
- @param[in] functioname NULL terminated string of functionname
- @param[in] severity NULL terminated string of severity
- @param[in] message NULL terminated string of message
+ @def LOGGER_RECORD_INLINE_SIZE
+ @brief size of the on-stack buffer a record is first built in. Records that do not fit move to the thread's
+ scratch arena, see #logger_record_beginSpill
  */
-void logger_assemble_string ( char * string, size_t string_size, char * timestamp, char * filename, char * linenumber, char * functionname, char * severity, char * message );
+#define LOGGER_RECORD_INLINE_SIZE (512U)
+
+
+/**
+ @def LOGGER_MESSAGE_MAX_SIZE
+ @brief longest message a spilling record accepts, anything longer is truncated
+ */
+#define LOGGER_MESSAGE_MAX_SIZE (16U * 1024U * 1024U)
+
+
+/**
+ @def LOGGER_TIMESTAMP_FRACTION_SIZE
+ @brief space for the "." & up to 9 sub-second digits of a timestamp, rendered separately from the cached text
+ */
+#define LOGGER_TIMESTAMP_FRACTION_SIZE (10U)
+
+
+/**
+ @def LOGGER_RECORD_SEGMENTS_MAX
+ @brief most segments a record is output as: time, fraction, date, header & message from #logger_record_segments,
+ then the rendered fields
+ */
+#define LOGGER_RECORD_SEGMENTS_MAX (6)
+
+
+/**
+ @brief a finished record, kept as the pieces it is output from
+ @details header is the static header of a resolved callsite & is never copied. It is NULL when the callsite
+ could not be resolved, message then starts with the header fields. fields holds the encoded structured fields
+ of a #logPrintKV record, see logger_fields.h
+ */
+typedef struct _LOGGER_RECORD
+{
+    LOGGER_TICKS ticks;     /* capture time from #logger_clock_now */
+    LOGGER_LEVEL level;     /* a single level bit */
+    const char * header;
+    size_t headerLen;
+    const char * message;
+    size_t messageLen;
+    const uint8_t * fields; /* NULL for plain records */
+    size_t fieldsLen;
+    uint32_t outputs;       /* outputs the printing handle is bound to, 0 for the ones bound to no handle */
+} LOGGER_RECORD;
+
+
+/**
+ @brief destination for finished records
+ @param[in] record record to output, only valid for the duration of the call
+ @return #LOGGER_STATUS_OK on success
+ */
+typedef LOGGER_STATUS (*LOGGER_RECORD_SEND) ( const LOGGER_RECORD * record );
+
+
+/**
+ @brief running state while a record is written field by field into one buffer
+ @details length always counts the characters written so far, buffer[length] is never read
+ */
+typedef struct _LOGGER_RECORD_BUILDER
+{
+    char * buffer;
+    size_t capacity;  /* includes space for the terminating \0 */
+    size_t length;
+    bool spill;       /* move to the thread's scratch arena instead of truncating */
+    bool truncated;   /* an append was cut short for lack of space */
+    LOGGER_MEM_MARK mark;   /* scratch arena position before the record, when spill is set */
+} LOGGER_RECORD_BUILDER;
+
+
+/**
+ @brief start a new record
+ @param[out] builder builder to set up
+ @param[in] buffer output buffer. Nothing is written past what the fields need
+ @param[in] capacity size of buffer including the terminating \0. Must be non-zero
+ */
+void logger_record_begin ( LOGGER_RECORD_BUILDER * builder, char * buffer, size_t capacity );
+
+
+/**
+ @brief start a new record that may outgrow buffer
+ @details when a field does not fit, what was written so far moves to the calling thread's scratch arena & the
+ record continues there, so builder->buffer may change. Threads that already have scratch space build in it from
+ the start. Nothing is allocated per record once the arena has grown to the longest record seen. The record must be
+ handed back with #logger_record_release once it has been sent
+ @param[out] builder builder to set up
+ @param[in] buffer first choice output buffer, normally #LOGGER_RECORD_INLINE_SIZE on the stack
+ @param[in] capacity size of buffer including the terminating \0. Must be non-zero
+ */
+void logger_record_beginSpill ( LOGGER_RECORD_BUILDER * builder, char * buffer, size_t capacity );
+
+
+/**
+ @brief return the scratch space of a record started with #logger_record_beginSpill
+ @details the record's buffer, & anything the thread took from its scratch arena since, is invalid afterwards
+ @param[in] builder record that has been sent
+ */
+void logger_record_release ( LOGGER_RECORD_BUILDER * builder );
+
+
+/**
+ @brief append a single character
+ @param[in] builder record being built
+ @param[in] c character to append
+ */
+void logger_record_appendChar ( LOGGER_RECORD_BUILDER * builder, char c );
+
+
+/**
+ @brief append a NULL terminated string, stopping at maxLen characters
+ @param[in] builder record being built
+ @param[in] str string to append. NULL appends nothing
+ @param[in] maxLen maximum number of characters of str to append
+ */
+void logger_record_appendString ( LOGGER_RECORD_BUILDER * builder, const char * str, size_t maxLen );
+
+
+/**
+ @brief append a run of characters already known to fit the field
+ @param[in] builder record being built
+ @param[in] data characters to append, not NULL terminated
+ @param[in] dataLen number of characters. Truncated to the space left
+ */
+void logger_record_appendBytes ( LOGGER_RECORD_BUILDER * builder, const char * data, size_t dataLen );
+
+
+/**
+ @brief printf the user message straight into the record
+ @param[in] builder record being built
+ @param[in] maxLen maximum number of characters to append
+ @param[in] fmt message format. NULL appends nothing
+ @param[in] args format arguments
+ */
+void logger_record_appendFormatV ( LOGGER_RECORD_BUILDER * builder, size_t maxLen, const char * fmt, va_list args );
+
+
+/**
+ @brief printf into the record
+ @param[in] builder record being built
+ @param[in] maxLen maximum number of characters to append
+ @param[in] fmt format. NULL appends nothing
+ @param[in] ... format arguments
+ */
+void logger_record_appendFormat ( LOGGER_RECORD_BUILDER * builder, size_t maxLen, const char * fmt, ... );
+
+
+/**
+ @brief file name of a callsite without its path
+ @param[in] fileName file of callsite
+ @return the part of fileName after its last directory, fileName itself when it has none
+ */
+const char * logger_record_baseName ( const char * fileName );
+
+
+/**
+ @brief append every field between the timestamp & the user message, each preceded by #LOGGER_SEPERATOR_CHAR
+ @details the file name is appended whole, the other fields are cut to their #LOGGER_FUNCTIONNAME_SIZE etc.
+ @param[in] builder record being built
+ @param[in] fileName file of callsite, path is removed
+ @param[in] lineNumber line of callsite
+ @param[in] functionName function of callsite
+ @param[in] severity level of record
+ */
+void logger_record_appendHeader ( LOGGER_RECORD_BUILDER * builder, const char * fileName, int lineNumber, const char * functionName, LOGGER_LEVEL severity );
+
+
+/**
+ @brief describe the complete record as segments in output order, for a plugin to gather
+ @details only the sub-second digits are rendered, every other segment points at the thread's cached timestamp
+ text or at the record itself. The segments are valid until the calling thread renders another timestamp
+ @param[in] record finished record
+ @param[out] fraction buffer of #LOGGER_TIMESTAMP_FRACTION_SIZE chars for the sub-second digits
+ @param[out] segments array of #LOGGER_RECORD_SEGMENTS_MAX
+ @return number of segments filled
+ */
+int logger_record_segments ( const LOGGER_RECORD * record, char * fraction, struct iovec * segments );
+
+
+/**
+ @brief describe the record as segments in output order, from a signal handler
+ @details as #logger_record_segments but async-signal-safe: the timestamp is rendered by arithmetic alone, in the
+ zone offset of the last timestamp any thread rendered. Encoded fields are left out
+ @param[in] record finished record
+ @param[out] timestamp buffer of #LOGGER_TIMESTAMP_SIZE chars for the whole timestamp
+ @param[out] segments array of #LOGGER_RECORD_SEGMENTS_MAX
+ @return number of segments filled
+ */
+int logger_record_segmentsSafe ( const LOGGER_RECORD * record, char * timestamp, struct iovec * segments );
+
+
+/**
+ @brief terminate the record
+ @param[in] builder record being built
+ @return number of characters in the record excluding the terminating \0
+ */
+size_t logger_record_end ( LOGGER_RECORD_BUILDER * builder );
+
+
+/**
+ @brief from a given level get the fixed severity tag & its length
+ @details table lookup on the level bit, levels without a tag give "?????"
+ @param[in] level logger level, a single bit
+ @param[out] tagLength number of chars in the tag
+ @return static string, never NULL
+ */
+const char * loggerLevelTagFromLevel ( LOGGER_LEVEL level, size_t * tagLength );
+
+
+/**
+ @brief from a given level get the fixed severity tag
+ @param[in] level logger level
+ @return static string, never NULL
+ */
+const char * loggerLevelNameFromLevel ( LOGGER_LEVEL level );
 
 
 /**
@@ -102,8 +313,32 @@ void loggerFileNameString ( char * stringFileName, uint8_t stringSize, char * fi
  @details create in format printf("%02d:%02d:%02d %02d/%02d/%02d",hr,min,seconds,day,month,year)
  @param[out] stringTimeStamp timestamp string to write to
  @param[in] stringSize maximum number of chars to write timestamp to. must be greater than equal to #LOGGER_TIMESTAMP_CHARS_MINIMUM
+ @return number of characters written excluding the terminating \0
+ */
+size_t loggerGetTimeString ( char * stringTimestamp, size_t stringSize );
+
+
+/**
+ @brief create timestamp for the given time
+ @details same format as #loggerGetTimeString
+ @param[in] timestamp time to render
+ @param[out] stringTimeStamp timestamp string to write to
+ @param[in] stringSize maximum number of chars to write timestamp to
+ @return number of characters written excluding the terminating \0
+ */
+size_t loggerTimeStringFromTime ( time_t timestamp, char * stringTimestamp, size_t stringSize );
+
+
+/**
+ @brief create timestamp for captured clock ticks
+ @details as #loggerGetTimeString with the configured number of sub-second digits after the seconds,
+ e.g. "hh:mm:ss.uuuuuu dd/mm/yy"
+ @param[in] ticks capture time from #logger_clock_now
+ @param[out] stringTimeStamp timestamp string to write to
+ @param[in] stringSize maximum number of chars to write timestamp to
+ @return number of characters written excluding the terminating \0
  */
-void loggerGetTimeString ( char * stringTimestamp, size_t stringSize );
+size_t loggerTimeStringFromTicks ( LOGGER_TICKS ticks, char * stringTimestamp, size_t stringSize );
 
     
 #ifdef __cplusplus
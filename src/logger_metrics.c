@@ -0,0 +1,314 @@
+/**
+ @file
+ Diagnostics print library - metrics
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+/* clock_gettime, pthread keys */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include "logger_metrics.h"
+#include "logger_common.h"
+#include "logger_memory.h"
+#include "logger_stringUtil.h"
+
+
+#define LOGGER_METRICS_STATE_FREE  (0U)
+#define LOGGER_METRICS_STATE_OWNED (1U)
+
+/* only the owning thread writes a block, a plain add stored atomically so a reader never sees a torn value */
+#define LOGGER_METRICS_ADD(counter, n) \
+    __atomic_store_n(&(counter), __atomic_load_n(&(counter), __ATOMIC_RELAXED) + (n), __ATOMIC_RELAXED)
+
+
+/** one thread's counters. Kept for the life of the process, a block left by an exited thread is taken over by the
+    next new thread & carries on counting from its totals */
+typedef struct _LOGGER_METRICS_BLOCK
+{
+    struct _LOGGER_METRICS_BLOCK * next;
+    uint32_t state;
+    uint64_t records[LOGGER_STATS_LEVELS];
+    uint64_t filtered;
+    uint64_t rateLimited;
+    uint64_t deduplicated;
+    uint64_t truncated;
+    uint64_t dropped;
+    uint64_t latency[LOGGER_STATS_LATENCY_BUCKETS];
+    uint64_t outputRecords[LOGGER_STATS_OUTPUTS_MAX];
+    uint64_t outputBytes[LOGGER_STATS_OUTPUTS_MAX];
+    uint64_t outputFailures[LOGGER_STATS_OUTPUTS_MAX];
+} LOGGER_METRICS_BLOCK;
+
+
+static LOGGER_METRICS_BLOCK * f_metricsBlocks = NULL;
+
+static LOGGER_THREAD_LOCAL LOGGER_METRICS_BLOCK * f_threadBlock = NULL;
+
+static const char * f_outputNames[LOGGER_STATS_OUTPUTS_MAX];
+
+static bool f_latencyEnabled = false;
+
+static pthread_once_t f_metricsKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t f_metricsKey;
+
+
+static void logger_metrics_threadExit ( void * block );
+
+static void logger_metrics_createKey ( void );
+
+static LOGGER_METRICS_BLOCK * logger_metrics_acquire ( void );
+
+static LOGGER_METRICS_BLOCK * logger_metrics_threadBlock ( void );
+
+static uint64_t logger_metrics_clockNs ( void );
+
+
+static void logger_metrics_threadExit ( void * block )
+{
+    __atomic_store_n(&((LOGGER_METRICS_BLOCK *)block)->state, LOGGER_METRICS_STATE_FREE, __ATOMIC_RELEASE);
+}
+
+static void logger_metrics_createKey ( void )
+{
+    pthread_key_create(&f_metricsKey, logger_metrics_threadExit);
+}
+
+static LOGGER_METRICS_BLOCK * logger_metrics_acquire ( void )
+{
+    pthread_once(&f_metricsKeyOnce, logger_metrics_createKey);
+
+    /* reuse a block left behind by an exited thread */
+    LOGGER_METRICS_BLOCK * block = __atomic_load_n(&f_metricsBlocks, __ATOMIC_ACQUIRE);
+
+    while ( block != NULL )
+    {
+        uint32_t expected = LOGGER_METRICS_STATE_FREE;
+
+        if ( __atomic_compare_exchange_n(&block->state, &expected, LOGGER_METRICS_STATE_OWNED, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) )
+        {
+            break;
+        }
+
+        block = block->next;
+    }
+
+    if ( block == NULL )
+    {
+        block = logger_mem_alloc(sizeof(LOGGER_METRICS_BLOCK));
+
+        if ( block == NULL )
+        {
+            LOGPRINT_LOG_E("Malloc failure !!!");
+            return NULL;
+        }
+
+        memset(block, 0, sizeof(LOGGER_METRICS_BLOCK));
+
+        block->state = LOGGER_METRICS_STATE_OWNED;
+        block->next = __atomic_load_n(&f_metricsBlocks, __ATOMIC_RELAXED);
+
+        while ( __atomic_compare_exchange_n(&f_metricsBlocks, &block->next, block, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED) == false )
+        {
+            /* block->next reloaded by the failed exchange */
+        }
+    }
+
+    pthread_setspecific(f_metricsKey, block);
+
+    f_threadBlock = block;
+
+    return block;
+}
+
+static LOGGER_METRICS_BLOCK * logger_metrics_threadBlock ( void )
+{
+    LOGGER_METRICS_BLOCK * block = f_threadBlock;
+
+    return ( block != NULL ) ? block : logger_metrics_acquire();
+}
+
+void logger_metrics_configureFromIni ( LOGGER_INI_SECTIONHANDLE paramBag )
+{
+    char *latencyStr = NULL;
+    size_t latencyStrLen = 0U;
+
+    logger_ini_sectionRetrieveValueFromKey(paramBag, "latency", strlen("latency"), &latencyStr, &latencyStrLen);
+
+    __atomic_store_n(&f_latencyEnabled, logger_string_isTrue(latencyStr, latencyStrLen), __ATOMIC_RELAXED);
+}
+
+static uint64_t logger_metrics_clockNs ( void )
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000U + (uint64_t)now.tv_nsec;
+}
+
+uint64_t logger_metrics_latencyStart ( void )
+{
+    return __atomic_load_n(&f_latencyEnabled, __ATOMIC_RELAXED) ? logger_metrics_clockNs() : 0U;
+}
+
+void logger_metrics_record ( LOGGER_LEVEL level )
+{
+    LOGGER_METRICS_BLOCK * block = logger_metrics_threadBlock();
+
+    if ( ( block != NULL ) && ( level != 0U ) )
+    {
+        uint32_t index = (uint32_t)__builtin_ctz((unsigned int)level);
+
+        if ( index < LOGGER_STATS_LEVELS )
+        {
+            LOGGER_METRICS_ADD(block->records[index], 1U);
+        }
+    }
+}
+
+void logger_metrics_filtered ( void )
+{
+    LOGGER_METRICS_BLOCK * block = logger_metrics_threadBlock();
+
+    if ( block != NULL )
+    {
+        LOGGER_METRICS_ADD(block->filtered, 1U);
+    }
+}
+
+void logger_metrics_rateLimited ( void )
+{
+    LOGGER_METRICS_BLOCK * block = logger_metrics_threadBlock();
+
+    if ( block != NULL )
+    {
+        LOGGER_METRICS_ADD(block->rateLimited, 1U);
+    }
+}
+
+void logger_metrics_deduplicated ( void )
+{
+    LOGGER_METRICS_BLOCK * block = logger_metrics_threadBlock();
+
+    if ( block != NULL )
+    {
+        LOGGER_METRICS_ADD(block->deduplicated, 1U);
+    }
+}
+
+void logger_metrics_truncated ( void )
+{
+    LOGGER_METRICS_BLOCK * block = logger_metrics_threadBlock();
+
+    if ( block != NULL )
+    {
+        LOGGER_METRICS_ADD(block->truncated, 1U);
+    }
+}
+
+void logger_metrics_dropped ( void )
+{
+    LOGGER_METRICS_BLOCK * block = logger_metrics_threadBlock();
+
+    if ( block != NULL )
+    {
+        LOGGER_METRICS_ADD(block->dropped, 1U);
+    }
+}
+
+void logger_metrics_output ( uint32_t output, size_t bytes, bool failed )
+{
+    LOGGER_METRICS_BLOCK * block = logger_metrics_threadBlock();
+
+    if ( ( block != NULL ) && ( output < LOGGER_STATS_OUTPUTS_MAX ) )
+    {
+        LOGGER_METRICS_ADD(block->outputRecords[output], 1U);
+        LOGGER_METRICS_ADD(block->outputBytes[output], bytes);
+
+        if ( failed )
+        {
+            LOGGER_METRICS_ADD(block->outputFailures[output], 1U);
+        }
+    }
+}
+
+void logger_metrics_latency ( uint64_t start )
+{
+    if ( start == 0U )
+    {
+        return;
+    }
+
+    LOGGER_METRICS_BLOCK * block = logger_metrics_threadBlock();
+
+    if ( block != NULL )
+    {
+        uint64_t elapsed = logger_metrics_clockNs() - start;
+
+        /* bucket of the highest set bit, so each bucket is twice as wide as the one before */
+        uint32_t index = ( elapsed != 0U ) ? 63U - (uint32_t)__builtin_clzll(elapsed) : 0U;
+
+        index = ( index < LOGGER_STATS_LATENCY_BUCKETS ) ? index : LOGGER_STATS_LATENCY_BUCKETS-1U;
+
+        LOGGER_METRICS_ADD(block->latency[index], 1U);
+    }
+}
+
+void logger_metrics_nameOutput ( uint32_t output, const char * name )
+{
+    if ( output < LOGGER_STATS_OUTPUTS_MAX )
+    {
+        __atomic_store_n(&f_outputNames[output], name, __ATOMIC_RELEASE);
+    }
+}
+
+void logger_metrics_snapshot ( LOGGER_STATS * stats )
+{
+    memset(stats, 0, sizeof(LOGGER_STATS));
+
+    for ( LOGGER_METRICS_BLOCK * block = __atomic_load_n(&f_metricsBlocks, __ATOMIC_ACQUIRE); block != NULL; block = block->next )
+    {
+        for ( uint32_t i=0U; i<LOGGER_STATS_LEVELS; i++ )
+        {
+            stats->records[i] += __atomic_load_n(&block->records[i], __ATOMIC_RELAXED);
+        }
+
+        stats->filtered += __atomic_load_n(&block->filtered, __ATOMIC_RELAXED);
+        stats->rateLimited += __atomic_load_n(&block->rateLimited, __ATOMIC_RELAXED);
+        stats->deduplicated += __atomic_load_n(&block->deduplicated, __ATOMIC_RELAXED);
+        stats->truncated += __atomic_load_n(&block->truncated, __ATOMIC_RELAXED);
+        stats->dropped += __atomic_load_n(&block->dropped, __ATOMIC_RELAXED);
+
+        for ( uint32_t i=0U; i<LOGGER_STATS_LATENCY_BUCKETS; i++ )
+        {
+            stats->latency[i] += __atomic_load_n(&block->latency[i], __ATOMIC_RELAXED);
+        }
+
+        for ( uint32_t i=0U; i<LOGGER_STATS_OUTPUTS_MAX; i++ )
+        {
+            stats->outputs[i].records += __atomic_load_n(&block->outputRecords[i], __ATOMIC_RELAXED);
+            stats->outputs[i].bytes += __atomic_load_n(&block->outputBytes[i], __ATOMIC_RELAXED);
+            stats->outputs[i].failures += __atomic_load_n(&block->outputFailures[i], __ATOMIC_RELAXED);
+        }
+    }
+
+    for ( uint32_t i=0U; i<LOGGER_STATS_OUTPUTS_MAX; i++ )
+    {
+        stats->outputs[i].name = __atomic_load_n(&f_outputNames[i], __ATOMIC_ACQUIRE);
+        stats->sendFailures += stats->outputs[i].failures;
+
+        if ( ( stats->outputs[i].name != NULL ) || ( stats->outputs[i].records != 0U ) )
+        {
+            stats->outputCount = i+1U;
+        }
+    }
+}
@@ -0,0 +1,118 @@
+/**
+ @file
+ Diagnostics print library - metrics
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#ifndef _LOGGER_METRICS_H
+#define _LOGGER_METRICS_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "logger.h"
+#include "logger_ini.h"
+
+
+/**
+ @brief configure from the [output=...] section key latency=
+ @details latency = true to time every print call into the #LOGGER_STATS latency histogram. Off by default, it
+ reads the clock twice per record. The other counters are always kept
+ @param[in] paramBag ini section handle
+ */
+void logger_metrics_configureFromIni ( LOGGER_INI_SECTIONHANDLE paramBag );
+
+
+/**
+ @brief read the monotonic clock when a print call begins, if latency= is on
+ @return nanoseconds from an arbitrary start, 0 without reading the clock when latency is off
+ */
+uint64_t logger_metrics_latencyStart ( void );
+
+
+/**
+ @brief count a record accepted for output
+ @param[in] level level of the record, a single bit
+ */
+void logger_metrics_record ( LOGGER_LEVEL level );
+
+
+/**
+ @brief count a print call whose level was disabled
+ */
+void logger_metrics_filtered ( void );
+
+
+/**
+ @brief count a record suppressed by its callsite's rate limit
+ */
+void logger_metrics_rateLimited ( void );
+
+
+/**
+ @brief count a repeat held back by the dedup table
+ */
+void logger_metrics_deduplicated ( void );
+
+
+/**
+ @brief count a record that was cut short
+ */
+void logger_metrics_truncated ( void );
+
+
+/**
+ @brief count a record dropped because the writer was behind
+ */
+void logger_metrics_dropped ( void );
+
+
+/**
+ @brief count a send to an output
+ @param[in] output plugin index
+ @param[in] bytes bytes handed to the plugin
+ @param[in] failed true when the plugin reported failure
+ */
+void logger_metrics_output ( uint32_t output, size_t bytes, bool failed );
+
+
+/**
+ @brief add a print call's wall time to the latency histogram
+ @param[in] start #logger_metrics_latencyStart when the call began, nothing is added for 0
+ */
+void logger_metrics_latency ( uint64_t start );
+
+
+/**
+ @brief name an output, so a snapshot reports it
+ @param[in] output plugin index
+ @param[in] name static plugin name
+ */
+void logger_metrics_nameOutput ( uint32_t output, const char * name );
+
+
+/**
+ @brief sum every thread's counters
+ @param[out] stats totals, memory usage is not filled
+ */
+void logger_metrics_snapshot ( LOGGER_STATS * stats );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _LOGGER_METRICS_H */
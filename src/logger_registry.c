@@ -0,0 +1,62 @@
+/**
+ @file
+ Diagnostics print library - handle registry
+ 
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#include <pthread.h>
+
+#include "logger_registry.h"
+
+
+/* handles created from a file name, newest first. Only init, term & reload take the lock, prints never do */
+static LOGGER_HANDLE_PRV * f_registryHandles = NULL;
+
+static pthread_mutex_t f_mutex_registry = PTHREAD_MUTEX_INITIALIZER;
+
+
+void logger_registry_add ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_REGISTRY_CONFIGURE configure )
+{
+    pthread_mutex_lock(&f_mutex_registry);
+    
+    (*configure)(handlePrv);
+    
+    handlePrv->registryNext = f_registryHandles;
+    f_registryHandles = handlePrv;
+    
+    pthread_mutex_unlock(&f_mutex_registry);
+}
+
+void logger_registry_remove ( LOGGER_HANDLE_PRV * handlePrv )
+{
+    pthread_mutex_lock(&f_mutex_registry);
+    
+    for ( LOGGER_HANDLE_PRV ** link = &f_registryHandles; *link != NULL; link = &(*link)->registryNext )
+    {
+        if ( *link == handlePrv )
+        {
+            *link = handlePrv->registryNext;
+            handlePrv->registryNext = NULL;
+            break;
+        }
+    }
+    
+    pthread_mutex_unlock(&f_mutex_registry);
+}
+
+void logger_registry_configureAll ( LOGGER_REGISTRY_CONFIGURE configure )
+{
+    pthread_mutex_lock(&f_mutex_registry);
+    
+    for ( LOGGER_HANDLE_PRV * handlePrv = f_registryHandles; handlePrv != NULL; handlePrv = handlePrv->registryNext )
+    {
+        (*configure)(handlePrv);
+    }
+    
+    pthread_mutex_unlock(&f_mutex_registry);
+}
@@ -0,0 +1,62 @@
+/**
+ @file
+ Diagnostics print library - handle registry
+ 
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#ifndef _LOGGER_REGISTRY_H
+#define _LOGGER_REGISTRY_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdint.h>
+
+#include "logger_common.h"
+
+
+/**
+ @brief set a handle's levels from the ini settings for its baseName
+ @details called with the registry locked & the ini settings held with #logger_ini_readBegin
+ */
+typedef void (*LOGGER_REGISTRY_CONFIGURE) ( LOGGER_HANDLE_PRV * handlePrv );
+
+
+/**
+ @brief configure a handle & add it to the live handles
+ @details both happen under the registry lock, so a reload running at the same time configures it after
+ @param[in] handlePrv handle with baseName set
+ @param[in] configure sets its levels
+ */
+void logger_registry_add ( LOGGER_HANDLE_PRV * handlePrv, LOGGER_REGISTRY_CONFIGURE configure );
+
+
+/**
+ @brief remove a handle before it is freed. Does nothing when it was never added
+ @param[in] handlePrv handle to remove
+ */
+void logger_registry_remove ( LOGGER_HANDLE_PRV * handlePrv );
+
+
+/**
+ @brief configure every live handle again, after the ini settings changed
+ @details printing threads are never blocked, each handle's levels change with one atomic store
+ @param[in] configure sets the levels of one handle
+ */
+void logger_registry_configureAll ( LOGGER_REGISTRY_CONFIGURE configure );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _LOGGER_REGISTRY_H */
@@ -0,0 +1,259 @@
+/**
+ @file
+ Diagnostics print library - bounded multi-producer record ring
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#include <string.h>
+
+#include "logger_ring.h"
+#include "logger_memory.h"
+#include "logger_metrics.h"
+
+
+/*
+ Each slot carries a sequence number. A producer may write slot (pos & mask) only once its
+ sequence equals pos, it may be read only once it equals pos+1. Producers claim a position
+ with a single compare-and-swap on enqueuePos, readers likewise on dequeuePos, so no lock is
+ ever taken & a producer evicting the oldest record cannot collide with the writer
+ */
+
+
+static LOGGER_RING_SLOT * logger_ring_claim ( LOGGER_RING * ring, LOGGER_LEVEL keepLevels );
+
+
+/* claim the oldest record, unless it has one of keepLevels */
+static LOGGER_RING_SLOT * logger_ring_claim ( LOGGER_RING * ring, LOGGER_LEVEL keepLevels )
+{
+    size_t pos = __atomic_load_n(&ring->dequeuePos, __ATOMIC_RELAXED);
+
+    for ( ;; )
+    {
+        LOGGER_RING_SLOT *slot = &ring->slots[pos & ring->mask];
+
+        size_t seq = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos+1U);
+
+        if ( dif == 0 )
+        {
+            /* the level may be rewritten under us, but then the claim below fails */
+            if ( ( __atomic_load_n(&slot->level, __ATOMIC_RELAXED) & keepLevels ) != 0U )
+            {
+                return NULL;
+            }
+
+            if ( __atomic_compare_exchange_n(&ring->dequeuePos, &pos, pos+1U, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+            {
+                return slot;
+            }
+            /* lost the race, pos now holds the current value */
+        }
+        else if ( dif < 0 )
+        {
+            /* empty */
+            return NULL;
+        }
+        else
+        {
+            pos = __atomic_load_n(&ring->dequeuePos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+
+bool logger_ring_create ( LOGGER_RING * ring, uint32_t slotCount )
+{
+    bool success = false;
+
+    if ( ring == NULL )
+    {
+        LOGPRINT_LOG_E("NULL ring passed to %s",__FUNCTION__);
+    }
+    else
+    {
+        size_t capacity = 2U;
+
+        while ( capacity < slotCount )
+        {
+            capacity <<= 1U;
+        }
+
+        ring->slots = logger_mem_alloc( sizeof(LOGGER_RING_SLOT) * capacity );
+
+        if ( ring->slots == NULL )
+        {
+            LOGPRINT_LOG_E("Malloc failure !!!");
+        }
+        else
+        {
+            for ( size_t i=0U; i<capacity; i++ )
+            {
+                ring->slots[i].sequence = i;
+                ring->slots[i].msgLen = 0U;
+                ring->slots[i].msgSpill = NULL;
+            }
+
+            ring->mask = capacity - 1U;
+            ring->enqueuePos = 0U;
+            ring->dequeuePos = 0U;
+
+            success = true;
+        }
+    }
+
+    return success;
+}
+
+void logger_ring_destroy ( LOGGER_RING * ring )
+{
+    if ( ring )
+    {
+        for ( size_t i=0U; ( ring->slots != NULL ) && ( i<=ring->mask ); i++ )
+        {
+            logger_mem_free(ring->slots[i].msgSpill);
+        }
+
+        logger_mem_free(ring->slots);
+        ring->slots = NULL;
+        ring->mask = 0U;
+    }
+}
+
+bool logger_ring_push ( LOGGER_RING * ring, const LOGGER_RECORD * record )
+{
+    LOGGER_RING_SLOT *slot = NULL;
+    size_t pos = __atomic_load_n(&ring->enqueuePos, __ATOMIC_RELAXED);
+
+    for ( ;; )
+    {
+        slot = &ring->slots[pos & ring->mask];
+
+        size_t seq = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+
+        if ( dif == 0 )
+        {
+            if ( __atomic_compare_exchange_n(&ring->enqueuePos, &pos, pos+1U, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+            {
+                break;
+            }
+            /* lost the race, pos now holds the current value */
+        }
+        else if ( dif < 0 )
+        {
+            /* consumer has not released this slot yet */
+            return false;
+        }
+        else
+        {
+            pos = __atomic_load_n(&ring->enqueuePos, __ATOMIC_RELAXED);
+        }
+    }
+
+    size_t msgLen = record->messageLen;
+    size_t fieldsLen = record->fieldsLen;
+    char * msg = slot->msg;
+
+    if ( msgLen+fieldsLen > sizeof(slot->msg)-1U )
+    {
+        /* rare & long anyway, the copy dominates the allocation */
+        slot->msgSpill = logger_mem_alloc(msgLen+fieldsLen+1U);
+
+        if ( slot->msgSpill != NULL )
+        {
+            msg = slot->msgSpill;
+        }
+        else
+        {
+            LOGPRINT_LOG_E("Malloc failure !!!");
+            
+            /* a partial field would not decode, keep the message only */
+            msgLen = ( msgLen < sizeof(slot->msg)-1U ) ? msgLen : sizeof(slot->msg)-1U;
+            fieldsLen = 0U;
+            
+            logger_metrics_truncated();
+        }
+    }
+
+    memcpy(msg, record->message, msgLen);
+
+    if ( fieldsLen != 0U )
+    {
+        memcpy(&msg[msgLen], record->fields, fieldsLen);
+    }
+
+    msg[msgLen+fieldsLen] = '\0';
+    slot->msgLen = msgLen;
+    slot->fieldsLen = fieldsLen;
+    slot->header = record->header;
+    slot->headerLen = record->headerLen;
+    slot->ticks = record->ticks;
+    slot->outputs = record->outputs;
+    __atomic_store_n(&slot->level, record->level, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&slot->sequence, pos+1U, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+LOGGER_RING_SLOT * logger_ring_peek ( LOGGER_RING * ring )
+{
+    return logger_ring_claim(ring, LOGGER_LEVEL_NONE);
+}
+
+bool logger_ring_evict ( LOGGER_RING * ring, LOGGER_LEVEL keepLevels )
+{
+    LOGGER_RING_SLOT *slot = logger_ring_claim(ring, keepLevels);
+
+    if ( slot != NULL )
+    {
+        logger_ring_release(ring, slot);
+    }
+
+    return ( slot != NULL );
+}
+
+size_t logger_ring_used ( const LOGGER_RING * ring )
+{
+    size_t dequeuePos = __atomic_load_n(&ring->dequeuePos, __ATOMIC_RELAXED);
+    size_t enqueuePos = __atomic_load_n(&ring->enqueuePos, __ATOMIC_RELAXED);
+    size_t used = enqueuePos - dequeuePos;
+
+    /* the two loads are not taken together, records popped & pushed in between can overstate it */
+    return ( used <= ring->mask+1U ) ? used : ring->mask+1U;
+}
+
+size_t logger_ring_capacity ( const LOGGER_RING * ring )
+{
+    return ring->mask+1U;
+}
+
+const char * logger_ring_message ( const LOGGER_RING_SLOT * slot )
+{
+    return ( slot->msgSpill != NULL ) ? slot->msgSpill : slot->msg;
+}
+
+void logger_ring_release ( LOGGER_RING * ring, LOGGER_RING_SLOT * slot )
+{
+    if ( slot->msgSpill != NULL )
+    {
+        logger_mem_free(slot->msgSpill);
+        slot->msgSpill = NULL;
+    }
+
+    /* claimed at sequence-1, free for the producer one lap on */
+    __atomic_store_n(&slot->sequence, slot->sequence+ring->mask, __ATOMIC_RELEASE);
+}
+
+void logger_ring_abandon ( LOGGER_RING * ring, LOGGER_RING_SLOT * slot )
+{
+    /* a spill cannot be freed from a signal handler, it is left for the process exit */
+    slot->msgSpill = NULL;
+
+    logger_ring_release(ring, slot);
+}
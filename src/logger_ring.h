@@ -0,0 +1,167 @@
+/**
+ @file
+ Diagnostics print library - bounded multi-producer record ring
+
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#ifndef _LOGGER_RING_H
+#define _LOGGER_RING_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "logger_common.h"
+#include "logger_messageAssemble.h"
+
+
+/**
+ @def LOGGER_RING_DEFAULT_SLOTS
+ @brief number of records the ring holds when the ini does not specify one. Always rounded up to a power of two
+ */
+#define LOGGER_RING_DEFAULT_SLOTS (1024U)
+
+
+/* keep producer & consumer positions on separate cache lines */
+#define LOGGER_CACHELINE_SIZE (64U)
+
+
+/**
+ @brief one record waiting for the writer thread
+ @details sequence is owned by the ring & must not be touched by callers. Only the message is copied, header
+ still points at the static header of the callsite. Encoded fields are copied straight after the message. A
+ record too long for msg is copied to the heap instead, use #logger_ring_message to read either
+ */
+typedef struct _LOGGER_RING_SLOT
+{
+    size_t sequence;
+    LOGGER_TICKS ticks;
+    LOGGER_LEVEL level;
+    uint32_t outputs;   /* as #LOGGER_RECORD outputs */
+    const char * header;
+    size_t headerLen;
+    size_t msgLen;      /* chars in the message */
+    size_t fieldsLen;   /* bytes of encoded fields following the message */
+    char * msgSpill;    /* heap copy of a record longer than msg, freed on release */
+    char msg[LOGGER_MAX_LOGGER_CHARS];
+} LOGGER_RING_SLOT;
+
+
+/**
+ @brief bounded lock-free ring. Any number of threads may push. One writer thread pops, producers may also discard
+ the oldest record to make room, see #logger_ring_evict
+ */
+typedef struct _LOGGER_RING
+{
+    LOGGER_RING_SLOT *slots;
+    size_t mask;
+    char pad0[LOGGER_CACHELINE_SIZE];
+    size_t enqueuePos;  /* shared by all producers */
+    char pad1[LOGGER_CACHELINE_SIZE];
+    size_t dequeuePos;  /* claimed by the writer, or by a producer evicting */
+} LOGGER_RING;
+
+
+/**
+ @brief allocate the ring storage
+ @param[out] ring ring to set up
+ @param[in] slotCount requested number of records. Rounded up to a power of two
+ @return #true on success
+ */
+bool logger_ring_create ( LOGGER_RING * ring, uint32_t slotCount );
+
+
+/**
+ @brief release the ring storage. Any records still queued are discarded
+ @param[in] ring ring to destroy
+ */
+void logger_ring_destroy ( LOGGER_RING * ring );
+
+
+/**
+ @brief copy a record into the ring
+ @details safe to call from any number of threads concurrently. Costs one compare-and-swap plus the copy
+ @param[in] ring ring to push to
+ @param[in] record record to copy. Only messages that do not fit a slot cost an allocation
+ @return #false if the ring is full
+ */
+bool logger_ring_push ( LOGGER_RING * ring, const LOGGER_RECORD * record );
+
+
+/**
+ @brief take the oldest record in the ring
+ @details the slot is claimed, no other thread sees it again. Call #logger_ring_release once done with the slot
+ @param[in] ring ring to peek
+ @return NULL if the ring is empty
+ */
+LOGGER_RING_SLOT * logger_ring_peek ( LOGGER_RING * ring );
+
+
+/**
+ @brief discard the oldest record to make room
+ @param[in] ring ring to evict from
+ @param[in] keepLevels levels that are never discarded. The oldest record is left alone when it has one
+ @return #true if a record was discarded
+ */
+bool logger_ring_evict ( LOGGER_RING * ring, LOGGER_LEVEL keepLevels );
+
+
+/**
+ @brief number of records queued
+ @details a snapshot, other threads may push or pop at any time
+ @param[in] ring ring to measure
+ @return records waiting, never more than #logger_ring_capacity
+ */
+size_t logger_ring_used ( const LOGGER_RING * ring );
+
+
+/**
+ @brief number of records the ring holds
+ @param[in] ring ring to measure
+ @return slots in the ring
+ */
+size_t logger_ring_capacity ( const LOGGER_RING * ring );
+
+
+/**
+ @brief get the message held by a slot
+ @param[in] slot slot returned by #logger_ring_peek
+ @return NULL terminated message of slot->msgLen chars
+ */
+const char * logger_ring_message ( const LOGGER_RING_SLOT * slot );
+
+
+/**
+ @brief hand the slot returned from #logger_ring_peek back to the producers
+ @param[in] ring ring the slot belongs to
+ @param[in] slot slot returned by #logger_ring_peek
+ */
+void logger_ring_release ( LOGGER_RING * ring, LOGGER_RING_SLOT * slot );
+
+
+/**
+ @brief hand a slot back from a signal handler, async-signal-safe
+ @details as #logger_ring_release, except a heap copy of a long record is not freed
+ @param[in] ring ring the slot belongs to
+ @param[in] slot slot returned by #logger_ring_peek
+ */
+void logger_ring_abandon ( LOGGER_RING * ring, LOGGER_RING_SLOT * slot );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _LOGGER_RING_H */
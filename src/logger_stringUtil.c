@@ -11,8 +11,10 @@
 
 #include <stdint.h>
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <stdbool.h>
 
 
 #ifdef _WIN32
@@ -144,3 +146,23 @@ uint32_t logger_string_numberOfOccurencesOfChar ( const char* str, size_t strLen
     
     return matchCount;
 }
+
+bool logger_string_isTrue ( const char* str, size_t strLen )
+{
+    static const char * trueValues[] = { "true", "yes", "on", "1" };
+    bool isTrue = false;
+
+    if ( str != NULL )
+    {
+        for ( uint32_t i=0U; i<sizeof(trueValues)/sizeof(trueValues[0]); i++ )
+        {
+            if ( ( strlen(trueValues[i]) == strLen ) && ( strncasecmp(trueValues[i], str, strLen) == 0 ) )
+            {
+                isTrue = true;
+                break;
+            }
+        }
+    }
+
+    return isTrue;
+}
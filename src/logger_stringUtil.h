@@ -18,6 +18,11 @@ extern "C" {
 #endif
 
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
 /**
  @brief Retrieve just the filename from the full filepath (unix shell equivalent 'basename')
  @detail returned parameter #stringFileNameReturned does not contain a new refrence but simply a pointer within the char array provided w/o whitespaces
@@ -68,6 +73,14 @@ char* logger_string_findFirstOccurenceOfChar ( const char* str, const char searc
 uint32_t logger_string_numberOfOccurencesOfChar ( const char* str, size_t strLen, const char searchChar );
 
 
+/** Interpret an ini value as a boolean switch
+ @param[in] str value to test ("true", "yes", "on" or "1" in any case)
+ @param[in] strLen string length of above param
+ @return #true if the value switches the option on
+ */
+bool logger_string_isTrue ( const char* str, size_t strLen );
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -12,29 +12,44 @@
 #include <stdio.h>
 #include <string.h>
 #include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "logger_pluginFile.h"
+#include "logger_pluginStream.h"
+#include "logger_memory.h"
+#include "logger_initTerm.h"
 
 
-static pthread_mutex_t f_mutex_print = PTHREAD_MUTEX_INITIALIZER;
+#define FILE_INVALID -1
 
-static FILE * f_logger_file = NULL;
+/* records sent inline by the logging thread are gathered into this much before a write, as stdio did */
+#define LOGGER_FILE_BUFFER_SIZE (8192U)
+
+/** one [output=file] section, each file written under its own lock */
+typedef struct _LOGGER_FILE_INSTANCE
+{
+    pthread_mutex_t mutex_print;
+    int file;
+    size_t used; /* chars of buffer not yet written */
+    char buffer[LOGGER_FILE_BUFFER_SIZE];
+} LOGGER_FILE_INSTANCE;
+
+
+static LOGGER_STATUS logger_file_flush ( LOGGER_FILE_INSTANCE * fileInstance );
 
 
-LOGGER_STATUS logger_file_initialize ( LOGGER_INI_SECTIONHANDLE paramBag )
+LOGGER_STATUS logger_file_initialize ( LOGGER_INI_SECTIONHANDLE paramBag, void ** instance )
 {
     LOGGER_STATUS status = LOGGER_STATUS_FAILURE_INVALID_MESSAGE;
     
+    *instance = NULL;
+    
     if ( paramBag == NULL )
     {
         status = LOGGER_STATUS_FAILURE_INVALID_PARAM;
         LOGPRINT_LOG_E("NULL param to : %s",__FUNCTION__);
     }
-    else if ( f_logger_file != NULL )
-    {
-        status = LOGGER_STATUS_FAILURE_ALREADY_INITIALIZED;
-        LOGPRINT_LOG_E("already initialized (%s)",__FUNCTION__);        
-    }
     else
     {
         char *filePath = NULL;
@@ -44,16 +59,29 @@ LOGGER_STATUS logger_file_initialize ( LOGGER_INI_SECTIONHANDLE paramBag )
 
         if ( filePath )
         {
-            f_logger_file = fopen(filePath, "w");
+            LOGGER_FILE_INSTANCE * fileInstance = logger_mem_alloc(sizeof(LOGGER_FILE_INSTANCE));
             
-            if ( f_logger_file != NULL )
+            if ( fileInstance == NULL )
             {
+                LOGPRINT_LOG_E("Malloc failure !!!");
+                return status;
+            }
+            
+            fileInstance->used = 0U;
+            fileInstance->file = open(filePath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            
+            if ( fileInstance->file != FILE_INVALID )
+            {
+                pthread_mutex_init(&fileInstance->mutex_print, NULL);
+                *instance = fileInstance;
+                
                 status = LOGGER_STATUS_OK;
-                LOGPRINT_LOG_I("Set output to file (%s",parambag->filePath);
+                LOGPRINT_LOG_I("Set output to file (%s",filePath);
             }
             else
             {
-                LOGPRINT_LOG_E("Failed to open: %s",parambag->filePath);
+                LOGPRINT_LOG_E("Failed to open: %s",filePath);
+                logger_mem_free(fileInstance);
             }
         }
         else
@@ -66,56 +94,123 @@ LOGGER_STATUS logger_file_initialize ( LOGGER_INI_SECTIONHANDLE paramBag )
     return status;
 }
 
-LOGGER_STATUS logger_file_terminate ( void )
+LOGGER_STATUS logger_file_terminate ( void * instance )
 {
     LOGGER_STATUS status = LOGGER_STATUS_FAILURE_INVALID_MESSAGE;
+    LOGGER_FILE_INSTANCE * fileInstance = (LOGGER_FILE_INSTANCE *)instance;
     
-    if ( f_logger_file == NULL )
+    if ( fileInstance == NULL )
     {
         LOGPRINT_LOG_I("already terminated (%s)",__FUNCTION__);
         status = LOGGER_STATUS_FAILURE_ALREADY_TERMINATED;
     }
-    else if ( fclose(f_logger_file) != 0 )
-    {
-        LOGPRINT_LOG_E("Error closing file");
-    }
     else
     {
-        f_logger_file = NULL;
-        LOGPRINT_LOG_I("Terminated: file");
-        status = LOGGER_STATUS_OK;
+        (void)logger_file_flush(fileInstance);
+        
+        if ( close(fileInstance->file) != 0 )
+        {
+            LOGPRINT_LOG_E("Error closing file");
+        }
+        else
+        {
+            LOGPRINT_LOG_I("Terminated: file");
+            status = LOGGER_STATUS_OK;
+        }
+        
+        pthread_mutex_destroy(&fileInstance->mutex_print);
+        logger_mem_free(fileInstance);
     }
     
     return status;
 }
 
-LOGGER_STATUS logger_file_transmit ( char * msg, size_t msgLen )
+LOGGER_STATUS logger_file_transmitv ( void * instance, const struct iovec * segments, int segmentCount )
 {
     LOGGER_STATUS status = LOGGER_STATUS_FAILURE_INVALID_MESSAGE;
+    LOGGER_FILE_INSTANCE * fileInstance = (LOGGER_FILE_INSTANCE *)instance;
     
-    LOGPRINT_ASSERT(f_logger_file!=NULL);
-    LOGPRINT_ASSERT(msg!=NULL);
-    LOGPRINT_ASSERT(msgLen!=0U);    
+    LOGPRINT_ASSERT(fileInstance!=NULL);
+    LOGPRINT_ASSERT(segments!=NULL);
     
-    pthread_mutex_lock( &f_mutex_print );
+    size_t recordLen = 1U; /* line terminator */
     
-    int charsPrinted = fprintf(f_logger_file, "%s\n",msg);
+    for ( int i=0; i<segmentCount; i++ )
+    {
+        recordLen += segments[i].iov_len;
+    }
     
-    pthread_mutex_unlock( &f_mutex_print );
-
-    if ( charsPrinted >= msgLen )
+    pthread_mutex_lock( &fileInstance->mutex_print );
+    
+    /* behind a sender thread a syscall per record costs the caller nothing, inline it is batched */
+    if ( logger_async_isEnabled() || ( recordLen > sizeof(fileInstance->buffer) ) )
     {
-        status = LOGGER_STATUS_OK;
+        status = logger_file_flush(fileInstance);
+        
+        if ( status == LOGGER_STATUS_OK )
+        {
+            status = logger_stream_writeRecord(fileInstance->file, segments, segmentCount);
+        }
     }
     else
     {
-        LOGPRINT_LOG_E("Failed to write whole message. Only %d/%d printed",charsPrinted,msgLen);
+        status = LOGGER_STATUS_OK;
+        
+        if ( recordLen > sizeof(fileInstance->buffer) - fileInstance->used )
+        {
+            status = logger_file_flush(fileInstance);
+        }
+        
+        for ( int i=0; i<segmentCount; i++ )
+        {
+            memcpy(&fileInstance->buffer[fileInstance->used], segments[i].iov_base, segments[i].iov_len);
+            fileInstance->used += segments[i].iov_len;
+        }
+        
+        fileInstance->buffer[fileInstance->used] = '\n';
+        fileInstance->used += 1U;
     }
+    
+    pthread_mutex_unlock( &fileInstance->mutex_print );
 
     return status;
 }
 
+LOGGER_STATUS logger_file_crashv ( void * instance, const struct iovec * segments, int segmentCount )
+{
+    /* no mutex, it may be held by the thread that crashed. Buffered records are older so go first */
+    LOGGER_FILE_INSTANCE * fileInstance = (LOGGER_FILE_INSTANCE *)instance;
+    
+    if ( fileInstance == NULL )
+    {
+        return LOGGER_STATUS_FAILURE;
+    }
+    
+    size_t used = fileInstance->used;
+    
+    fileInstance->used = 0U;
+    
+    (void)logger_stream_writeAll(fileInstance->file, fileInstance->buffer, used);
+    
+    return logger_stream_writeRecordCrash(fileInstance->file, segments, segmentCount);
+}
+
 char* logger_file_name ( void )
 {
     return "file";
 }
+
+/* caller holds mutex_print, or is the only thread left */
+static LOGGER_STATUS logger_file_flush ( LOGGER_FILE_INSTANCE * fileInstance )
+{
+    LOGGER_STATUS status = logger_stream_writeAll(fileInstance->file, fileInstance->buffer, fileInstance->used);
+    
+    if ( status != LOGGER_STATUS_OK )
+    {
+        LOGPRINT_LOG_E("Error writing file");
+    }
+    
+    fileInstance->used = 0U;
+    
+    return status;
+}
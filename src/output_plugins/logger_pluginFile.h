@@ -22,9 +22,10 @@ extern "C" {
 #include "logger_common.h"
 
 
-LOGGER_STATUS logger_file_initialize ( LOGGER_INI_SECTIONHANDLE paramBag );
-LOGGER_STATUS logger_file_terminate ( void );
-LOGGER_STATUS logger_file_transmit ( char * msg, size_t msgLen );
+LOGGER_STATUS logger_file_initialize ( LOGGER_INI_SECTIONHANDLE paramBag, void ** instance );
+LOGGER_STATUS logger_file_terminate ( void * instance );
+LOGGER_STATUS logger_file_transmitv ( void * instance, const struct iovec * segments, int segmentCount );
+LOGGER_STATUS logger_file_crashv ( void * instance, const struct iovec * segments, int segmentCount );
 char* logger_file_name ( void );
     
     
@@ -9,43 +9,57 @@
  */
 
 
+/* fileno */
+#define _POSIX_C_SOURCE 200809L
+
 #include <pthread.h>
 #include <stdio.h>
+#include <unistd.h>
 
-#include "logger_PluginStdout.h"
+#include "logger_pluginStdout.h"
+#include "logger_pluginStream.h"
+#include "logger_memory.h"
 
 
+/* every instance writes the one process stdout, so they share its lock */
 static pthread_mutex_t f_mutex_print = PTHREAD_MUTEX_INITIALIZER;
 
-static FILE * f_logger_stdout = NULL;
+/** one [output=stdout] section */
+typedef struct _LOGGER_STDOUT_INSTANCE
+{
+    FILE * stream;
+} LOGGER_STDOUT_INSTANCE;
 
 
-LOGGER_STATUS logger_stdout_initialize ( LOGGER_INI_SECTIONHANDLE paramBag )
+LOGGER_STATUS logger_stdout_initialize ( LOGGER_INI_SECTIONHANDLE paramBag, void ** instance )
 {
     LOGGER_STATUS status = LOGGER_STATUS_FAILURE_INVALID_MESSAGE;
+    LOGGER_STDOUT_INSTANCE * stdoutInstance = logger_mem_alloc(sizeof(LOGGER_STDOUT_INSTANCE));
     
-    if ( f_logger_stdout == NULL )
+    *instance = NULL;
+    
+    if ( stdoutInstance != NULL )
     {
-        f_logger_stdout = stdout;
+        stdoutInstance->stream = stdout;
+        *instance = stdoutInstance;
         LOGPRINT_LOG_I("Set output to stdout");
         status = LOGGER_STATUS_OK;
     }
     else
     {
-        LOGPRINT_LOG_E("already initialized (%s)");
-        status = LOGGER_STATUS_FAILURE_ALREADY_INITIALIZED;
+        LOGPRINT_LOG_E("Malloc failure !!!");
     }
 
     return status;
 }
 
-LOGGER_STATUS logger_stdout_terminate ( void )
+LOGGER_STATUS logger_stdout_terminate ( void * instance )
 {
     LOGGER_STATUS status = LOGGER_STATUS_FAILURE;
     
-    if ( f_logger_stdout )
+    if ( instance )
     {
-        f_logger_stdout = NULL;
+        logger_mem_free(instance);
         LOGPRINT_LOG_I("Disabled output from stdout");
         status = LOGGER_STATUS_OK;
     }
@@ -58,32 +72,32 @@ LOGGER_STATUS logger_stdout_terminate ( void )
     return status;
 }
 
-LOGGER_STATUS logger_stdout_transmit ( char * msg, size_t msgLen )
+LOGGER_STATUS logger_stdout_transmitv ( void * instance, const struct iovec * segments, int segmentCount )
 {
     LOGGER_STATUS status = LOGGER_STATUS_FAILURE_INVALID_MESSAGE;
+    LOGGER_STDOUT_INSTANCE * stdoutInstance = (LOGGER_STDOUT_INSTANCE *)instance;
     
-    LOGPRINT_ASSERT(f_logger_stdout!=NULL);
-    LOGPRINT_ASSERT(msg!=NULL);
-    LOGPRINT_ASSERT(msgLen!=0U);    
+    LOGPRINT_ASSERT(stdoutInstance!=NULL);
+    LOGPRINT_ASSERT(segments!=NULL);
     
     pthread_mutex_lock( &f_mutex_print );
 
-    int charsPrinted = fprintf(f_logger_stdout, "%s\n",msg);
+    /* anything the application printed through stdio goes out first, keeping the order */
+    fflush(stdoutInstance->stream);
+    
+    status = logger_stream_writeRecord(fileno(stdoutInstance->stream), segments, segmentCount);
 
     pthread_mutex_unlock( &f_mutex_print );
-
-    if ( charsPrinted >= msgLen )
-    {
-        status = LOGGER_STATUS_OK;
-    }
-    else
-    {
-        LOGPRINT_LOG_E("Failed to print whole message. Only %d/%d printed",charsPrinted,msgLen);
-    }
     
     return status;
 }
 
+LOGGER_STATUS logger_stdout_crashv ( void * instance, const struct iovec * segments, int segmentCount )
+{
+    /* no mutex or fflush, either may be mid use by the thread that crashed */
+    return ( instance != NULL ) ? logger_stream_writeRecordCrash(STDOUT_FILENO, segments, segmentCount) : LOGGER_STATUS_FAILURE;
+}
+
 char* logger_stdout_name ( void )
 {
     return "stdout";
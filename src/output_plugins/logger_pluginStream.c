@@ -0,0 +1,136 @@
+/**
+ @file
+ Diagnostics print library - stream plugin helpers
+ 
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell 
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "logger_pluginStream.h"
+
+
+static char f_lineTerminator[] = "\n";
+
+
+LOGGER_STATUS logger_stream_writeRecord ( int fd, const struct iovec * segments, int segmentCount )
+{
+    LOGGER_STATUS status = LOGGER_STATUS_OK;
+    struct iovec iov[LOGGER_TEMPLATE_SEGMENTS_MAX+1];
+    int iovCount = 0;
+    size_t remaining = 0U;
+    
+    LOGPRINT_ASSERT(segmentCount<=LOGGER_TEMPLATE_SEGMENTS_MAX);
+    
+    for ( int i=0; ( i<segmentCount ) && ( i<LOGGER_TEMPLATE_SEGMENTS_MAX ); i++ )
+    {
+        if ( segments[i].iov_len != 0U )
+        {
+            iov[iovCount] = segments[i];
+            remaining += segments[i].iov_len;
+            iovCount += 1;
+        }
+    }
+    
+    iov[iovCount].iov_base = f_lineTerminator;
+    iov[iovCount].iov_len = 1U;
+    remaining += 1U;
+    iovCount += 1;
+    
+    struct iovec * next = iov;
+    
+    while ( remaining != 0U )
+    {
+        ssize_t written = writev(fd, next, iovCount);
+        
+        if ( written < 0 )
+        {
+            if ( errno == EINTR )
+            {
+                continue;
+            }
+            
+            LOGPRINT_LOG_E("Failed to write whole message. %u chars left",(unsigned)remaining);
+            status = LOGGER_STATUS_FAILURE;
+            break;
+        }
+        
+        remaining -= (size_t)written;
+        
+        /* short write, skip what went out & continue mid segment */
+        while ( ( iovCount > 0 ) && ( (size_t)written >= next->iov_len ) )
+        {
+            written -= (ssize_t)next->iov_len;
+            next++;
+            iovCount -= 1;
+        }
+        
+        if ( iovCount > 0 )
+        {
+            next->iov_base = (char *)next->iov_base + written;
+            next->iov_len -= (size_t)written;
+        }
+    }
+    
+    return status;
+}
+
+LOGGER_STATUS logger_stream_writeRecordCrash ( int fd, const struct iovec * segments, int segmentCount )
+{
+    char line[LOGGER_STREAM_CRASH_LINE];
+    size_t lineLen = 0U;
+    
+    /* nothing to send, only asked to write out what the plugin holds */
+    if ( segmentCount == 0 )
+    {
+        return LOGGER_STATUS_OK;
+    }
+    
+    for ( int i=0; ( i<segmentCount ) && ( i<LOGGER_TEMPLATE_SEGMENTS_MAX ); i++ )
+    {
+        size_t copyLen = segments[i].iov_len;
+        
+        if ( copyLen > sizeof(line) - 1U - lineLen )
+        {
+            copyLen = sizeof(line) - 1U - lineLen;
+        }
+        
+        memcpy(&line[lineLen], segments[i].iov_base, copyLen);
+        lineLen += copyLen;
+    }
+    
+    line[lineLen] = f_lineTerminator[0];
+    lineLen += 1U;
+    
+    return logger_stream_writeAll(fd, line, lineLen);
+}
+
+LOGGER_STATUS logger_stream_writeAll ( int fd, const char * data, size_t dataLen )
+{
+    for ( size_t done = 0U; done < dataLen; )
+    {
+        ssize_t written = write(fd, &data[done], dataLen - done);
+        
+        if ( written < 0 )
+        {
+            if ( errno == EINTR )
+            {
+                continue;
+            }
+            
+            return LOGGER_STATUS_FAILURE;
+        }
+        
+        done += (size_t)written;
+    }
+    
+    return LOGGER_STATUS_OK;
+}
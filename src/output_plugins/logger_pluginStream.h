@@ -0,0 +1,71 @@
+/**
+ @file
+ Diagnostics print library - stream plugin helpers
+ 
+ @author Ryan Powell
+ @date 03-10-11
+ @copyright Copyright (c) 2011  Ryan Powell 
+ @licence http://www.opensource.org/licenses/BSD-3-Clause
+ */
+
+
+#ifndef _LOGGER_PLUGINSTREAM_H
+#define _LOGGER_PLUGINSTREAM_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include "logger_template.h"
+#include "logger_common.h"
+
+
+/**
+ @def LOGGER_STREAM_CRASH_LINE
+ @brief longest line written by #logger_stream_writeRecordCrash, terminator included
+ */
+#define LOGGER_STREAM_CRASH_LINE (2048U)
+
+
+/**
+ @brief write one record & its line terminator to a file descriptor with a single writev
+ @details short writes are continued from where they stopped, callers serialise access to fd
+ @param[in] fd descriptor to write to
+ @param[in] segments record segments in output order
+ @param[in] segmentCount number of segments, at most #LOGGER_TEMPLATE_SEGMENTS_MAX
+ @return LOGGER_STATUS_OK once every char is written
+ */
+LOGGER_STATUS logger_stream_writeRecord ( int fd, const struct iovec * segments, int segmentCount );
+
+
+/**
+ @brief write one record & its line terminator to a file descriptor from a signal handler
+ @details async-signal-safe. The segments are joined on the stack & written with write(), a record longer than
+ #LOGGER_STREAM_CRASH_LINE is cut short. Errors are returned, not logged. No segments writes nothing
+ @param[in] fd descriptor to write to
+ @param[in] segments record segments in output order
+ @param[in] segmentCount number of segments, at most #LOGGER_TEMPLATE_SEGMENTS_MAX
+ @return LOGGER_STATUS_OK once every char is written
+ */
+LOGGER_STATUS logger_stream_writeRecordCrash ( int fd, const struct iovec * segments, int segmentCount );
+
+
+/**
+ @brief write a run of chars to a file descriptor, continuing short writes
+ @details async-signal-safe, errors are returned, not logged
+ @param[in] fd descriptor to write to
+ @param[in] data chars to write
+ @param[in] dataLen number of chars
+ @return LOGGER_STATUS_OK once every char is written
+ */
+LOGGER_STATUS logger_stream_writeAll ( int fd, const char * data, size_t dataLen );
+    
+    
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _LOGGER_PLUGINSTREAM_H */
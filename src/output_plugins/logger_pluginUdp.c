@@ -9,6 +9,9 @@
  */
 
 
+/* inet_aton */
+#define _DEFAULT_SOURCE
+
 #include "logger_pluginUdp.h"
 #include <stdbool.h>
 #include <pthread.h>
@@ -20,14 +23,20 @@
 #include <unistd.h>         /* udp */
 #include <ctype.h>          /* for isdigit() */
 
+#include "logger_memory.h"
+
 
 #define BUFLEN 32
 #define NPACK 10
 #define SOCKET_INVALID -1
 
-static pthread_mutex_t f_mutex_print = PTHREAD_MUTEX_INITIALIZER;
-static int f_logger_udp = SOCKET_INVALID;
-static struct sockaddr_in f_logger_udp_sockaddr;
+/** one [output=udp] section, its own socket & destination */
+typedef struct _LOGGER_UDP_INSTANCE
+{
+    pthread_mutex_t mutex_print;
+    int udp;
+    struct sockaddr_in udp_sockaddr;
+} LOGGER_UDP_INSTANCE;
 
 static bool logger_udp_validateIpString ( char * ipAddrStr, size_t ipAddrStrLen );
 
@@ -73,10 +82,12 @@ static bool logger_udp_validateIpString ( char * ipAddrStr, size_t ipAddrStrLen
     return isValidIpAddr;
 }
 
-LOGGER_STATUS logger_udp_initialize ( LOGGER_INI_SECTIONHANDLE paramBag )
+LOGGER_STATUS logger_udp_initialize ( LOGGER_INI_SECTIONHANDLE paramBag, void ** instance )
 {
     LOGGER_STATUS status = LOGGER_STATUS_FAILURE;
     
+    *instance = NULL;
+    
     char *ipAddress = NULL;
     size_t ipAddressLen = 0U;
     char *portStr = NULL;
@@ -101,18 +112,26 @@ LOGGER_STATUS logger_udp_initialize ( LOGGER_INI_SECTIONHANDLE paramBag )
         }
         else
         {
-            memset((char *) &f_logger_udp_sockaddr, 0, sizeof(f_logger_udp_sockaddr));
-            f_logger_udp_sockaddr.sin_family = AF_INET;
-            f_logger_udp_sockaddr.sin_port = htons((uint16_t)portInt);
+            LOGGER_UDP_INSTANCE * udpInstance = logger_mem_alloc(sizeof(LOGGER_UDP_INSTANCE));
+            
+            if ( udpInstance == NULL )
+            {
+                LOGPRINT_LOG_E("Malloc failure !!!");
+                return status;
+            }
             
-            f_logger_udp=socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+            memset((char *) &udpInstance->udp_sockaddr, 0, sizeof(udpInstance->udp_sockaddr));
+            udpInstance->udp_sockaddr.sin_family = AF_INET;
+            udpInstance->udp_sockaddr.sin_port = htons((uint16_t)portInt);
             
-            if ( f_logger_udp == SOCKET_INVALID )
+            udpInstance->udp=socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+            
+            if ( udpInstance->udp == SOCKET_INVALID )
             {
                 LOGPRINT_LOG_E("socket() failed");
             }
             
-            else if (inet_aton(ipAddress, &f_logger_udp_sockaddr.sin_addr)==0)
+            else if (inet_aton(ipAddress, &udpInstance->udp_sockaddr.sin_addr)==0)
             {
                 LOGPRINT_LOG_E("inet_aton() failed\n");
             }
@@ -122,6 +141,21 @@ LOGGER_STATUS logger_udp_initialize ( LOGGER_INI_SECTIONHANDLE paramBag )
                 LOGPRINT_LOG_I("Set output to udp");
                 status = LOGGER_STATUS_OK;
             }
+            
+            if ( status == LOGGER_STATUS_OK )
+            {
+                pthread_mutex_init(&udpInstance->mutex_print, NULL);
+                *instance = udpInstance;
+            }
+            else
+            {
+                if ( udpInstance->udp != SOCKET_INVALID )
+                {
+                    close(udpInstance->udp);
+                }
+                
+                logger_mem_free(udpInstance);
+            }
         }
     }
     else
@@ -134,13 +168,14 @@ LOGGER_STATUS logger_udp_initialize ( LOGGER_INI_SECTIONHANDLE paramBag )
 }
 
 
-LOGGER_STATUS logger_udp_terminate ( void )
+LOGGER_STATUS logger_udp_terminate ( void * instance )
 {
     LOGGER_STATUS status = LOGGER_STATUS_FAILURE;
+    LOGGER_UDP_INSTANCE * udpInstance = (LOGGER_UDP_INSTANCE *)instance;
     
-    if ( f_logger_udp != SOCKET_INVALID )
+    if ( udpInstance != NULL )
     {
-        if ( close(f_logger_udp) != 0 )
+        if ( close(udpInstance->udp) != 0 )
         {
             LOGPRINT_LOG_E("Fail to terminate udp");
         }
@@ -150,7 +185,8 @@ LOGGER_STATUS logger_udp_terminate ( void )
             status = LOGGER_STATUS_OK;
         }
         
-        f_logger_udp = SOCKET_INVALID;
+        pthread_mutex_destroy(&udpInstance->mutex_print);
+        logger_mem_free(udpInstance);
     }
     else
     {
@@ -161,35 +197,72 @@ LOGGER_STATUS logger_udp_terminate ( void )
     return status;
 }
 
-LOGGER_STATUS logger_udp_transmit ( char * msg, size_t msgLen )
+LOGGER_STATUS logger_udp_transmitv ( void * instance, const struct iovec * segments, int segmentCount )
 {
     LOGGER_STATUS status = LOGGER_STATUS_FAILURE_INVALID_MESSAGE;
+    LOGGER_UDP_INSTANCE * udpInstance = (LOGGER_UDP_INSTANCE *)instance;
+    struct msghdr datagram;
+    size_t msgLen = 0U;
     
-    LOGPRINT_ASSERT(f_logger_udp!=SOCKET_INVALID);
-    LOGPRINT_ASSERT(msg!=NULL);
-    LOGPRINT_ASSERT(msgLen!=0U);    
+    LOGPRINT_ASSERT(udpInstance!=NULL);
+    LOGPRINT_ASSERT(segments!=NULL);
     
-    int flags = 0;
-    size_t addrSize = sizeof(f_logger_udp_sockaddr);
+    for ( int i=0; i<segmentCount; i++ )
+    {
+        msgLen += segments[i].iov_len;
+    }
     
-    pthread_mutex_lock( &f_mutex_print );
+    /* one datagram per record, gathered by the kernel */
+    memset(&datagram, 0, sizeof(datagram));
+    datagram.msg_name = &udpInstance->udp_sockaddr;
+    datagram.msg_namelen = (socklen_t)sizeof(udpInstance->udp_sockaddr);
+    datagram.msg_iov = (struct iovec *)segments;
+    datagram.msg_iovlen = (size_t)segmentCount;
     
-    size_t charsSent = sendto(f_logger_udp, msg, msgLen, flags, (const struct sockaddr *)&f_logger_udp_sockaddr, (socklen_t)addrSize);
+    pthread_mutex_lock( &udpInstance->mutex_print );
     
-    pthread_mutex_unlock( &f_mutex_print );
+    ssize_t charsSent = sendmsg(udpInstance->udp, &datagram, 0);
     
-    if ( charsSent >= msgLen )
+    pthread_mutex_unlock( &udpInstance->mutex_print );
+    
+    if ( ( charsSent >= 0 ) && ( (size_t)charsSent >= msgLen ) )
     {
         status = LOGGER_STATUS_OK;
     }
     else
     {
-        LOGPRINT_LOG_E("Failed to send whole message. Only %d/%d sent",charsSent,msgLen);
+        LOGPRINT_LOG_E("Failed to send whole message. Only %d/%u sent",(int)charsSent,(unsigned)msgLen);
     }
     
     return status;
 }
 
+LOGGER_STATUS logger_udp_crashv ( void * instance, const struct iovec * segments, int segmentCount )
+{
+    LOGGER_UDP_INSTANCE * udpInstance = (LOGGER_UDP_INSTANCE *)instance;
+    struct msghdr datagram;
+    
+    if ( udpInstance == NULL )
+    {
+        return LOGGER_STATUS_FAILURE;
+    }
+    
+    /* nothing is buffered, each record is its own datagram */
+    if ( segmentCount == 0 )
+    {
+        return LOGGER_STATUS_OK;
+    }
+    
+    /* sendmsg is async-signal-safe & each datagram is whole, so no mutex */
+    memset(&datagram, 0, sizeof(datagram));
+    datagram.msg_name = &udpInstance->udp_sockaddr;
+    datagram.msg_namelen = (socklen_t)sizeof(udpInstance->udp_sockaddr);
+    datagram.msg_iov = (struct iovec *)segments;
+    datagram.msg_iovlen = (size_t)segmentCount;
+    
+    return ( sendmsg(udpInstance->udp, &datagram, 0) >= 0 ) ? LOGGER_STATUS_OK : LOGGER_STATUS_FAILURE;
+}
+
 char * logger_udp_name ( void )
 {
     return "udp";
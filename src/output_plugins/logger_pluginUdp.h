@@ -23,9 +23,10 @@ extern "C" {
 #include "logger_ini.h"
 
 
-LOGGER_STATUS logger_udp_initialize ( LOGGER_INI_SECTIONHANDLE paramBag );
-LOGGER_STATUS logger_udp_terminate ( void );
-LOGGER_STATUS logger_udp_transmit ( char * msg, size_t msgLen );
+LOGGER_STATUS logger_udp_initialize ( LOGGER_INI_SECTIONHANDLE paramBag, void ** instance );
+LOGGER_STATUS logger_udp_terminate ( void * instance );
+LOGGER_STATUS logger_udp_transmitv ( void * instance, const struct iovec * segments, int segmentCount );
+LOGGER_STATUS logger_udp_crashv ( void * instance, const struct iovec * segments, int segmentCount );
 char * logger_udp_name ( void );
     
     
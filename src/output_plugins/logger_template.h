@@ -18,32 +18,61 @@ extern "C" {
 #endif
 
 
+#include <sys/uio.h>
+
 #include "logger_common.h"
 #include "logger_ini.h"
 
 
 /**
- @brief initialization of debug output. Must set up any prerequisites to printing at the moment this is called
+ @def LOGGER_TEMPLATE_SEGMENTS_MAX
+ @brief most segments passed to a #LOGGER_TEMPLATE_SENDV in one call
+ */
+#define LOGGER_TEMPLATE_SEGMENTS_MAX (8)
+
+
+/**
+ @brief initialization of one debug output. Must set up any prerequisites to printing at the moment this is called
+ @details called once per [output=...] section naming the plugin, so a plugin may have several instances running.
+ Each keeps its state & lock in the context it allocates, instances never serialise on each other
  @param[in] parambag specified within each plugin header as LOGGER_PRINT_INIT_\#pluginname
+ @param[out] instance context passed back to every other call for this output, NULL on failure
  @return LOGGER_STATUS_OK on success
  */
-typedef LOGGER_STATUS (*LOGGER_TEMPLATE_INIT)( LOGGER_INI_SECTIONHANDLE paramBag );
+typedef LOGGER_STATUS (*LOGGER_TEMPLATE_INIT)( LOGGER_INI_SECTIONHANDLE paramBag, void ** instance );
 
 
 /**
  @brief terminate debug output & destroy any connections established at initialization
+ @param[in] instance context from #LOGGER_TEMPLATE_INIT, freed here
+ @return LOGGER_STATUS_OK on success
+ */
+typedef LOGGER_STATUS (*LOGGER_TEMPLATE_TERM)( void * instance );
+
+
+/**
+ @brief print one record to output, given as the segments it is made of
+ @details the segments joined in order are the record without a line terminator. They point at shared & static
+ text (cached timestamp, callsite header) so must not be modified or kept after returning
+ @param[in] instance context from #LOGGER_TEMPLATE_INIT
+ @param[in] segments record segments in output order
+ @param[in] segmentCount number of segments, at most #LOGGER_TEMPLATE_SEGMENTS_MAX
  @return LOGGER_STATUS_OK on success
  */
-typedef LOGGER_STATUS (*LOGGER_TEMPLATE_TERM)(void);
+typedef LOGGER_STATUS (*LOGGER_TEMPLATE_SENDV)( void * instance, const struct iovec * segments, int segmentCount );
 
 
 /**
- @brief print message to output
- @param[in] msg string to print
- @param[in] msgLen number of characters in msg
+ @brief print one record from a signal handler while the process is crashing, optional
+ @details only async-signal-safe calls may be made: no locks, no allocation & no stdio. The record may interleave
+ with a send that was interrupted by the signal. With no segments there is no record, only write out
+ anything the plugin still buffers
+ @param[in] instance context from #LOGGER_TEMPLATE_INIT
+ @param[in] segments record segments in output order
+ @param[in] segmentCount number of segments, at most #LOGGER_TEMPLATE_SEGMENTS_MAX
  @return LOGGER_STATUS_OK on success
  */
-typedef LOGGER_STATUS (*LOGGER_TEMPLATE_SEND)( char * msg, size_t msgLen );
+typedef LOGGER_STATUS (*LOGGER_TEMPLATE_CRASHV)( void * instance, const struct iovec * segments, int segmentCount );
 
 
 /**
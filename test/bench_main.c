@@ -0,0 +1,215 @@
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright (c) 2011  Ryan Powell                                       *
+ * Proprietary & Confidential                                            *
+ * This file & associated documentation may not be used                  *
+ * without the consent of the authors permission.                        *
+ * Undocumented use this material shall be an infringement of copyright. *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "loggerFacade.h"
+#include "logger_messageAssemble.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC
+#endif
+
+
+#define BENCH_ITERATIONS (200000U)
+#define BENCH_WARMUP (10000U)
+
+
+static LOGGER_OUTPUT_HANDLE _loggerHandle = LOGGER_OUTPUT_HANDLE_INVALID;
+
+
+static uint64_t bench_nowNs ( void )
+{
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t bench_nowCycles ( void )
+{
+#ifdef BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0U;
+#endif
+}
+
+static void bench_message ( const char * name, const char * msg )
+{
+    for ( uint32_t i=0U; i<BENCH_WARMUP; i++ )
+    {
+        LOGGER_INFO("%s", msg);
+    }
+    
+    uint64_t startNs = bench_nowNs();
+    uint64_t startCycles = bench_nowCycles();
+    
+    for ( uint32_t i=0U; i<BENCH_ITERATIONS; i++ )
+    {
+        LOGGER_INFO("%s", msg);
+    }
+    
+    uint64_t cycles = bench_nowCycles() - startCycles;
+    uint64_t ns = bench_nowNs() - startNs;
+    
+    fprintf(stdout, "%-8s %5zu chars: %8.1f ns/msg %8.1f cycles/msg\n", name, strlen(msg),
+            (double)ns / BENCH_ITERATIONS, (double)cycles / BENCH_ITERATIONS);
+}
+
+/* a structured record against the printf record carrying the same values */
+static void bench_fields ( void )
+{
+    for ( uint32_t i=0U; i<BENCH_WARMUP; i++ )
+    {
+        LOGGER_FIELDS(LOGGER_LEVEL_INFO, "request", LOGGER_KV_UINT("id", i), LOGGER_KV_INT("status", 200), LOGGER_KV_STR("path", "/index"));
+    }
+    
+    uint64_t startNs = bench_nowNs();
+    uint64_t startCycles = bench_nowCycles();
+    
+    for ( uint32_t i=0U; i<BENCH_ITERATIONS; i++ )
+    {
+        LOGGER_FIELDS(LOGGER_LEVEL_INFO, "request", LOGGER_KV_UINT("id", i), LOGGER_KV_INT("status", 200), LOGGER_KV_STR("path", "/index"));
+    }
+    
+    uint64_t cycles = bench_nowCycles() - startCycles;
+    uint64_t ns = bench_nowNs() - startNs;
+    
+    fprintf(stdout, "%-8s %5u fields: %7.1f ns/msg %8.1f cycles/msg\n", "fields", 3U,
+            (double)ns / BENCH_ITERATIONS, (double)cycles / BENCH_ITERATIONS);
+    
+    startNs = bench_nowNs();
+    startCycles = bench_nowCycles();
+    
+    for ( uint32_t i=0U; i<BENCH_ITERATIONS; i++ )
+    {
+        LOGGER_INFO("request id=%u status=%d path=%s", i, 200, "/index");
+    }
+    
+    cycles = bench_nowCycles() - startCycles;
+    ns = bench_nowNs() - startNs;
+    
+    fprintf(stdout, "%-8s %5u fields: %7.1f ns/msg %8.1f cycles/msg\n", "printf", 3U,
+            (double)ns / BENCH_ITERATIONS, (double)cycles / BENCH_ITERATIONS);
+}
+
+/* the timestamp & header fields alone, as rendered for a record of a callsite without a cached header */
+static void bench_header ( void )
+{
+    char buffer[LOGGER_MAX_LOGGER_CHARS];
+    char timestamp[LOGGER_TIMESTAMP_SIZE];
+    LOGGER_RECORD_BUILDER builder;
+    LOGGER_TICKS ticks = logger_clock_now();
+    LOGGER_TICKS step = logger_clock_ticksFromNs(1000000U);
+    size_t chars = 0U;
+    
+    uint64_t startNs = bench_nowNs();
+    uint64_t startCycles = bench_nowCycles();
+    
+    for ( uint32_t i=0U; i<BENCH_ITERATIONS; i++ )
+    {
+        /* a millisecond apart, so the cached text moves on a second every thousand records */
+        chars += loggerTimeStringFromTicks(ticks + (step * i), timestamp, sizeof(timestamp));
+        
+        logger_record_begin(&builder, buffer, sizeof(buffer));
+        logger_record_appendHeader(&builder, __FILE__, __LINE__, __FUNCTION__, LOGGER_LEVEL_INFO);
+        chars += logger_record_end(&builder);
+    }
+    
+    uint64_t cycles = bench_nowCycles() - startCycles;
+    uint64_t ns = bench_nowNs() - startNs;
+    
+    fprintf(stdout, "%-8s %5zu chars: %8.1f ns/msg %8.1f cycles/msg\n", "header", chars / BENCH_ITERATIONS,
+            (double)ns / BENCH_ITERATIONS, (double)cycles / BENCH_ITERATIONS);
+}
+
+static void bench_stats ( void )
+{
+    LOGGER_STATS stats;
+    uint64_t records = 0U;
+    uint64_t bytes = 0U;
+    uint64_t calls = 0U;
+    uint64_t seen = 0U;
+    uint32_t median = 0U;
+    
+    loggerGetStats(&stats);
+    
+    for ( uint32_t i=0U; i<LOGGER_STATS_LEVELS; i++ )
+    {
+        records += stats.records[i];
+    }
+    
+    for ( uint32_t i=0U; i<stats.outputCount; i++ )
+    {
+        bytes += stats.outputs[i].bytes;
+    }
+    
+    for ( uint32_t i=0U; i<LOGGER_STATS_LATENCY_BUCKETS; i++ )
+    {
+        calls += stats.latency[i];
+    }
+    
+    while ( ( median < LOGGER_STATS_LATENCY_BUCKETS ) && ( ( seen += stats.latency[median] ) * 2U < calls ) )
+    {
+        median++;
+    }
+    
+    fprintf(stdout, "stats    records %llu filtered %llu bytes %llu",
+            (unsigned long long)records, (unsigned long long)stats.filtered,
+            (unsigned long long)bytes);
+    
+    /* the histogram is only kept with latency=true */
+    if ( calls != 0U )
+    {
+        fprintf(stdout, " median < %llu ns",1ULL << ( median+1U ));
+    }
+    
+    fprintf(stdout, "\n");
+    
+    fprintf(stdout, "memory   heap %zu config %zu scratch %zu peak %zu bytes\n",
+            stats.memory.heapBytes, stats.memory.configBytes, stats.memory.scratchBytes, stats.memory.peakBytes);
+}
+
+int main(int argc, const char * argv[])
+{
+    if ( argc != 2 )
+    {
+        fprintf(stderr, "Must be called with ini file to load (%u)\n",argc);
+        return 1;
+    }
+    
+    char *inifile = (char*)argv[1];
+    char longMsg[901];
+    
+    memset(longMsg, 'x', sizeof(longMsg)-1U);
+    longMsg[sizeof(longMsg)-1U] = '\0';
+    
+    loggerLoadIniFile(inifile, (uint32_t)strlen(inifile));
+    
+    LOGGER_INIT;
+    
+    bench_message("short", "request 42 completed");
+    bench_message("long", longMsg);
+    bench_header();
+    bench_fields();
+    
+    bench_stats();
+    
+    LOGGER_TERM;
+    
+    return 0;
+}
@@ -0,0 +1,2 @@
+gcc -std=c99 -O2 bench_main.c ../src/logger_stringUtil.c ../src/logger.c ../src/logger_ini.c ../src/logger_initTerm.c ../src/logger_levelManagement.c ../src/logger_messageAssemble.c ../src/logger_ring.c ../src/logger_binary.c ../src/logger_clock.c ../src/logger_callsite.c ../src/logger_dedup.c ../src/logger_format.c ../src/logger_memory.c ../src/logger_fields.c ../src/logger_metrics.c ../src/logger_backpressure.c ../src/logger_crash.c ../src/logger_registry.c ../src/logger_iniWatch.c ../src/output_plugins/logger_pluginFile.c ../src/output_plugins/logger_pluginStdout.c ../src/output_plugins/logger_pluginUdp.c ../src/output_plugins/logger_pluginStream.c -I . -I ../inc -I ../src -I ../src/output_plugins -o logger_bench
+./logger_bench ${PWD}/bench_ini.ini
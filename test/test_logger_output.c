@@ -8,7 +8,19 @@
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 
+/* fork, waitpid, mkstemp */
+#define _POSIX_C_SOURCE 200809L
+
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <wchar.h>
+#include <sys/wait.h>
 #include "test_logger_output.h"
 #include "loggerFacade.h"
 
@@ -18,10 +30,26 @@ bool test_assertion_null ( void );
 bool test_assertion_equals ( void );
 bool test_assertion_less_greater_than ( void );
 bool test_logger_output ( void );
+bool test_logger_rateLimit ( void );
+bool test_logger_dedup ( void );
+bool test_logger_fields ( void );
+bool test_logger_backpressure ( void );
+bool test_logger_flightRecorder ( void );
+bool test_logger_crashFlush ( void );
+bool test_logger_reload ( void );
+bool test_logger_callsiteControl ( void );
+bool test_logger_fanOut ( void );
+bool test_logger_routing ( void );
+bool test_logger_outputFields ( void );
+bool test_logger_binding ( void );
+bool test_logger_binaryFormats ( void );
 
 
 #define LOGGER_MSG "!!! MSG: hello world :MSG !!!"
 
+/* enough that the writer thread is still behind when the child aborts */
+#define CRASH_TAIL_COUNT (20000)
+
 static LOGGER_OUTPUT_HANDLE _loggerHandle = LOGGER_OUTPUT_HANDLE_INVALID;
 
 
@@ -221,6 +249,968 @@ bool test_logger_enableChange ( void )
     return test_userVerifiedOutput();
 }
 
+
+/* true when a line of the file at path holds text */
+static bool test_logger_fileContains ( const char * path, const char * text )
+{
+    char line[256];
+    bool found = false;
+    
+    FILE *file = fopen(path, "r");
+    
+    while ( ( file != NULL ) && ( fgets(line, sizeof(line), file) != NULL ) )
+    {
+        if ( strstr(line, text) != NULL )
+        {
+            found = true;
+        }
+    }
+    
+    if ( file != NULL )
+    {
+        fclose(file);
+    }
+    
+    return found;
+}
+
+/* create an empty temp file from pathTemplate, which is rewritten with its name */
+static bool test_logger_tempFile ( char * pathTemplate )
+{
+    int fd = mkstemp(pathTemplate);
+    
+    if ( fd < 0 )
+    {
+        printf("could not create temp file %s\n",pathTemplate);
+        return false;
+    }
+    
+    close(fd);
+    
+    return true;
+}
+
+/* settings of test_ini.ini, restarted on to drain & close a test's outputs */
+#define TEST_LOGGER_DEFAULT_INI "[output=stdout]\n"
+
+/* ini the logger was last restarted on. Read at load so already removed, the name is kept for tests that save it again */
+static char f_iniPath[64];
+
+/* restart the logger on iniText instead of the current settings */
+static bool test_logger_restartWithIni ( const char * iniText )
+{
+    snprintf(f_iniPath, sizeof(f_iniPath), "/tmp/logger_test_ini_XXXXXX");
+    
+    if ( test_logger_tempFile(f_iniPath) == false )
+    {
+        return false;
+    }
+    
+    FILE *ini = fopen(f_iniPath, "w");
+    fputs(iniText, ini);
+    fclose(ini);
+    
+    LOGGER_TERM;
+    loggerLoadIniFile(f_iniPath, strlen(f_iniPath));
+    LOGGER_INIT;
+    
+    unlink(f_iniPath);
+    
+    return true;
+}
+
+/* one rate limited callsite, 3 records per 100ms */
+static void test_logger_limitedLine ( int i )
+{
+    LOGGER_LIMITED(LOGGER_LEVEL_INFO, 3, 100, "limited line %d", i);
+}
+
+bool test_logger_rateLimit ( void )
+{
+    char outputPath[] = "/tmp/logger_rate_out_XXXXXX";
+    char iniText[256];
+    LOGGER_STATS before;
+    LOGGER_STATS after;
+    
+    if ( test_logger_tempFile(outputPath) == false )
+    {
+        return false;
+    }
+    
+    snprintf(iniText, sizeof(iniText), "[output=file]\noutput=%s\n", outputPath);
+    
+    bool passed = test_logger_restartWithIni(iniText);
+    
+    loggerGetStats(&before);
+    
+    /* a burst empties the bucket, the next record after it refills reports what was held back */
+    for ( int i=0; passed && ( i<10 ); i++ )
+    {
+        test_logger_limitedLine(i);
+    }
+    
+    nanosleep(&(struct timespec){ 0, 150000000L }, NULL);
+    test_logger_limitedLine(10);
+    
+    passed = test_logger_restartWithIni(TEST_LOGGER_DEFAULT_INI) && passed;
+    
+    loggerGetStats(&after);
+    
+    if ( passed && ( after.rateLimited - before.rateLimited != 7U ) )
+    {
+        printf("expected 7 records rate limited, counted %u\n",(unsigned)(after.rateLimited - before.rateLimited));
+        passed = false;
+    }
+    
+    if ( passed && ( ( test_logger_fileContains(outputPath, "limited line 2") == false ) ||
+                     ( test_logger_fileContains(outputPath, "limited line 3") ) ||
+                     ( test_logger_fileContains(outputPath, "suppressed 7 messages") == false ) ||
+                     ( test_logger_fileContains(outputPath, "limited line 10") == false ) ) )
+    {
+        printf("rate limited records or their summary wrong in the file output\n");
+        passed = false;
+    }
+    
+    unlink(outputPath);
+    
+    return passed;
+}
+
+/* the one callsite test_logger_dedup repeats */
+static void test_logger_dedupLine ( void )
+{
+    LOGGER_INFO("dedup line");
+}
+
+bool test_logger_dedup ( void )
+{
+    char syncPath[] = "/tmp/logger_dedup_sync_XXXXXX";
+    char asyncPath[] = "/tmp/logger_dedup_async_XXXXXX";
+    char iniText[256];
+    LOGGER_STATS before;
+    LOGGER_STATS after;
+    
+    if ( ( test_logger_tempFile(syncPath) == false ) || ( test_logger_tempFile(asyncPath) == false ) )
+    {
+        unlink(syncPath);
+        return false;
+    }
+    
+    snprintf(iniText, sizeof(iniText), "[output=file]\noutput=%s\ndedup=true\n", syncPath);
+    
+    bool passed = test_logger_restartWithIni(iniText);
+    
+    loggerGetStats(&before);
+    
+    /* the count is written ahead of the next different record */
+    for ( int i=0; passed && ( i<5 ); i++ )
+    {
+        test_logger_dedupLine();
+    }
+    
+    LOGGER_INFO("dedup other line");
+    
+    /* held by the writer this time, with nothing printed after it the timeout writes the count */
+    snprintf(iniText, sizeof(iniText), "[output=file]\noutput=%s\nasync=true\ndedup=true\ndedup_timeout=50\n", asyncPath);
+    
+    passed = test_logger_restartWithIni(iniText) && passed;
+    
+    loggerGetStats(&after);
+    
+    for ( int i=0; passed && ( i<3 ); i++ )
+    {
+        test_logger_dedupLine();
+    }
+    
+    for ( int i=0; ( i<100 ) && ( test_logger_fileContains(asyncPath, "last message repeated 2 times") == false ); i++ )
+    {
+        nanosleep(&(struct timespec){ 0, 10000000L }, NULL);
+    }
+    
+    bool expired = test_logger_fileContains(asyncPath, "last message repeated 2 times");
+    
+    passed = test_logger_restartWithIni(TEST_LOGGER_DEFAULT_INI) && passed;
+    
+    if ( passed && ( after.deduplicated - before.deduplicated != 4U ) )
+    {
+        printf("expected 4 records deduplicated, counted %u\n",(unsigned)(after.deduplicated - before.deduplicated));
+        passed = false;
+    }
+    
+    if ( passed && ( ( test_logger_fileContains(syncPath, "dedup line") == false ) ||
+                     ( test_logger_fileContains(syncPath, "last message repeated 4 times") == false ) ||
+                     ( test_logger_fileContains(syncPath, "dedup other line") == false ) ) )
+    {
+        printf("repeats not collapsed into a summary in the file output\n");
+        passed = false;
+    }
+    
+    if ( passed && ( expired == false ) )
+    {
+        printf("repeat count held by the writer not written after dedup_timeout\n");
+        passed = false;
+    }
+    
+    unlink(syncPath);
+    unlink(asyncPath);
+    
+    return passed;
+}
+
+/* true when the file at path holds the bytes anywhere, for output that is not lines of text */
+static bool test_logger_fileHoldsBytes ( const char * path, const char * bytes, size_t bytesLen )
+{
+    char content[4096];
+    size_t contentLen = 0U;
+    
+    FILE *file = fopen(path, "rb");
+    
+    if ( file != NULL )
+    {
+        contentLen = fread(content, 1U, sizeof(content), file);
+        fclose(file);
+    }
+    
+    for ( size_t i=0U; i+bytesLen <= contentLen; i++ )
+    {
+        if ( memcmp(&content[i], bytes, bytesLen) == 0 )
+        {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+/* answer=42 path=/tmp, printed once per fields= rendering */
+static void test_logger_kvLine ( void )
+{
+    LOGGER_FIELDS(LOGGER_LEVEL_INFO, "kv record", LOGGER_KV_INT("answer", 42), LOGGER_KV_STR("path", "/tmp"));
+}
+
+bool test_logger_fields ( void )
+{
+    char textPath[] = "/tmp/logger_kv_text_XXXXXX";
+    char jsonPath[] = "/tmp/logger_kv_json_XXXXXX";
+    char binaryPath[] = "/tmp/logger_kv_binary_XXXXXX";
+    char iniText[256];
+    LOGGER_STATS before;
+    LOGGER_STATS after;
+    /* marker, 4 byte little endian length, then INT answer zigzag 42 & STR path */
+    const char encoded[] = "kv record\x1e\x14\x00\x00\x00\x01\x06" "answer\x54\x05\x04" "path\x04/tmp";
+    
+    if ( ( test_logger_tempFile(textPath) == false ) || ( test_logger_tempFile(jsonPath) == false ) ||
+         ( test_logger_tempFile(binaryPath) == false ) )
+    {
+        unlink(textPath);
+        unlink(jsonPath);
+        return false;
+    }
+    
+    loggerGetStats(&before);
+    
+    /* inline, then stored behind binary capture, then from the writer queue */
+    snprintf(iniText, sizeof(iniText), "[output=file]\noutput=%s\nfields=text\n", textPath);
+    bool passed = test_logger_restartWithIni(iniText);
+    test_logger_kvLine();
+    
+    snprintf(iniText, sizeof(iniText), "[output=file]\noutput=%s\nfields=json\nbinary=true\n", jsonPath);
+    passed = test_logger_restartWithIni(iniText) && passed;
+    test_logger_kvLine();
+    
+    snprintf(iniText, sizeof(iniText), "[output=file]\noutput=%s\nfields=binary\nasync=true\n", binaryPath);
+    passed = test_logger_restartWithIni(iniText) && passed;
+    test_logger_kvLine();
+    
+    passed = test_logger_restartWithIni(TEST_LOGGER_DEFAULT_INI) && passed;
+    
+    loggerGetStats(&after);
+    
+    if ( passed && ( after.records[__builtin_ctz(LOGGER_LEVEL_INFO)] - before.records[__builtin_ctz(LOGGER_LEVEL_INFO)] != 3U ) )
+    {
+        printf("expected 3 fielded records counted\n");
+        passed = false;
+    }
+    
+    if ( passed && ( ( test_logger_fileContains(textPath, "|kv record answer=42 path=/tmp") == false ) ||
+                     ( test_logger_fileContains(jsonPath, "|kv record {\"answer\":42,\"path\":\"/tmp\"}") == false ) ||
+                     ( test_logger_fileHoldsBytes(binaryPath, encoded, sizeof(encoded)-1U) == false ) ) )
+    {
+        printf("fields not rendered as text, json & binary\n");
+        passed = false;
+    }
+    
+    unlink(textPath);
+    unlink(jsonPath);
+    unlink(binaryPath);
+    
+    return passed;
+}
+
+/* one record of test_logger_backpressure's burst, every hundredth an error that may not be dropped */
+static void test_logger_burstLine ( int index )
+{
+    if ( ( index % 100 ) == 0 )
+    {
+        LOGGER_ERROR("burst error %d", index/100);
+    }
+    else
+    {
+        LOGGER_INFO("burst info %d", index);
+    }
+}
+
+bool test_logger_backpressure ( void )
+{
+    char outputPath[] = "/tmp/logger_drop_out_XXXXXX";
+    char keepPath[] = "/tmp/logger_drop_keep_XXXXXX";
+    char iniText[256];
+    char expected[32];
+    LOGGER_STATS before;
+    LOGGER_STATS after;
+    
+    if ( ( test_logger_tempFile(outputPath) == false ) || ( test_logger_tempFile(keepPath) == false ) )
+    {
+        unlink(outputPath);
+        return false;
+    }
+    
+    /* queues far smaller than the burst, the senders cannot keep up. Only the first output drops */
+    snprintf(iniText, sizeof(iniText), "[output=file]\noutput=%s\nqueue=8\nbackpressure=drop_newest\n[output=file]\noutput=%s\nqueue=8\n",
+             outputPath, keepPath);
+    
+    bool passed = test_logger_restartWithIni(iniText);
+    
+    loggerGetStats(&before);
+    
+    for ( int i=0; passed && ( i<4000 ); i++ )
+    {
+        test_logger_burstLine(i);
+    }
+    
+    passed = test_logger_restartWithIni(TEST_LOGGER_DEFAULT_INI) && passed;
+    
+    loggerGetStats(&after);
+    
+    if ( passed && ( after.dropped == before.dropped ) )
+    {
+        printf("expected records dropped from the burst\n");
+        passed = false;
+    }
+    
+    if ( passed && ( test_logger_fileContains(outputPath, " records dropped") == false ) )
+    {
+        printf("no dropped records note in the file output\n");
+        passed = false;
+    }
+    
+    for ( int i=0; passed && ( i<40 ); i++ )
+    {
+        snprintf(expected, sizeof(expected), "burst error %d\n", i);
+        
+        if ( test_logger_fileContains(outputPath, expected) == false )
+        {
+            printf("error record %d dropped\n", i);
+            passed = false;
+        }
+    }
+    
+    if ( passed && ( ( test_logger_fileContains(keepPath, " records dropped") ) ||
+                     ( test_logger_fileContains(keepPath, "burst info 3999\n") == false ) ) )
+    {
+        printf("blocking output dropped records of the other output's backpressure\n");
+        passed = false;
+    }
+    
+    unlink(outputPath);
+    unlink(keepPath);
+    
+    return passed;
+}
+
+bool test_logger_flightRecorder ( void )
+{
+    char outputPath[] = "/tmp/logger_recorder_out_XXXXXX";
+    char iniText[256];
+    LOGGER_STATS before;
+    LOGGER_STATS after;
+    
+    if ( test_logger_tempFile(outputPath) == false )
+    {
+        return false;
+    }
+    
+    /* the recorder keeps warnings & errors from this file, not its info or events */
+    snprintf(iniText, sizeof(iniText), "[output=file]\noutput=%s\nrecorder=16\n[capture]\ntest_logger_output.c=ew\n", outputPath);
+    
+    bool passed = test_logger_restartWithIni(iniText);
+    
+    loggerGetStats(&before);
+    
+    LOGGER_INFO("masked info");
+    LOGGER_WARN("recorded warning");
+    LOGGER_EVENT("masked event");
+    LOGGER_ERROR("recorded error");
+    
+    uint32_t dumped = loggerDumpFlightRecorder();
+    
+    /* a second dump only has what was recorded since the first */
+    LOGGER_ERROR("recorded again");
+    
+    uint32_t dumpedAgain = loggerDumpFlightRecorder();
+    
+    passed = test_logger_restartWithIni(TEST_LOGGER_DEFAULT_INI) && passed;
+    
+    loggerGetStats(&after);
+    
+    if ( passed && ( ( dumped != 2U ) || ( dumpedAgain != 1U ) ) )
+    {
+        printf("expected 2 then 1 records dumped, got %u then %u\n", dumped, dumpedAgain);
+        passed = false;
+    }
+    
+    if ( passed && ( after.records[__builtin_ctz(LOGGER_LEVEL_ERROR)] - before.records[__builtin_ctz(LOGGER_LEVEL_ERROR)] != 2U ) )
+    {
+        printf("expected a dump to leave the error count alone\n");
+        passed = false;
+    }
+    
+    if ( passed && ( ( test_logger_fileContains(outputPath, "flight recorder: 2 records") == false ) ||
+                     ( test_logger_fileContains(outputPath, "flight recorder: end of 2 records") == false ) ||
+                     ( test_logger_fileContains(outputPath, "flight recorder: 1 records") == false ) ) )
+    {
+        printf("flight recorder notes missing from the file output\n");
+        passed = false;
+    }
+    
+    unlink(outputPath);
+    
+    return passed;
+}
+
+bool test_logger_crashFlush ( void )
+{
+    char outputPath[] = "/tmp/logger_crash_out_XXXXXX";
+    char iniText[256];
+    char lastRecord[64];
+    int status = 0;
+    
+    if ( test_logger_tempFile(outputPath) == false )
+    {
+        return false;
+    }
+    
+    snprintf(iniText, sizeof(iniText), "[output=file]\noutput=%s\nasync=true\nbinary=true\ncrash_flush=true\n", outputPath);
+    
+    printf("crash flush: child aborts with records still queued\n");
+    fflush(stdout);
+    
+    pid_t child = fork();
+    
+    if ( child == 0 )
+    {
+        /* the child writes to its own file, nothing reaches it before the writer thread catches up */
+        test_logger_restartWithIni(iniText);
+        
+        for ( int i=0; i<CRASH_TAIL_COUNT; i++ )
+        {
+            LOGGER_INFO("crash tail %d", i);
+        }
+        
+        abort();
+    }
+    
+    waitpid(child, &status, 0);
+    
+    snprintf(lastRecord, sizeof(lastRecord), "crash tail %d", CRASH_TAIL_COUNT-1);
+    
+    bool foundLast = test_logger_fileContains(outputPath, lastRecord);
+    
+    unlink(outputPath);
+    
+    if ( ( WIFSIGNALED(status) == false ) || ( WTERMSIG(status) != SIGABRT ) )
+    {
+        printf("child did not die from SIGABRT (%d)\n",status);
+        return false;
+    }
+    
+    if ( foundLast == false )
+    {
+        printf("'%s' missing from output\n",lastRecord);
+    }
+    
+    return foundLast;
+}
+
+/* levels of this file's handle given by %s, the output watching the ini */
+#define TEST_LOGGER_OVERRIDES_INI "[output=stdout]\nini_watch=true\n[overrides]\ntest_logger_output.c=%s\n"
+
+/* levels of this file's handle, as [overrides] in the ini at path */
+static void test_logger_writeOverrides ( const char * path, const char * levels )
+{
+    char tempPath[256];
+    
+    /* renamed over the old file, the way editors save */
+    snprintf(tempPath, sizeof(tempPath), "%s.new", path);
+    
+    FILE *ini = fopen(tempPath, "w");
+    fprintf(ini, TEST_LOGGER_OVERRIDES_INI, levels);
+    fclose(ini);
+    
+    rename(tempPath, path);
+}
+
+bool test_logger_reload ( void )
+{
+    char iniText[256];
+    bool passed = true;
+    
+    /* restarted so the output picks up ini_watch */
+    snprintf(iniText, sizeof(iniText), TEST_LOGGER_OVERRIDES_INI, "e");
+    
+    if ( test_logger_restartWithIni(iniText) == false )
+    {
+        return false;
+    }
+    
+    if ( ( loggerIsDebugLevelEnabled(_loggerHandle, LOGGER_LEVEL_ERROR) == false ) ||
+         ( loggerIsDebugLevelEnabled(_loggerHandle, LOGGER_LEVEL_INFO) ) )
+    {
+        printf("levels from the loaded ini not applied\n");
+        passed = false;
+    }
+    
+    test_logger_writeOverrides(f_iniPath, "ei");
+    
+    if ( passed && ( ( loggerReloadIniFile() == false ) || ( loggerIsDebugLevelEnabled(_loggerHandle, LOGGER_LEVEL_INFO) == false ) ) )
+    {
+        printf("levels from the reloaded ini not applied\n");
+        passed = false;
+    }
+    
+    /* the watcher thread reloads it this time */
+    test_logger_writeOverrides(f_iniPath, "w");
+    
+    for ( int i=0; ( i<100 ) && loggerIsDebugLevelEnabled(_loggerHandle, LOGGER_LEVEL_INFO); i++ )
+    {
+        nanosleep(&(struct timespec){ 0, 50000000L }, NULL);
+    }
+    
+    if ( passed && ( ( loggerIsDebugLevelEnabled(_loggerHandle, LOGGER_LEVEL_INFO) ) ||
+                     ( loggerIsDebugLevelEnabled(_loggerHandle, LOGGER_LEVEL_WARN) == false ) ) )
+    {
+        printf("levels from the watched ini not applied\n");
+        passed = false;
+    }
+    
+    unlink(f_iniPath);
+    
+    return passed;
+}
+
+
+/* the one callsite test_logger_callsiteControl switches */
+static void test_logger_noisyLine ( void )
+{
+    LOGGER_INFO("noisy line");
+}
+
+/* never printed before test_logger_callsiteControl selects it by format */
+static void test_logger_quietLine ( void )
+{
+    LOGGER_INFO("quiet line %d", 1);
+}
+
+/* INFO records printed so far */
+static uint64_t test_logger_infoRecords ( void )
+{
+    LOGGER_STATS stats;
+    
+    loggerGetStats(&stats);
+    
+    return stats.records[__builtin_ctz(LOGGER_LEVEL_INFO)];
+}
+
+bool test_logger_callsiteControl ( void )
+{
+    bool passed = true;
+    
+    LOGGER_DISABLE_TYPE(LOGGER_LEVEL_INFO);
+    
+    /* found before it has ever printed */
+    uint32_t matched = loggerControlCallsites("func=test_logger_noisy* level=i", LOGGER_CALLSITE_ENABLED);
+    uint64_t before = test_logger_infoRecords();
+    
+    printf("callsite enabled with INFO off. Output expected\n");
+    test_logger_noisyLine();
+    
+    if ( ( matched != 1U ) || ( test_logger_infoRecords() != before+1U ) )
+    {
+        printf("callsite not enabled (matched %u)\n",matched);
+        passed = false;
+    }
+    
+    loggerControlCallsites("file=test_logger_output.c func=test_logger_noisyLine", LOGGER_CALLSITE_DEFAULT);
+    test_logger_noisyLine();
+    
+    /* the format is known before the first print */
+    matched = loggerControlCallsites("format=quiet*", LOGGER_CALLSITE_ENABLED);
+    before = test_logger_infoRecords();
+    
+    printf("callsite enabled by format with INFO off. Output expected\n");
+    test_logger_quietLine();
+    
+    if ( ( matched != 1U ) || ( test_logger_infoRecords() != before+1U ) )
+    {
+        printf("callsite not enabled by format (matched %u)\n",matched);
+        passed = false;
+    }
+    
+    loggerControlCallsites("format=quiet*", LOGGER_CALLSITE_DEFAULT);
+    
+    LOGGER_ENABLE_TYPE(LOGGER_LEVEL_INFO);
+    
+    matched = loggerControlCallsites("format=noisy*", LOGGER_CALLSITE_DISABLED);
+    before = test_logger_infoRecords();
+    test_logger_noisyLine();
+    
+    if ( ( matched != 1U ) || ( test_logger_infoRecords() != before ) )
+    {
+        printf("callsite not disabled (matched %u)\n",matched);
+        passed = false;
+    }
+    
+    if ( loggerControlCallsites("line=12", LOGGER_CALLSITE_ENABLED) != 0U )
+    {
+        printf("bad match term accepted\n");
+        passed = false;
+    }
+    
+    loggerControlCallsites("", LOGGER_CALLSITE_DEFAULT);
+    
+    return passed;
+}
+
+bool test_logger_fanOut ( void )
+{
+    char outputPath[] = "/tmp/logger_fan_out_XXXXXX";
+    char iniText[256];
+    bool passed = true;
+    LOGGER_STATS stats;
+    
+    if ( test_logger_tempFile(outputPath) == false )
+    {
+        return false;
+    }
+    
+    /* each output behind its own queue, print calls timed */
+    snprintf(iniText, sizeof(iniText), "[output=file]\noutput=%s\nasync=true\nlatency=true\n[output=stdout]\n", outputPath);
+    
+    if ( test_logger_restartWithIni(iniText) == false )
+    {
+        unlink(outputPath);
+        return false;
+    }
+    
+    printf("fan out: record expected on stdout & in the file\n");
+    LOGGER_INFO("fan out record");
+    
+    /* term drains the queues before the stats & file are read */
+    LOGGER_TERM;
+    
+    loggerGetStats(&stats);
+    
+    if ( ( stats.outputCount != 2U ) || ( stats.outputs[0].records == 0U ) || ( stats.outputs[1].records == 0U ) )
+    {
+        printf("record not sent to both outputs\n");
+        passed = false;
+    }
+    
+    uint64_t timedCalls = 0U;
+    
+    for ( uint32_t i=0U; i<LOGGER_STATS_LATENCY_BUCKETS; i++ )
+    {
+        timedCalls += stats.latency[i];
+    }
+    
+    if ( passed && ( timedCalls == 0U ) )
+    {
+        printf("latency=true did not time the print call\n");
+        passed = false;
+    }
+    
+    if ( passed && ( test_logger_fileContains(outputPath, "fan out record") == false ) )
+    {
+        printf("record missing from the file output\n");
+        passed = false;
+    }
+    
+    /* the basename is longer than LOGGER_FILENAME_SIZE, still written whole */
+    if ( passed && ( test_logger_fileContains(outputPath, "|test_logger_output.c|") == false ) )
+    {
+        printf("file name cut short in the record header\n");
+        passed = false;
+    }
+    
+    LOGGER_INIT;
+    
+    unlink(outputPath);
+    
+    return passed;
+}
+
+bool test_logger_routing ( void )
+{
+    char outputPath[] = "/tmp/logger_route_out_XXXXXX";
+    char iniText[256];
+    bool passed = true;
+    LOGGER_STATS before;
+    LOGGER_STATS after;
+    
+    if ( test_logger_tempFile(outputPath) == false )
+    {
+        return false;
+    }
+    
+    /* errors only to the file, everything to stdout */
+    snprintf(iniText, sizeof(iniText), "[output=file]\noutput=%s\nlevels=e\n[output=stdout]\n", outputPath);
+    
+    if ( test_logger_restartWithIni(iniText) == false )
+    {
+        unlink(outputPath);
+        return false;
+    }
+    
+    /* counts run on from earlier outputs at the same index */
+    loggerGetStats(&before);
+    
+    printf("routing: info & error records expected on stdout, only the error in the file\n");
+    LOGGER_INFO("routed info record");
+    LOGGER_ERROR("routed error record");
+    
+    LOGGER_TERM;
+    
+    loggerGetStats(&after);
+    
+    if ( ( after.outputs[0].records - before.outputs[0].records != 1U ) ||
+         ( after.outputs[1].records - before.outputs[1].records != 2U ) )
+    {
+        printf("records not routed by level\n");
+        passed = false;
+    }
+    
+    if ( passed && ( ( test_logger_fileContains(outputPath, "routed error record") == false ) ||
+                     ( test_logger_fileContains(outputPath, "routed info record") ) ) )
+    {
+        printf("file output holds the wrong records\n");
+        passed = false;
+    }
+    
+    LOGGER_INIT;
+    
+    unlink(outputPath);
+    
+    return passed;
+}
+
+bool test_logger_outputFields ( void )
+{
+    char jsonPath[] = "/tmp/logger_out_json_XXXXXX";
+    char textPath[] = "/tmp/logger_out_text_XXXXXX";
+    char iniText[256];
+    
+    if ( ( test_logger_tempFile(jsonPath) == false ) || ( test_logger_tempFile(textPath) == false ) )
+    {
+        unlink(jsonPath);
+        return false;
+    }
+    
+    /* each output renders fields as its own section says, dedup= of the second is ignored */
+    snprintf(iniText, sizeof(iniText), "[output=file]\noutput=%s\nfields=json\n[output=file]\noutput=%s\nfields=text\ndedup=true\n",
+             jsonPath, textPath);
+    
+    bool passed = test_logger_restartWithIni(iniText);
+    test_logger_kvLine();
+    test_logger_kvLine();
+    
+    passed = test_logger_restartWithIni(TEST_LOGGER_DEFAULT_INI) && passed;
+    
+    if ( passed && ( ( test_logger_fileContains(jsonPath, "|kv record {\"answer\":42,\"path\":\"/tmp\"}") == false ) ||
+                     ( test_logger_fileContains(textPath, "|kv record answer=42 path=/tmp") == false ) ||
+                     ( test_logger_fileContains(textPath, "repeated") ) ) )
+    {
+        printf("outputs did not keep their own section settings\n");
+        passed = false;
+    }
+    
+    unlink(jsonPath);
+    unlink(textPath);
+    
+    return passed;
+}
+
+bool test_logger_binding ( void )
+{
+    char mainPath[] = "/tmp/logger_bind_main_XXXXXX";
+    char auditPath[] = "/tmp/logger_bind_audit_XXXXXX";
+    char iniText[256];
+    bool passed = true;
+    
+    if ( ( test_logger_tempFile(mainPath) == false ) || ( test_logger_tempFile(auditPath) == false ) )
+    {
+        unlink(mainPath);
+        return false;
+    }
+    
+    /* two instances of the file plugin, this file's handle bound to the named one */
+    snprintf(iniText, sizeof(iniText), "[output=file]\noutput=%s\n[output=file]\nname=audit\noutput=%s\n[bindings]\ntest_logger_output.c=audit\n",
+             mainPath, auditPath);
+    
+    if ( test_logger_restartWithIni(iniText) == false )
+    {
+        unlink(mainPath);
+        unlink(auditPath);
+        return false;
+    }
+    
+    LOGGER_INFO("bound record");
+    
+    if ( ( loggerBindOutput(_loggerHandle, "no such output") ) || ( loggerBindOutput(_loggerHandle, NULL) == false ) )
+    {
+        printf("binding to a missing output accepted or unbinding failed\n");
+        passed = false;
+    }
+    
+    LOGGER_INFO("unbound record");
+    
+    LOGGER_TERM;
+    
+    if ( passed && ( ( test_logger_fileContains(auditPath, "bound record") == false ) ||
+                     ( test_logger_fileContains(auditPath, "unbound record") ) ||
+                     ( test_logger_fileContains(mainPath, "unbound record") == false ) ||
+                     ( test_logger_fileContains(mainPath, "|bound record") ) ) )
+    {
+        printf("records not sent to the outputs their handle was bound to\n");
+        passed = false;
+    }
+    
+    LOGGER_INIT;
+    
+    unlink(mainPath);
+    unlink(auditPath);
+    
+    return passed;
+}
+
+/* every case of test_logger_binaryFormats, as PRINT(format, args...) */
+#define TEST_LOGGER_FORMAT_TABLE(PRINT) \
+    PRINT("length hh %hhd %hhu %hhx", (signed char)-5, (unsigned char)250, 0x1ff) \
+    PRINT("length h %hd %hu", (short)-300, (unsigned short)65000) \
+    PRINT("length l %ld %lu %lx", -70000L, 70000UL, 0xdeadbeefUL) \
+    PRINT("length ll %lld %llu %llX", -1099511627776LL, 18446744073709551615ULL, 0xabcdefULL) \
+    PRINT("length j z t %jd %zu %td", (intmax_t)-9, (size_t)42, (ptrdiff_t)-3) \
+    PRINT("flags %#o %#x %+d % d %05d %-4d|", 8, 255, 3, 3, 42, 7) \
+    PRINT("star width [%*d] [%-*d] [%*s]", 6, 42, 6, 42, -8, "left") \
+    PRINT("star precision %.*f %.*s", 2, 3.14159, 3, "abcdef") \
+    PRINT("negative star precision %.*s", -1, "whole") \
+    PRINT("star both [%*.*f]", 10, 3, 2.5) \
+    PRINT("percent 100%% %d%%", 5) \
+    PRINT("pointer %p", (void *)0x1234) \
+    PRINT("long double %Lf %.3Le %Lg", 1.5L, 2.25L, 1e-5L) \
+    PRINT("null string [%s] [%.2s] [%10s]", f_nullString, f_nullString, f_nullString) \
+    PRINT("unterminated %.3s %.*s", f_unterminated, 2, f_unterminated) \
+    PRINT("unsupported %ls %lc %d", L"wide", (wint_t)L'w', 9) \
+    PRINT("mixed %s=%d %c %5.1f%% %e", "key", 7, 'x', 99.5, 1234.5)
+
+#define TEST_LOGGER_PRINT_FORMAT(format, ...) LOGGER_INFO(format, __VA_ARGS__);
+#define TEST_LOGGER_COUNT_FORMAT(format, ...) +1U
+
+/* arguments the compiler would warn about given as literals */
+static const char * f_nullString = NULL;
+static const char f_unterminated[3] = { 'a', 'b', 'c' };
+
+/* one record per table row, each from its own literal format so binary capture can defer it */
+static void test_logger_printFormats ( void )
+{
+    TEST_LOGGER_FORMAT_TABLE(TEST_LOGGER_PRINT_FORMAT)
+}
+
+/* print the table to a file output set up by iniFormat, which takes the file's path. Written out by the next restart */
+static bool test_logger_printFormatsTo ( const char * iniFormat, char * outputPath )
+{
+    char iniText[256];
+    
+    if ( test_logger_tempFile(outputPath) == false )
+    {
+        return false;
+    }
+    
+    snprintf(iniText, sizeof(iniText), iniFormat, outputPath);
+    
+    if ( test_logger_restartWithIni(iniText) == false )
+    {
+        return false;
+    }
+    
+    test_logger_printFormats();
+    
+    return true;
+}
+
+bool test_logger_binaryFormats ( void )
+{
+    char syncPath[] = "/tmp/logger_fmt_sync_XXXXXX";
+    char binaryPath[] = "/tmp/logger_fmt_binary_XXXXXX";
+    char syncLine[512];
+    char binaryLine[512];
+    uint32_t lineCount = 0U;
+    const uint32_t formatCount = 0U TEST_LOGGER_FORMAT_TABLE(TEST_LOGGER_COUNT_FORMAT);
+    bool passed = test_logger_printFormatsTo("[output=file]\noutput=%s\n", syncPath) &&
+                  test_logger_printFormatsTo("[output=file]\noutput=%s\nbinary=true\n", binaryPath);
+    
+    /* back to stdout & no writer thread, as test_ini.ini, for the tests that follow */
+    passed = test_logger_restartWithIni(TEST_LOGGER_DEFAULT_INI) && passed;
+    
+    FILE *syncFile = fopen(syncPath, "r");
+    FILE *binaryFile = fopen(binaryPath, "r");
+    
+    while ( passed && ( syncFile != NULL ) && ( binaryFile != NULL ) && ( fgets(syncLine, sizeof(syncLine), syncFile) != NULL ) )
+    {
+        /* the timestamps differ, the rest is the same callsite & message */
+        const char * syncRecord = strchr(syncLine, '|');
+        const char * binaryRecord = ( fgets(binaryLine, sizeof(binaryLine), binaryFile) != NULL ) ? strchr(binaryLine, '|') : NULL;
+        
+        if ( ( syncRecord == NULL ) || ( binaryRecord == NULL ) || ( strcmp(syncRecord, binaryRecord) != 0 ) )
+        {
+            printf("binary output differs\n sync:   %s binary: %s\n",syncLine,( binaryRecord != NULL ) ? binaryLine : "(missing)\n");
+            passed = false;
+        }
+        
+        lineCount += 1U;
+    }
+    
+    if ( passed && ( ( lineCount != formatCount ) || ( fgets(binaryLine, sizeof(binaryLine), binaryFile) != NULL ) ) )
+    {
+        printf("expected %u records from each output, got %u\n",formatCount,lineCount);
+        passed = false;
+    }
+    
+    if ( syncFile != NULL )
+    {
+        fclose(syncFile);
+    }
+    
+    if ( binaryFile != NULL )
+    {
+        fclose(binaryFile);
+    }
+    
+    unlink(syncPath);
+    unlink(binaryPath);
+    
+    return passed;
+}
+
 bool test_logger ( void )
 {
 	bool testPass = false;
@@ -248,6 +1238,58 @@ bool test_logger ( void )
     else if (test_logger_enableChange() == false)
     {
 		printf("test_logger_enableChange() failed\n");
+    }
+    else if (test_logger_rateLimit() == false)
+    {
+		printf("test_logger_rateLimit() failed\n");
+    }
+    else if (test_logger_dedup() == false)
+    {
+		printf("test_logger_dedup() failed\n");
+    }
+    else if (test_logger_fields() == false)
+    {
+		printf("test_logger_fields() failed\n");
+    }
+    else if (test_logger_backpressure() == false)
+    {
+		printf("test_logger_backpressure() failed\n");
+    }
+    else if (test_logger_flightRecorder() == false)
+    {
+		printf("test_logger_flightRecorder() failed\n");
+    }
+    else if (test_logger_crashFlush() == false)
+    {
+		printf("test_logger_crashFlush() failed\n");
+    }
+    else if (test_logger_reload() == false)
+    {
+		printf("test_logger_reload() failed\n");
+    }
+    else if (test_logger_callsiteControl() == false)
+    {
+		printf("test_logger_callsiteControl() failed\n");
+    }
+    else if (test_logger_fanOut() == false)
+    {
+		printf("test_logger_fanOut() failed\n");
+    }
+    else if (test_logger_routing() == false)
+    {
+		printf("test_logger_routing() failed\n");
+    }
+    else if (test_logger_outputFields() == false)
+    {
+		printf("test_logger_outputFields() failed\n");
+    }
+    else if (test_logger_binding() == false)
+    {
+		printf("test_logger_binding() failed\n");
+    }
+    else if (test_logger_binaryFormats() == false)
+    {
+		printf("test_logger_binaryFormats() failed\n");
     }
 	else
 	{